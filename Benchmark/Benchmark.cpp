@@ -0,0 +1,4250 @@
+//
+// Benchmark.cpp - Headless tools and benchmarks for the experiment, runnable without a GPU
+//
+// Build (Linux): g++ -std=c++17 -O2 -pthread -I"../PPM Experiment" Benchmark.cpp "../PPM Experiment/Participant.cpp" "../PPM Experiment/TrialOrder.cpp" "../PPM Experiment/ImageCache.cpp" "../PPM Experiment/Ppm.cpp" "../PPM Experiment/DiskCache.cpp" "../PPM Experiment/Preloader.cpp" "../PPM Experiment/Arena.cpp" "../PPM Experiment/PixelPipeline.cpp" "../PPM Experiment/UploadRing.cpp" "../PPM Experiment/UploadScheduler.cpp" "../PPM Experiment/CpuRenderer.cpp" "../PPM Experiment/SpriteBatcher.cpp" "../PPM Experiment/RenderGraph.cpp" "../PPM Experiment/PresentScheduler.cpp" "../PPM Experiment/RenderThread.cpp" "../PPM Experiment/Trace.cpp" "../PPM Experiment/MemoryAccounting.cpp" "../PPM Experiment/TrialMonitor.cpp" "../PPM Experiment/Scene.cpp" "../PPM Experiment/Capture.cpp" "../PPM Experiment/Watchdog.cpp" "../PPM Experiment/SessionLog.cpp" "../PPM Experiment/Log.cpp" -o benchmark
+//
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "Arena.h"
+#include "Capture.h"
+#include "CpuRenderer.h"
+#include "DiskCache.h"
+#include "ImageCache.h"
+#include "ImageView.h"
+#include "Log.h"
+#include "MemoryAccounting.h"
+#include "Participant.h"
+#include "PixelPipeline.h"
+#include "Ppm.h"
+#include "Preloader.h"
+#include "PresentScheduler.h"
+#include "RenderGraph.h"
+#include "RenderThread.h"
+#include "Scene.h"
+#include "SessionLog.h"
+#include "SpriteBatcher.h"
+#include "SpscQueue.h"
+#include "Trace.h"
+#include "TrialMonitor.h"
+#include "TrialOrder.h"
+#include "UploadRing.h"
+#include "UploadScheduler.h"
+#include "Watchdog.h"
+
+/// Every heap allocation of the process, counted to compare allocation strategies
+static std::atomic<std::size_t> g_allocations{ 0 };
+
+// Kept out of line, so that the compiler does not see malloc in a new-expression and free in a delete-expression and warn that
+// they are mismatched. The array and nothrow forms call these; the aligned forms are replaced too, so that over-aligned
+// allocations are counted as well
+__attribute__((noinline)) void* operator new(const std::size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (auto* p = std::malloc(size == 0 ? 1 : size)) return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	// aligned_alloc takes a multiple of the alignment
+	const auto align = static_cast<std::size_t>(alignment);
+	if (auto* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	/// Creates a 16-bit PPM of a gradient, so that every row differs
+	Experiment::Frame SyntheticFrame(const int width, const int height)
+	{
+		auto buffer = std::make_shared<std::vector<std::uint16_t>>(static_cast<std::size_t>(width) * height * 4);
+
+		Experiment::Frame frame = {};
+		frame.width = width;
+		frame.height = height;
+		frame.stride = static_cast<std::size_t>(width) * frame.PixelBytes();
+		frame.data = reinterpret_cast<std::uint8_t*>(buffer->data());
+		frame.owner = buffer;
+
+		for (auto y = 0; y < height; y++)
+		{
+			auto* row = reinterpret_cast<std::uint16_t*>(frame.Row(y));
+			for (auto x = 0; x < width; x++)
+			{
+				row[x * 4 + 0] = static_cast<std::uint16_t>(x * 17);
+				row[x * 4 + 1] = static_cast<std::uint16_t>(y * 29);
+				row[x * 4 + 2] = static_cast<std::uint16_t>((x + y) * 7);
+				row[x * 4 + 3] = 0xFFFF;
+			}
+		}
+
+		return frame;
+	}
+
+	/// The minor and major page faults of the process so far
+	long PageFaults()
+	{
+		rusage usage = {};
+		getrusage(RUSAGE_SELF, &usage);
+
+		return usage.ru_minflt + usage.ru_majflt;
+	}
+
+	/// Reads one byte of every page of `frame`, as an upload would, and returns their sum
+	std::uint64_t Touch(const Experiment::Frame& frame)
+	{
+		std::uint64_t sum = 0;
+		for (std::size_t i = 0; i < frame.Bytes(); i += 4096)
+		{
+			sum += frame.data[i];
+		}
+
+		return sum;
+	}
+
+	/// Reports the expected I/O savings of reordering the trials of a session file. Without one, checks the counterbalancing of
+	/// synthetic sessions: a balanced one never repeats a side more than allowed, and one whose trials are mostly of one side,
+	/// which cannot keep to the limit, has every trial over it counted in the report, and a seed yields a known order
+	int Order(int argc, char** argv)
+	{
+		if (argc > 0)
+		{
+			auto run = Experiment::Run::CreateRun(argv[0]);
+
+			Experiment::TrialOrder::Constraints constraints = {};
+			if (argc > 1) constraints.cacheFrames = std::stoul(argv[1]);
+			if (argc > 2) constraints.maxSameSideRun = std::stoi(argv[2]);
+
+			const auto report = Experiment::TrialOrder::Apply(run, constraints);
+			std::cout << report << std::endl;
+
+			return 0;
+		}
+
+		using Experiment::Option;
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		// `trials` trials, four to an original, the first `left` of every `per` of them with the correct side on the left
+		const auto session = [](const int trials, const int left, const int per)
+		{
+			Experiment::Run run;
+			run.participant.id = "order";
+
+			for (auto i = 0; i < trials; i++)
+			{
+				Experiment::Trial trial;
+				trial.originalDirectory = "original";
+				trial.decompressedDirectory = "decompressed" + std::to_string(i % 3);
+				trial.imageName = "image" + std::to_string(i / 4);
+				trial.correctOption = i % per < left ? Option::Left : Option::Right;
+				run.trials.push_back(trial);
+			}
+
+			return run;
+		};
+
+		// the longest run of one side, counted independently of the report
+		const auto longestRun = [](const Experiment::Run& run, std::size_t& over, const int limit)
+		{
+			auto longest = 0, current = 0;
+			auto last = Option::None;
+			over = 0;
+
+			for (const auto& trial : run.trials)
+			{
+				current = trial.correctOption == last ? current + 1 : 1;
+				last = trial.correctOption;
+				longest = std::max(longest, current);
+				if (current > limit) over++;
+			}
+
+			return longest;
+		};
+
+		const Experiment::TrialOrder::Constraints constraints = {};
+
+		{
+			auto run = session(200, 1, 2);
+			const auto report = Experiment::TrialOrder::Apply(run, constraints);
+
+			std::size_t over = 0;
+			const auto longest = longestRun(run, over, constraints.maxSameSideRun);
+
+			std::cout << "balanced: " << report << ", longest run: " << longest << std::endl;
+			check(longest <= constraints.maxSameSideRun && report.sideRunViolations == 0, "a balanced session keeps to the same side limit");
+		}
+
+		{
+			// five left trials for each right one cannot all keep to runs of three
+			auto run = session(120, 5, 6);
+			const auto report = Experiment::TrialOrder::Apply(run, constraints);
+
+			std::size_t over = 0;
+			const auto longest = longestRun(run, over, constraints.maxSameSideRun);
+
+			std::cout << "one sided: " << report << ", longest run: " << longest << std::endl;
+			check(over > 0 && report.sideRunViolations == over, "the trials over the same side limit are counted in the report");
+			check(run.trials.size() == 120, "every trial is kept");
+		}
+
+		{
+			// the order of a seed is fixed by the algorithm, not by the standard library that built it, so that a session can be
+			// reproduced on any machine
+			Experiment::TrialOrder::Constraints seeded = {};
+			seeded.seed = 1;
+
+			const auto order = Experiment::TrialOrder::Optimize(session(12, 1, 2).trials, seeded);
+			check(order == std::vector<std::size_t>{ 6, 5, 7, 4, 9, 10, 8, 11, 1, 0, 3, 2 }, "a seed yields the same order with any compiler");
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Hammers the decoded image cache from several threads and checks that every file is decoded once while it fits the budget
+	int Cache(int argc, char** argv)
+	{
+		const auto threads = argc > 0 ? std::stoi(argv[0]) : 8;
+		const auto files = argc > 1 ? std::stoi(argv[1]) : 16;
+		const auto budgetFrames = argc > 2 ? std::stoi(argv[2]) : files;
+		const auto requests = 1000;
+
+		constexpr auto width = 1200, height = 1000;
+		constexpr std::size_t frameBytes = width * height * 8;
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-cache";
+		std::filesystem::create_directories(directory);
+
+		std::vector<std::filesystem::path> paths;
+		for (auto i = 0; i < files; i++)
+		{
+			paths.push_back(directory / ("frame" + std::to_string(i) + ".ppm"));
+			std::ofstream(paths.back()) << i;
+		}
+
+		Experiment::ImageCache cache(budgetFrames * frameBytes);
+		std::atomic<int> loads{ 0 };
+
+		const auto load = [&](const std::filesystem::path&)
+		{
+			loads++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+			auto buffer = std::make_shared<std::vector<std::uint8_t>>(frameBytes);
+
+			Experiment::Frame frame = {};
+			frame.width = width;
+			frame.height = height;
+			frame.stride = width * frame.PixelBytes();
+			frame.data = buffer->data();
+			frame.owner = buffer;
+
+			return frame;
+		};
+
+		std::vector<std::thread> workers;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (auto t = 0; t < threads; t++)
+		{
+			workers.emplace_back([&, t]()
+			{
+				std::mt19937 random(t);
+				std::uniform_int_distribution<int> pick(0, files - 1);
+
+				for (auto i = 0; i < requests; i++)
+				{
+					const auto frame = cache.Get(paths[pick(random)], load);
+					if (frame->width != width) std::abort();
+				}
+			});
+		}
+
+		for (auto& worker : workers) worker.join();
+
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		const auto statistics = cache.GetStatistics();
+
+		std::cout << "ImageCache: " << statistics << ", loads: " << loads << ", " << elapsed << " ms" << std::endl;
+		std::filesystem::remove_all(directory);
+
+		if (budgetFrames >= files && loads != files)
+		{
+			std::cerr << "expected " << files << " loads" << std::endl;
+			return 1;
+		}
+
+		return statistics.hits + statistics.misses == static_cast<std::size_t>(threads * requests) ? 0 : 1;
+	}
+
+	/// Compares the startup cost of decoding a set of PPMs (first session) with mapping them from the stimulus cache (next sessions),
+	/// checks that a cache over its budget evicts the entries used least recently, and that stores from more threads than the
+	/// queue holds are all written when they wait for room
+	int StimulusCache(int argc, char** argv)
+	{
+		const auto files = argc > 0 ? std::stoi(argv[0]) : 8;
+		const auto width = argc > 1 ? std::stoi(argv[1]) : 3840;
+		const auto height = argc > 2 ? std::stoi(argv[2]) : 2160;
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-stimuli";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory / "images");
+
+		std::vector<std::filesystem::path> paths;
+		for (auto i = 0; i < files; i++)
+		{
+			paths.push_back(directory / "images" / ("image" + std::to_string(i) + "_L.ppm"));
+			Experiment::Ppm::Write(paths.back(), SyntheticFrame(width, height));
+		}
+
+		std::uint64_t coldSum = 0, warmSum = 0;
+		double coldMs = 0, warmMs = 0;
+
+		{
+			Experiment::DiskCache cache(directory / "cache", Experiment::Configuration::StimulusCacheBytes);
+			const auto start = std::chrono::steady_clock::now();
+
+			for (const auto& path : paths)
+			{
+				const auto identity = Experiment::FileIdentity::Of(path);
+				const auto frame = Experiment::Ppm::Read(path);
+
+				coldSum += Touch(frame);
+				cache.Store(identity, frame);
+
+				// the first session pays for the writes as well, in the background; waiting for each also keeps every store
+				cache.Flush();
+			}
+
+			coldMs = Milliseconds(std::chrono::steady_clock::now() - start).count();
+		}
+
+		{
+			Experiment::DiskCache cache(directory / "cache", Experiment::Configuration::StimulusCacheBytes);
+			const auto start = std::chrono::steady_clock::now();
+
+			for (const auto& path : paths)
+			{
+				const auto frame = cache.Load(Experiment::FileIdentity::Of(path));
+				if (!frame)
+				{
+					std::cerr << path << " was not cached" << std::endl;
+					return 1;
+				}
+
+				warmSum += Touch(*frame);
+			}
+
+			warmMs = Milliseconds(std::chrono::steady_clock::now() - start).count();
+			std::cout << "DiskCache: " << cache.GetStatistics() << std::endl;
+		}
+
+		// a budget of two and a half entries keeps the two mapped last, and evicts the rest when the cache is opened
+		if (files > 2)
+		{
+			const auto entryBytes = std::size_t(4096) + static_cast<std::size_t>(width) * height * 8;
+			Experiment::DiskCache cache(directory / "cache", 2 * entryBytes + entryBytes / 2);
+
+			const auto evicted = cache.GetStatistics().evicted;
+			const auto has = [&](const std::filesystem::path& path) { return cache.Load(Experiment::FileIdentity::Of(path)).has_value(); };
+
+			if (evicted != static_cast<std::size_t>(files - 2) || has(paths[0]) || !has(paths[files - 2]) || !has(paths[files - 1]))
+			{
+				std::cerr << "the least recently used entries are not evicted beyond the budget: " << cache.GetStatistics() << std::endl;
+				return 1;
+			}
+		}
+
+		// more decoding threads than queued stores, as the preloader runs, each waiting for room; every store is written and the
+		// cache is kept within the budget as it grows
+		if (files > 2)
+		{
+			const auto entryBytes = std::size_t(4096) + static_cast<std::size_t>(width) * height * 8;
+			Experiment::DiskCache cache(directory / "preload", 2 * entryBytes + entryBytes / 2);
+
+			std::atomic<int> next{ 0 };
+			std::vector<std::thread> threads;
+			for (std::size_t t = 0; t < 2 * Experiment::DiskCache::MaxQueuedStores; t++)
+			{
+				threads.emplace_back([&]
+					{
+						for (auto i = next++; i < files; i = next++)
+						{
+							const auto frame = Experiment::Ppm::Read(paths[i]);
+							cache.Store(Experiment::FileIdentity::Of(paths[i]), frame, {}, Experiment::DiskCache::WhenFull::Wait);
+						}
+					});
+			}
+
+			for (auto& thread : threads) thread.join();
+			cache.Flush();
+
+			const auto statistics = cache.GetStatistics();
+			const auto entries = std::distance(std::filesystem::directory_iterator(directory / "preload"), std::filesystem::directory_iterator());
+
+			std::cout << "DiskCache (" << threads.size() << " threads storing): " << statistics << std::endl;
+
+			if (statistics.stores != static_cast<std::size_t>(files) || statistics.skipped != 0 || statistics.evicted != static_cast<std::size_t>(files - 2) || entries != 2)
+			{
+				std::cerr << "stores waiting for room are not all written, or the cache grows beyond its budget" << std::endl;
+				return 1;
+			}
+		}
+
+		std::filesystem::remove_all(directory);
+
+		std::cout << "cold (decode + store): " << coldMs / files << " ms/frame, "
+			<< "warm (map): " << warmMs / files << " ms/frame, "
+			<< "speedup: " << coldMs / warmMs << "x" << std::endl;
+
+		return coldSum == warmSum ? 0 : 1;
+	}
+
+	/// Loads the four stimuli of each trial of a synthetic session without caching through Ppm::Read, as the experiment streams
+	/// them, reading each file either into a new buffer or into a decode scratch arena as Controller::DecodeFrame does
+	int TrialArena(int argc, char** argv)
+	{
+		const auto trials = argc > 0 ? std::stoi(argv[0]) : 10;
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-arena";
+		std::filesystem::create_directories(directory);
+
+		const auto path = directory / "image.ppm";
+		Experiment::Ppm::Write(path, SyntheticFrame(3840, 2160));
+
+		struct Result
+		{
+			double milliseconds = 0;
+			std::size_t faults = 0;
+			std::size_t allocations = 0;
+			std::uint64_t sum = 0;
+		};
+
+		const auto load = [&](Experiment::Arena* scratch)
+		{
+			Result result;
+
+			const auto allocations = g_allocations.load();
+			const auto faults = PageFaults();
+			const auto start = std::chrono::steady_clock::now();
+
+			for (auto t = 0; t < trials * 4; t++)
+			{
+				result.sum += Touch(Experiment::Ppm::Read(path, scratch));
+			}
+
+			result.milliseconds = Milliseconds(std::chrono::steady_clock::now() - start).count();
+			result.faults = PageFaults() - faults;
+			result.allocations = g_allocations.load() - allocations;
+			return result;
+		};
+
+		// heap: the file is read into a new buffer for every stimulus
+		const auto heap = load(nullptr);
+
+		// scratch: the file is read into an arena which is rewound after each decode, and whose pages are faulted in by the first
+		// read only; the decoded frame is a new buffer either way, as it outlives the load in the image cache
+		Experiment::Arena scratch(Experiment::Configuration::DecodeScratchBytes, false);
+		const auto arena = load(&scratch);
+		const auto statistics = scratch.GetStatistics();
+
+		std::filesystem::remove_all(directory);
+
+		const auto stimuli = static_cast<double>(trials * 4);
+
+		std::cout << "heap:    " << heap.milliseconds / stimuli << " ms/stimulus, " << heap.faults / stimuli << " page faults/stimulus, "
+			<< heap.allocations / stimuli << " heap allocations/stimulus" << std::endl;
+		std::cout << "scratch: " << arena.milliseconds / stimuli << " ms/stimulus, " << arena.faults / stimuli << " page faults/stimulus, "
+			<< arena.allocations / stimuli << " heap allocations/stimulus, " << statistics.highWater / (1024 * 1024) << " MB of scratch used, "
+			<< statistics.overflows << " overflows, " << (statistics.hugePages ? "huge pages" : "regular pages") << std::endl;
+
+		const auto ok = heap.sum == arena.sum && statistics.overflows == 0 && statistics.used == 0 && arena.allocations < heap.allocations;
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+
+		return ok ? 0 : 1;
+	}
+
+	/// Preloads the crops of a synthetic session of `trials` trials over `images` distinct 4K images, as the experiment does before starting
+	int Preload(int argc, char** argv)
+	{
+		const auto trials = argc > 0 ? std::stoi(argv[0]) : 50;
+		const auto images = argc > 1 ? std::stoi(argv[1]) : 8;
+		const auto threads = argc > 2 ? static_cast<unsigned>(std::stoi(argv[2])) : std::thread::hardware_concurrency();
+
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-preload";
+		std::filesystem::create_directories(directory);
+
+		std::vector<std::filesystem::path> paths;
+		for (auto i = 0; i < images; i++)
+		{
+			paths.push_back(directory / ("image" + std::to_string(i) + ".ppm"));
+			Experiment::Ppm::Write(paths.back(), SyntheticFrame(3840, 2160));
+		}
+
+		const auto stimuli = static_cast<std::size_t>(trials) * 4;
+		const auto bytes = Experiment::Preloader::RequiredBytes(stimuli, dims.x, dims.y);
+
+		std::cout << "session: " << bytes / (1024 * 1024) << " MB, available: " << Experiment::Preloader::AvailableMemory() / (1024 * 1024) << " MB" << std::endl;
+
+		if (!Experiment::Preloader::Fits(bytes, Experiment::Configuration::ImageCacheBytes))
+		{
+			std::cout << "does not fit; the experiment would stream this session" << std::endl;
+			std::filesystem::remove_all(directory);
+			return 0;
+		}
+
+		Experiment::ImageCache cache(Experiment::Configuration::ImageCacheBytes);
+		Experiment::Preloader preloader(stimuli, dims.x, dims.y, [&](const std::size_t index, Experiment::Frame& slot)
+		{
+			const auto frame = cache.Get(paths[(index / 4) % paths.size()], [](const std::filesystem::path& p) { return Experiment::Ppm::Read(p); });
+
+			const auto x = static_cast<int>(index * 97 % (frame->width - slot.width));
+			const auto y = static_cast<int>(index * 31 % (frame->height - slot.height));
+
+			Experiment::CopyPixels(Experiment::ConstRgba16View(*frame).Crop(x, y, slot.width, slot.height), Experiment::Rgba16View(slot));
+		}, threads);
+
+		preloader.Start();
+		preloader.Wait();
+
+		const auto statistics = preloader.GetStatistics();
+		std::filesystem::remove_all(directory);
+
+		std::cout << "preloaded " << statistics.stimuli << " stimuli on " << threads << " threads in " << statistics.milliseconds << " ms ("
+			<< statistics.bytes / (1024.0 * 1024.0) / (statistics.milliseconds / 1000.0) << " MB/s), ImageCache: " << cache.GetStatistics() << std::endl;
+
+		for (std::size_t i = 0; i < stimuli; i++)
+		{
+			if (preloader.Get(i) == nullptr) return 1;
+		}
+
+		return 0;
+	}
+
+	/// Counters of the calling thread from perf_event_open, read around measured regions to tell memory bound kernels from
+	/// compute bound ones. Counters the machine or the kernel does not provide, such as hardware counters in a VM without a
+	/// PMU or anything above perf_event_paranoid, are left out, and their values are empty
+	class PerfCounters
+	{
+	public:
+		enum Counter { Cycles, Instructions, LlcMisses, DtlbMisses, PageFaults, Count };
+
+		using Values = std::array<std::optional<double>, Count>;
+
+		PerfCounters()
+		{
+			constexpr auto readMiss = PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+
+			const std::pair<std::uint32_t, std::uint64_t> events[Count] = {
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+				{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | readMiss },
+				{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | readMiss },
+				{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS } };
+
+			for (auto i = 0; i < Count; i++)
+			{
+				perf_event_attr attr = {};
+				attr.size = sizeof(attr);
+				attr.type = events[i].first;
+				attr.config = events[i].second;
+				attr.disabled = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+				// the kernel's share of a region, such as zeroing the pages it faults in, unless only user space may be counted
+				m_fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+				if (m_fds[i] < 0)
+				{
+					attr.exclude_kernel = 1;
+					m_fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+				}
+			}
+		}
+
+		~PerfCounters()
+		{
+			for (const auto fd : m_fds)
+			{
+				if (fd >= 0) close(fd);
+			}
+		}
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters& operator=(const PerfCounters&) = delete;
+
+		[[nodiscard]] bool IsAvailable(const Counter counter) const { return m_fds[counter] >= 0; }
+
+		static const char* Name(const Counter counter)
+		{
+			static constexpr const char* names[Count] = { "cycles", "instructions", "LLC misses", "dTLB misses", "page faults" };
+			return names[counter];
+		}
+
+		void Start()
+		{
+			for (const auto fd : m_fds)
+			{
+				if (fd < 0) continue;
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+
+		/// The counts since Start, scaled up for the time a counter was multiplexed out
+		Values Stop()
+		{
+			for (const auto fd : m_fds)
+			{
+				if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+
+			Values values;
+			for (auto i = 0; i < Count; i++)
+			{
+				std::uint64_t read[3] = {};
+				if (m_fds[i] < 0 || ::read(m_fds[i], read, sizeof(read)) != sizeof(read)) continue;
+
+				values[i] = read[2] > 0 ? static_cast<double>(read[0]) * static_cast<double>(read[1]) / static_cast<double>(read[2]) : 0.0;
+			}
+
+			return values;
+		}
+
+	private:
+		int m_fds[Count] = {};
+	};
+
+	/// The nearest rank percentile `p` (0 to 100) of `values`, which must not be empty
+	double Percentile(std::vector<double> values, const double p)
+	{
+		std::sort(values.begin(), values.end());
+		const auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * values.size()));
+		return values[std::max<std::size_t>(rank, 1) - 1];
+	}
+
+	/// Checks the image view kernels against a per-pixel reference, and times the crop copy which strided uploads no longer make
+	int Views(int argc, char** argv)
+	{
+		const auto stimuli = argc > 0 ? std::stoi(argv[0]) : 40;
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		auto failures = 0;
+		const auto check = [&](const bool condition, const char* what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				failures++;
+			}
+		};
+
+		// crops share the memory of the image, offset by whole pixels and rows
+		const auto frame = SyntheticFrame(64, 48);
+		const Experiment::ConstRgba16View image(frame);
+		const auto crop = image.Crop(5, 7, 20, 10);
+
+		check(crop.data == image(5, 7) && crop.stride == image.stride && !crop.IsContiguous(), "crop is a view into the image");
+		check(crop(3, 2)[1] == image(8, 9)[1], "crop pixel addressing");
+
+		auto outOfRange = false;
+		try { static_cast<void>(image.Crop(60, 0, 5, 1)); }
+		catch (const std::out_of_range&) { outOfRange = true; }
+		check(outOfRange, "crop outside the image throws");
+
+		// a strided copy matches the pixels it was cropped from
+		std::vector<std::uint16_t> copy(crop.Bytes() / sizeof(std::uint16_t));
+		const Experiment::Rgba16View destination(copy.data(), crop.width, crop.height);
+		Experiment::CopyPixels(crop, destination);
+
+		auto copied = true;
+		for (auto y = 0; y < crop.height; y++)
+			for (auto x = 0; x < crop.width; x++)
+				for (auto c = 0; c < 4; c++)
+					copied &= destination(x, y)[c] == image(5 + x, 7 + y)[c];
+		check(copied, "strided copy");
+
+		// decoding into a crop of a larger frame leaves the pixels around it alone
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-views";
+		std::filesystem::create_directories(directory);
+		Experiment::Ppm::Write(directory / "small.ppm", SyntheticFrame(8, 4));
+
+		std::vector<std::uint16_t> canvas(16 * 8 * 4, 7);
+		const auto file = Experiment::Ppm::ReadFile(directory / "small.ppm");
+		const Experiment::Rgba16View whole(canvas.data(), 16, 8);
+		Experiment::Ppm::Decode(file.data(), file.size(), whole.Crop(4, 2, 8, 4));
+
+		const auto reference = Experiment::Ppm::Read(directory / "small.ppm");
+		check(whole(4, 2)[0] == Experiment::ConstRgba16View(reference)(0, 0)[0] && whole(11, 5)[2] == Experiment::ConstRgba16View(reference)(7, 3)[2], "decode into a crop");
+		check(whole(3, 2)[0] == 7 && whole(12, 5)[0] == 7 && whole(4, 1)[0] == 7 && whole(4, 6)[0] == 7, "decode into a crop stays within it");
+
+		// the copy each stimulus used to make before its upload
+		const auto full = SyntheticFrame(3840, 2160);
+		std::vector<std::uint16_t> stimulus(static_cast<std::size_t>(dims.x) * dims.y * 4);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (auto i = 0; i < stimuli; i++)
+		{
+			const auto region = Experiment::ConstRgba16View(full).Crop(i * 97 % (3840 - dims.x), i * 31 % (2160 - dims.y), dims.x, dims.y);
+			Experiment::CopyPixels(region, Experiment::Rgba16View(stimulus.data(), dims.x, dims.y));
+		}
+		const auto milliseconds = Milliseconds(std::chrono::steady_clock::now() - start).count();
+
+		std::filesystem::remove_all(directory);
+
+		std::cout << (failures == 0 ? "all view checks passed" : "view checks failed") << std::endl;
+		std::cout << "crop copy: " << milliseconds / stimuli << " ms and " << stimulus.size() * sizeof(std::uint16_t) / (1024 * 1024) << " MB per stimulus, saved by strided uploads" << std::endl;
+
+		return failures == 0 ? 0 : 1;
+	}
+
+	/// Runs every specialization of the pixel pipeline over a stimulus sized crop of a 4K source, checking sampled pixels against
+	/// a scalar reference, and compares the fused decode of a crop with decoding the whole image and copying the crop out of it
+	int Pipeline(int argc, char** argv)
+	{
+		using namespace Experiment::Pixels;
+
+		const auto repeats = argc > 0 ? std::stoi(argv[0]) : 10;
+		const auto dims = Experiment::Configuration::ImageDimensions;
+		const auto sourceWidth = 3840, sourceHeight = 2160, x = 1317, y = 611;
+
+		std::mt19937 random(1);
+		std::vector<std::uint8_t> sourceData(static_cast<std::size_t>(sourceWidth) * sourceHeight * 6);
+
+		std::vector<std::uint8_t> destinationData(static_cast<std::size_t>(dims.x) * dims.y * 8);
+
+		const auto halfToFloat = [](const std::uint16_t h)
+		{
+			const auto exponent = (h >> 10) & 0x1F;
+			const auto mantissa = h & 0x3FF;
+			return exponent == 0 ? std::ldexp(static_cast<float>(mantissa), -24) : std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+		};
+
+		auto failures = 0;
+
+		std::cout << "source           order  scaling    destination   ms/stimulus  MB/s" << std::endl;
+
+		for (const auto format : { SourceFormat::Uint8, SourceFormat::Uint16, SourceFormat::Uint16BigEndian })
+		{
+		// random samples up to the maxval, 12 bits for 16-bit formats
+		const auto maxval = format == SourceFormat::Uint8 ? 255 : 4095;
+		for (std::size_t i = 0; i + 1 < sourceData.size(); i += 2)
+		{
+			const auto v = random() % (maxval + 1);
+			if (format == SourceFormat::Uint8) { sourceData[i] = static_cast<std::uint8_t>(v); sourceData[i + 1] = static_cast<std::uint8_t>(random()); }
+			else if (format == SourceFormat::Uint16) { sourceData[i] = static_cast<std::uint8_t>(v); sourceData[i + 1] = static_cast<std::uint8_t>(v >> 8); }
+			else { sourceData[i] = static_cast<std::uint8_t>(v >> 8); sourceData[i + 1] = static_cast<std::uint8_t>(v); }
+		}
+
+		for (const auto order : { ChannelOrder::Rgb, ChannelOrder::Bgr })
+		for (const auto scaling : { Scaling::Keep, Scaling::Normalize })
+		for (const auto target : { DestinationFormat::Rgba16Unorm, DestinationFormat::Rgba16Float, DestinationFormat::R10G10B10A2Unorm })
+		{
+			SourceImage source = {};
+			source.data = sourceData.data();
+			source.width = sourceWidth;
+			source.height = sourceHeight;
+			source.format = format;
+			source.stride = sourceWidth * SourcePixelBytes(format);
+			source.order = order;
+			source.maxval = maxval;
+
+			DestinationImage destination = {};
+			destination.data = destinationData.data();
+			destination.width = dims.x;
+			destination.height = dims.y;
+			destination.format = target;
+			destination.stride = dims.x * DestinationPixelBytes(target);
+
+			const auto start = std::chrono::steady_clock::now();
+			for (auto i = 0; i < repeats; i++)
+			{
+				Convert(source, x, y, destination, scaling);
+			}
+			const auto milliseconds = Milliseconds(std::chrono::steady_clock::now() - start).count() / repeats;
+
+			// the reference, one sample at a time
+			const auto expected = [&](const int px, const int py, const int channel) -> double
+			{
+				const auto c = order == ChannelOrder::Rgb ? channel : 2 - channel;
+				const auto* sample = source.data + source.stride * (y + py) + SourcePixelBytes(format) * (x + px) + c * SourcePixelBytes(format) / 3;
+
+				double v = format == SourceFormat::Uint8 ? sample[0]
+					: format == SourceFormat::Uint16BigEndian ? sample[0] << 8 | sample[1]
+					: sample[0] | sample[1] << 8;
+
+				return scaling == Scaling::Normalize ? std::round(v * 65535.0 / source.maxval) : v;
+			};
+
+			auto correct = true;
+			for (auto i = 0; i < 1000; i++)
+			{
+				const auto px = static_cast<int>(random() % dims.x), py = static_cast<int>(random() % dims.y);
+				const auto* pixel = destination.data + destination.stride * py + DestinationPixelBytes(target) * px;
+
+				for (auto channel = 0; channel < 3; channel++)
+				{
+					const auto want = expected(px, py, channel);
+					std::uint16_t half[4];
+					std::uint32_t packed;
+
+					switch (target)
+					{
+					case DestinationFormat::Rgba16Unorm:
+						std::memcpy(half, pixel, sizeof(half));
+						// 16.16 fixed point normalization of maxvals other than 255 and 65535 may round the other way
+						correct &= std::abs(half[channel] - want) <= (scaling == Scaling::Normalize ? 1 : 0) && half[3] == 0xFFFF;
+						break;
+					case DestinationFormat::Rgba16Float:
+						std::memcpy(half, pixel, sizeof(half));
+						correct &= std::abs(halfToFloat(half[channel]) - want / 65535.0) <= want / 65535.0 / 1024 + 1e-7 && half[3] == 0x3C00;
+						break;
+					case DestinationFormat::R10G10B10A2Unorm:
+						std::memcpy(&packed, pixel, sizeof(packed));
+						correct &= (packed >> (10 * channel) & 0x3FF) == std::round(want * 1023 / 65535) && packed >> 30 == 3;
+						break;
+					}
+				}
+			}
+
+			const char* formats[] = { "8-bit", "16-bit", "16-bit big end" };
+			const char* targets[] = { "RGBA16 UNORM", "RGBA16 FLOAT", "RGB10A2 UNORM" };
+
+			std::cout << std::left << std::setw(17) << formats[static_cast<int>(format)]
+				<< std::setw(7) << (order == ChannelOrder::Rgb ? "RGB" : "BGR")
+				<< std::setw(11) << (scaling == Scaling::Keep ? "keep" : "normalize")
+				<< std::setw(14) << targets[static_cast<int>(target)]
+				<< std::setw(13) << milliseconds
+				<< static_cast<int>(static_cast<double>(dims.x) * dims.y * SourcePixelBytes(format) / (1024 * 1024) / (milliseconds / 1000))
+				<< (correct ? "" : "  MISMATCH") << std::endl;
+
+			failures += correct ? 0 : 1;
+		}
+		}
+
+		// the separate passes this replaces: decode the whole 16-bit PPM, then copy the crop out of it
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-pipeline";
+		std::filesystem::create_directories(directory);
+		Experiment::Ppm::Write(directory / "image.ppm", SyntheticFrame(sourceWidth, sourceHeight));
+		const auto file = Experiment::Ppm::ReadFile(directory / "image.ppm");
+		std::filesystem::remove_all(directory);
+
+		std::vector<std::uint16_t> full(static_cast<std::size_t>(sourceWidth) * sourceHeight * 4);
+		const Experiment::Rgba16View stimulus(reinterpret_cast<std::uint16_t*>(destinationData.data()), dims.x, dims.y);
+
+		auto start = std::chrono::steady_clock::now();
+		for (auto i = 0; i < repeats; i++)
+		{
+			const Experiment::Rgba16View whole(full.data(), sourceWidth, sourceHeight);
+			Experiment::Ppm::Decode(file.data(), file.size(), whole);
+			Experiment::CopyPixels<std::uint16_t, 4>(whole.Crop(x, y, dims.x, dims.y), stimulus);
+		}
+		const auto separate = Milliseconds(std::chrono::steady_clock::now() - start).count() / repeats;
+
+		start = std::chrono::steady_clock::now();
+		for (auto i = 0; i < repeats; i++)
+		{
+			Experiment::Ppm::Decode(file.data(), file.size(), stimulus, x, y);
+		}
+		const auto fused = Milliseconds(std::chrono::steady_clock::now() - start).count() / repeats;
+
+		std::cout << "16-bit PPM stimulus: decode then crop " << separate << " ms, fused decode of the crop " << fused << " ms" << std::endl;
+
+		// PPMs of 8 bits, or of 16 bits below the full range, are brought to the full range rather than displayed darker
+		for (const auto maxval : { 255, 4095 })
+		{
+			const auto path = std::filesystem::temp_directory_path() / "ppm-experiment-maxval.ppm";
+
+			{
+				const int samples[] = { 0, maxval / 2 + 1, maxval };
+				std::ofstream out(path, std::ios::binary);
+				out << "P6\n1 1\n" << maxval << "\n";
+
+				for (const auto sample : samples)
+				{
+					if (maxval > 255) out.put(static_cast<char>(sample >> 8));
+					out.put(static_cast<char>(sample & 0xFF));
+				}
+			}
+
+			const auto frame = Experiment::Ppm::Read(path);
+			const auto* pixel = Experiment::ConstRgba16View(frame).Row(0);
+			std::filesystem::remove(path);
+
+			const auto expected = std::lround((maxval / 2 + 1) * 65535.0 / maxval);
+			const auto correct = pixel[0] == 0 && std::abs(pixel[1] - expected) <= 1 && pixel[2] == 65535 && pixel[3] == 65535;
+
+			std::cout << "PPM of maxval " << maxval << ": " << pixel[0] << ", " << pixel[1] << ", " << pixel[2] << (correct ? "" : "  MISMATCH") << std::endl;
+			failures += correct ? 0 : 1;
+		}
+
+		return failures == 0 ? 0 : 1;
+	}
+
+	/// A GPU without a GPU: copies complete `latency` frames after they are queued, and mapping a slot whose copy is
+	/// still running counts as a stall, as it would block the CPU on a real device. Targets are vectors of RGBA16 stimuli.
+	/// `charge`, if set, is called with the bytes of every copy the CPU makes, to advance a simulated clock
+	class MockUploadDevice final : public Experiment::IUploadDevice
+	{
+	public:
+		/// Copies take at least one frame
+		explicit MockUploadDevice(const std::size_t latency) : m_latency(std::max<std::size_t>(latency, 1)) {}
+
+		void CreateSlots(const std::size_t count, const int width, const int height) override
+		{
+			m_width = width;
+			m_height = height;
+			m_slots.assign(count, std::vector<std::uint8_t>(Pitch() * height));
+			m_completesAt.assign(count, 0);
+			m_copies.assign(count, {});
+		}
+
+		Mapping Map(const std::size_t slot) override
+		{
+			if (m_completesAt[slot] > m_frame) stalls++;
+
+			return { m_slots[slot].data(), Pitch() };
+		}
+
+		void Unmap(std::size_t) override {}
+
+		void CopyToTarget(const std::size_t slot, void* target, const int targetRow, const int rows) override
+		{
+			m_copies[slot] = { static_cast<std::vector<std::uint16_t>*>(target), targetRow, rows };
+			m_completesAt[slot] = m_frame + m_latency;
+
+			if (charge) charge(static_cast<std::size_t>(rows) * m_width * 8);
+		}
+
+		bool IsComplete(const std::size_t slot) override
+		{
+			return m_completesAt[slot] <= m_frame;
+		}
+
+		void Update(void* target, const Experiment::ConstRgba16View source, const int targetRow) override
+		{
+			auto& pixels = *static_cast<std::vector<std::uint16_t>*>(target);
+			Experiment::CopyPixels(source, Experiment::Rgba16View(pixels.data() + static_cast<std::size_t>(targetRow) * source.width * 4, source.width, source.height));
+
+			if (charge) charge(source.Bytes());
+		}
+
+		/// Advances a frame, performing the copies which complete on it
+		void Present()
+		{
+			m_frame++;
+
+			for (std::size_t slot = 0; slot < m_slots.size(); slot++)
+			{
+				auto& copy = m_copies[slot];
+				if (copy.target == nullptr || m_completesAt[slot] != m_frame) continue;
+
+				const Experiment::ConstRgba16View staged(reinterpret_cast<const std::uint16_t*>(m_slots[slot].data()), m_width, copy.rows, Pitch());
+				Experiment::CopyPixels(staged, Experiment::Rgba16View(copy.target->data() + static_cast<std::size_t>(copy.targetRow) * m_width * 4, m_width, copy.rows));
+				copy.target = nullptr;
+			}
+		}
+
+		std::size_t stalls = 0;
+		std::function<void(std::size_t bytes)> charge;
+
+	private:
+		/// A row pitch wider than the row, as drivers may use
+		[[nodiscard]] std::size_t Pitch() const { return static_cast<std::size_t>(m_width) * 8 + 16; }
+
+		std::size_t m_latency;
+		std::size_t m_frame = 0;
+		int m_width = 0;
+		int m_height = 0;
+
+		std::vector<std::vector<std::uint8_t>> m_slots;
+		struct Copy
+		{
+			std::vector<std::uint16_t>* target = nullptr;
+			int targetRow = 0;
+			int rows = 0;
+		};
+
+		std::vector<std::size_t> m_completesAt;
+		std::vector<Copy> m_copies;
+	};
+
+	/// Drives the upload ring with a mock device through a session of trial switches and bursts larger than the ring,
+	/// and checks that every texture receives its pixels and that no upload waits on the GPU
+	int Upload(int argc, char** argv)
+	{
+		const auto trials = argc > 0 ? std::stoi(argv[0]) : 200;
+		const auto latency = argc > 1 ? static_cast<std::size_t>(std::stoi(argv[1])) : 2;
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		const auto source = SyntheticFrame(3840, 2160);
+		MockUploadDevice device(latency);
+		Experiment::UploadRing ring(device, Experiment::Configuration::UploadSlots, dims.x, dims.y);
+
+		// two sets of four stimulus textures, alternated per trial as the controller does
+		std::vector<std::vector<std::uint16_t>> textures(8, std::vector<std::uint16_t>(static_cast<std::size_t>(dims.x) * dims.y * 4));
+
+		auto failures = 0;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (auto trial = 0; trial < trials; trial++)
+		{
+			const auto set = static_cast<std::size_t>(trial % 2) * 4;
+
+			// every tenth trial is queued three times over before a flush, more than the ring holds
+			const auto repeats = trial % 10 == 9 ? 3 : 1;
+
+			for (auto r = 0; r < repeats; r++)
+			{
+				for (std::size_t i = 0; i < 4; i++)
+				{
+					ring.Enqueue(Experiment::ConstRgba16View(source).Crop(static_cast<int>((trial * 97 + i * 13) % (3840 - dims.x)), static_cast<int>((trial * 31 + i * 7) % (2160 - dims.y)), dims.x, dims.y), &textures[set + i]);
+				}
+			}
+
+			// the flush of the next frame, then frames until the copies have landed, as they would before the stimuli are shown
+			ring.Flush();
+			for (std::size_t frame = 0; frame <= latency; frame++)
+			{
+				device.Present();
+				ring.Flush();
+			}
+
+			for (std::size_t i = 0; i < 4; i++)
+			{
+				const auto expected = Experiment::ConstRgba16View(source).Crop(static_cast<int>((trial * 97 + i * 13) % (3840 - dims.x)), static_cast<int>((trial * 31 + i * 7) % (2160 - dims.y)), dims.x, dims.y);
+				const Experiment::ConstRgba16View actual(textures[set + i].data(), dims.x, dims.y);
+
+				for (auto y = 0; y < dims.y; y += 97)
+				{
+					if (std::memcmp(expected.Row(y), actual.Row(y), dims.x * 8) != 0)
+					{
+						failures++;
+						break;
+					}
+				}
+			}
+		}
+
+		const auto milliseconds = Milliseconds(std::chrono::steady_clock::now() - start).count();
+		const auto statistics = ring.GetStatistics();
+
+		std::cout << "Uploads: " << statistics << std::endl;
+		std::cout << device.stalls << " stalls, " << failures << " wrong textures, " << milliseconds / statistics.uploads << " ms per upload" << std::endl;
+
+		return device.stalls == 0 && failures == 0 && statistics.direct > 0 && statistics.staged > 0 ? 0 : 1;
+	}
+
+	/// Runs sessions against a simulated clock in which copies run at 4 GB/s, drawing takes 4 to 12 ms and the frame budget is
+	/// 16 ms. Compares uploading each trial in one burst with the scheduler, and checks that every deadline is met, including
+	/// deadlines one frame away
+	int Schedule(int argc, char** argv)
+	{
+		const auto trials = argc > 0 ? std::stoi(argv[0]) : 100;
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		using Clock = Experiment::UploadScheduler::Clock;
+		const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(Experiment::Configuration::FlickerRate));
+		const auto budget = std::chrono::duration_cast<Clock::duration>(Experiment::Configuration::FrameBudget);
+
+		const auto source = SyntheticFrame(3840, 2160);
+
+		struct Result
+		{
+			Clock::duration longestFrame = {};
+			std::size_t overBudget = 0;
+			std::size_t wrong = 0;
+			Experiment::UploadScheduler::Statistics statistics;
+		};
+
+		const auto run = [&](const bool burst, const Clock::duration transition)
+		{
+			Clock::time_point now = {};
+			std::mt19937 random(7);
+
+			MockUploadDevice device(1);
+			device.charge = [&](const std::size_t bytes) { now += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(bytes / 4e9)); };
+
+			Experiment::UploadRing ring(device, Experiment::Configuration::UploadSlots, dims.x, dims.y);
+
+			Experiment::UploadScheduler::Settings settings;
+			settings.bandRows = Experiment::Configuration::UploadBandRows;
+			settings.framePeriod = period;
+			Experiment::UploadScheduler scheduler(ring, settings, [&] { return now; });
+
+			std::vector<std::vector<std::uint16_t>> textures(8, std::vector<std::uint16_t>(static_cast<std::size_t>(dims.x) * dims.y * 4));
+			const auto region = [&](const int trial, const std::size_t i)
+			{
+				return Experiment::ConstRgba16View(source).Crop(static_cast<int>((trial * 97 + i * 13) % (3840 - dims.x)), static_cast<int>((trial * 31 + i * 7) % (2160 - dims.y)), dims.x, dims.y);
+			};
+
+			Result result;
+			auto draw = Clock::time_point::max();
+			auto trial = -1;
+
+			for (auto frame = 0; trial < trials; frame++)
+			{
+				const auto start = now;
+				Clock::duration last = std::chrono::milliseconds(4 + random() % 9);
+
+				if (now >= draw)
+				{
+					// the transition is over: the stimuli must be complete, and are checked once the copies have landed
+					scheduler.Finish();
+					draw = Clock::time_point::max();
+				}
+
+				if (draw == Clock::time_point::max() && frame % 8 == 0)
+				{
+					// a response: the next trial is scheduled into the other set of textures
+					if (trial >= 0)
+					{
+						for (std::size_t i = 0; i < 4; i++)
+						{
+							const auto expected = region(trial, i);
+							const Experiment::ConstRgba16View actual(textures[(trial % 2) * 4 + i].data(), dims.x, dims.y);
+
+							for (auto y = 0; y < dims.y; y += 37)
+							{
+								if (std::memcmp(expected.Row(y), actual.Row(y), dims.x * 8) != 0) { result.wrong++; break; }
+							}
+						}
+					}
+
+					trial++;
+					draw = now + transition;
+
+					for (std::size_t i = 0; i < 4; i++)
+					{
+						scheduler.Schedule(region(trial, i), &textures[(trial % 2) * 4 + i], draw);
+					}
+
+					if (burst) scheduler.Finish();
+				}
+
+				scheduler.Run(budget > last ? budget - last : Clock::duration{});
+
+				const auto cost = now - start + last;
+				result.longestFrame = std::max(result.longestFrame, cost);
+				result.overBudget += cost > budget ? 1 : 0;
+
+				now = start + period;
+				device.Present();
+			}
+
+			result.statistics = scheduler.GetStatistics();
+			return result;
+		};
+
+		const auto print = [](const char* name, const Result& r)
+		{
+			std::cout << name << ": longest frame " << std::chrono::duration<double, std::milli>(r.longestFrame).count() << " ms, "
+				<< r.overBudget << " frames over budget, " << r.wrong << " wrong textures; " << r.statistics << std::endl;
+		};
+
+		const auto transition = std::chrono::duration_cast<Clock::duration>(Experiment::Configuration::ImageTransitionDuration);
+		const auto burst = run(true, transition);
+		const auto scheduled = run(false, transition);
+		const auto tight = run(false, period);
+
+		print("burst", burst);
+		print("scheduled", scheduled);
+		print("one frame deadline", tight);
+
+		const auto ok = burst.wrong + scheduled.wrong + tight.wrong == 0
+			&& scheduled.statistics.missedDeadlines == 0 && tight.statistics.missedDeadlines == 0
+			&& scheduled.overBudget == 0;
+
+		return ok ? 0 : 1;
+	}
+
+	/// Runs sessions headless through the screens of the experiment on the CPU renderer, a frame per flicker period of a
+	/// simulated clock, and checks the frames against the exact tone mapping: stimuli mirrored in place, the progress bar and the
+	/// black background. Every third trial times out to the response screen. Reports the cost of a frame on one and on every core
+	int Render(int argc, char** argv)
+	{
+		const auto trials = argc > 0 ? std::stoi(argv[0]) : 10;
+		const auto threads = argc > 1 ? static_cast<unsigned>(std::stoi(argv[1])) : 0u;
+
+		const auto dims = Experiment::Configuration::ImageDimensions;
+		const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(Experiment::Configuration::FlickerRate));
+
+		Experiment::CpuRenderer::Settings settings;
+		settings.threads = threads;
+		Experiment::CpuRenderer renderer(settings);
+
+		const auto source = std::make_shared<Experiment::Frame>(SyntheticFrame(3840, 2160));
+		const auto black = std::make_shared<Experiment::Frame>(SyntheticFrame(3840, 2160));
+		std::memset(black->data, 0, black->Bytes());
+
+		const auto screen = [&](const std::shared_ptr<Experiment::Frame>& frame)
+		{
+			const auto texture = renderer.CreateTexture(Experiment::ConstRgba16View(*frame));
+			return Experiment::Scene::ComposeStaticStereoView(texture, texture);
+		};
+
+		const auto start = screen(source);
+		const auto transition = screen(black);
+		const auto response = screen(source);
+
+		std::size_t failures = 0;
+		std::size_t checked = 0;
+		std::array<std::size_t, 4> screens = {};
+
+		const auto expect = [&](const int x, const int y, const std::uint32_t expected)
+		{
+			// the table rounds the Rec.2020 values to 16 bits, which may move the darkest codes by one
+			const auto actual = *renderer.GetFrontBuffer()(x, y);
+			for (auto shift = 0; shift < 30; shift += 10)
+			{
+				const auto a = static_cast<int>(actual >> shift & 1023), e = static_cast<int>(expected >> shift & 1023);
+				if (std::abs(a - e) > 1) { failures++; break; }
+			}
+
+			failures += (actual >> 30) != (expected >> 30) ? 1 : 0;
+			checked++;
+		};
+
+		const auto pixel = [&](const Experiment::ConstRgba16View view, const int x, const int y)
+		{
+			const auto* p = view(x, y);
+			return Experiment::CpuRenderer::ToneMap({ p[0] / 65535.0f, p[1] / 65535.0f, p[2] / 65535.0f, p[3] / 65535.0f }, settings.paperWhiteNits);
+		};
+
+		const auto frame = [&](const Experiment::Scene::Screen shown, const std::function<void()>& draw)
+		{
+			renderer.Begin();
+			draw();
+			renderer.End();
+			renderer.Present();
+
+			screens[static_cast<std::size_t>(shown)]++;
+		};
+
+		// the start screen while the session preloads
+		for (auto i = 0; i <= 10; i++)
+		{
+			const auto progress = i / 10.0f;
+
+			frame(Experiment::Scene::ScreenAt(false, {}), [&]
+				{
+					Experiment::Scene::Draw(renderer, start);
+					if (progress < 1.0f) Experiment::Scene::DrawProgressBar(renderer, progress);
+				});
+
+			if (i == 5)
+			{
+				expect(3840 + 960, 2160 - 170, Experiment::CpuRenderer::ToneMap(Experiment::Colors::White, settings.paperWhiteNits));
+				expect(3840 + 960 + 1900, 2160 - 170, Experiment::CpuRenderer::ToneMap(Experiment::Colors::DimGray, settings.paperWhiteNits));
+				expect(3840 + 100, 100, pixel(Experiment::ConstRgba16View(*source), 100, 100));
+			}
+		}
+
+		for (auto t = 0; t < trials; t++)
+		{
+			Experiment::Trial trial;
+			trial.correctOption = t % 2 == 0 ? Experiment::Option::Left : Experiment::Option::Right;
+
+			std::array<Experiment::ConstRgba16View, 4> stimuli;
+
+			for (std::size_t i = 0; i < 4; i++)
+			{
+				stimuli[i] = Experiment::ConstRgba16View(*source).Crop(static_cast<int>((t * 97 + i * 13) % (3840 - dims.x)), static_cast<int>((t * 31 + i * 7) % (2160 - dims.y)), dims.x, dims.y);
+			}
+
+			const auto views = Experiment::Scene::ComposeFlickerStereoViews(trial, renderer.CreateTextureArray(stimuli.data(), stimuli.size()));
+			const auto answered = t % 3 == 2 ? Experiment::Configuration::ImageTimeoutDuration + std::chrono::seconds(1) : std::chrono::milliseconds(1500);
+
+			auto flicker = false;
+
+			for (std::chrono::steady_clock::duration elapsed = {}; elapsed < answered; elapsed += period)
+			{
+				const auto shown = Experiment::Scene::ScreenAt(true, elapsed);
+
+				switch (shown)
+				{
+				case Experiment::Scene::Screen::Transition:
+					frame(shown, [&] { Experiment::Scene::Draw(renderer, transition); });
+					expect(100, 100, 0);
+					break;
+
+				case Experiment::Scene::Screen::Response:
+					frame(shown, [&] { Experiment::Scene::Draw(renderer, response); });
+					break;
+
+				default:
+				{
+					const auto& view = flicker ? views.first : views.second;
+					frame(shown, [&] { Experiment::Scene::Draw(renderer, view); });
+
+					// each image mirrored in place: its last column at its left
+					for (auto w = 0; w < 2; w++)
+					{
+						for (auto j = 0; j < 2; j++)
+						{
+							const auto& image = view[w][j];
+							const auto x = static_cast<int>(image.position.x), y = static_cast<int>(image.position.y);
+
+							expect(x, y + 10, pixel(stimuli[image.slice], dims.x - 1, 10));
+							expect(x + 400, y + 500, pixel(stimuli[image.slice], dims.x - 401, 500));
+						}
+					}
+
+					// the background between the images
+					expect(1920, 1080, 0);
+
+					flicker = !flicker;
+				}
+				}
+			}
+		}
+
+		const auto statistics = renderer.GetStatistics();
+		std::cout << "Renderer: " << statistics << std::endl;
+		std::cout << "screens: " << screens[0] << " start, " << screens[1] << " transition, " << screens[2] << " stimuli, " << screens[3] << " response; "
+			<< checked << " pixels checked, " << failures << " wrong" << std::endl;
+
+		// the cost of one stimuli frame, on one core and on all of them
+		const auto measure = [&](const unsigned count)
+		{
+			Experiment::CpuRenderer::Settings single = settings;
+			single.threads = count;
+			Experiment::CpuRenderer other(single);
+
+			std::array<Experiment::ConstRgba16View, 4> stimuli;
+			stimuli.fill(Experiment::ConstRgba16View(*source).Crop(0, 0, dims.x, dims.y));
+
+			Experiment::Trial trial;
+			trial.correctOption = Experiment::Option::Left;
+			const auto views = Experiment::Scene::ComposeFlickerStereoViews(trial, other.CreateTextureArray(stimuli.data(), stimuli.size()));
+
+			for (auto i = 0; i < 20; i++)
+			{
+				other.Begin();
+				Experiment::Scene::Draw(other, i % 2 == 0 ? views.first : views.second);
+				other.End();
+				other.Present();
+			}
+
+			const auto s = other.GetStatistics();
+			return Milliseconds(s.totalFrames).count() / static_cast<double>(s.frames);
+		};
+
+		const auto one = measure(1);
+		const auto all = measure(threads);
+		std::cout << "stimuli frame: " << one << " ms on one thread, " << all << " ms on " << (threads > 0 ? threads : std::thread::hardware_concurrency())
+			<< " (" << one / all << "x), " << 7680.0 * 2160 / (all * 1000) << " Mpixels/s" << std::endl;
+
+		return failures == 0 && checked > 0 ? 0 : 1;
+	}
+
+	/// A sprite device which records what the GPU would be asked to do
+	class RecordingSpriteDevice final : public Experiment::ISpriteDevice
+	{
+	public:
+		void Bind(const void* texture) override
+		{
+			binds++;
+			bound = texture;
+		}
+
+		void Draw(const Instance* instances, const std::size_t count) override
+		{
+			draws++;
+			drawn.insert(drawn.end(), instances, instances + count);
+			textures.insert(textures.end(), count, bound);
+		}
+
+		std::size_t binds = 0;
+		std::size_t draws = 0;
+
+		/// The instances of the frame, and the texture each was drawn from
+		std::vector<Instance> drawn;
+		std::vector<const void*> textures;
+
+	private:
+		const void* bound = nullptr;
+	};
+
+	/// Draws as the D3D11 renderer does, through a sprite batcher, with textures that only have a size
+	class BatchingRenderer final : public Experiment::IRenderer
+	{
+	public:
+		explicit BatchingRenderer(Experiment::ISpriteDevice& device) : m_batcher(device) {}
+
+		std::shared_ptr<const Experiment::ITexture> CreateTexture(const Experiment::ConstRgba16View pixels) override
+		{
+			return CreateTextureArray(&pixels, 1);
+		}
+
+		std::shared_ptr<const Experiment::ITexture> CreateTextureArray(const Experiment::ConstRgba16View* slices, const std::size_t count) override
+		{
+			return std::make_shared<Texture>(slices[0].width, slices[0].height, static_cast<int>(count));
+		}
+
+		void Begin() override { m_batcher.Invalidate(); }
+
+		void Draw(const Experiment::ITexture& texture, const Experiment::Point position, const bool flipHorizontally, const int slice) override
+		{
+			m_batcher.Draw(&texture, position, texture.Width(), texture.Height(), flipHorizontally, slice);
+		}
+
+		void Fill(const Experiment::Rect& rectangle, const Experiment::Color color) override
+		{
+			m_batcher.Fill(&m_white, rectangle, color);
+		}
+
+		void End() override { m_batcher.Flush(); }
+		void Present() override {}
+
+		[[nodiscard]] Experiment::SpriteBatcher::Statistics GetStatistics() const { return m_batcher.GetStatistics(); }
+
+	private:
+		class Texture final : public Experiment::ITexture
+		{
+		public:
+			Texture(const int width, const int height, const int slices) : m_width(width), m_height(height), m_slices(slices) {}
+
+			[[nodiscard]] int Width() const override { return m_width; }
+			[[nodiscard]] int Height() const override { return m_height; }
+			[[nodiscard]] int Slices() const override { return m_slices; }
+
+		private:
+			int m_width, m_height, m_slices;
+		};
+
+		Experiment::SpriteBatcher m_batcher;
+		Texture m_white{ 1, 1, 1 };
+	};
+
+	/// Draws the screens of the experiment through the sprite batcher of the D3D11 renderer onto a recording device, and checks the
+	/// binds and draws per frame: one of each for the stimuli in a texture array, against one per stimulus texture before. The
+	/// instances recorded are checked against the composed views
+	int Batch(int argc, char** argv)
+	{
+		const auto frames = argc > 0 ? std::stoi(argv[0]) : 1000;
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		const auto source = std::make_shared<Experiment::Frame>(SyntheticFrame(dims.x, dims.y));
+
+		std::array<Experiment::ConstRgba16View, 4> stimuli;
+		stimuli.fill(Experiment::ConstRgba16View(*source));
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		// the frames of one screen, and the binds and draws of each; `inspect` sees what each frame recorded
+		const auto run = [&](RecordingSpriteDevice& device, BatchingRenderer& renderer, const std::function<void(int frame)>& draw,
+			const std::function<void(int frame)>& inspect = nullptr)
+		{
+			const auto binds = device.binds, draws = device.draws;
+
+			for (auto i = 0; i < frames; i++)
+			{
+				device.drawn.clear();
+				device.textures.clear();
+
+				renderer.Begin();
+				draw(i);
+				renderer.End();
+				renderer.Present();
+
+				if (inspect) inspect(i);
+			}
+
+			return std::make_pair(static_cast<double>(device.binds - binds) / frames, static_cast<double>(device.draws - draws) / frames);
+		};
+
+		Experiment::Trial trial;
+		trial.correctOption = Experiment::Option::Right;
+
+		// the stimuli of a trial as one texture array
+		{
+			RecordingSpriteDevice device;
+			BatchingRenderer renderer(device);
+
+			const auto stimulus = renderer.CreateTextureArray(stimuli.data(), stimuli.size());
+			const auto views = Experiment::Scene::ComposeFlickerStereoViews(trial, stimulus);
+
+			const auto view = [&](const int frame) -> const Experiment::DuoView& { return frame % 2 == 0 ? views.first : views.second; };
+
+			const auto [binds, draws] = run(device, renderer, [&](const int frame) { Experiment::Scene::Draw(renderer, view(frame)); }, [&](const int frame)
+				{
+					if (frame > 1) return;
+
+					check(device.drawn.size() == 4 && device.textures.size() == 4, "the stimuli are drawn");
+
+					for (std::size_t i = 0; i < device.drawn.size() && i < 4; i++)
+					{
+						const auto& instance = device.drawn[i];
+						const auto& image = view(frame)[i / 2][i % 2];
+
+						check(device.textures[i] == stimulus.get(), "the stimuli are drawn from the texture array");
+						check(instance.slice == static_cast<std::uint32_t>(image.slice) && instance.flip == 1, "the slice and flip of the stimuli");
+						check(instance.rectangle[0] == image.position.x && instance.rectangle[1] == image.position.y, "the position of the stimuli");
+						check(instance.rectangle[2] == dims.x && instance.rectangle[3] == dims.y, "the size of the stimuli");
+					}
+				});
+
+			std::cout << "texture array: " << binds << " binds, " << draws << " draws per stimuli frame; " << renderer.GetStatistics() << std::endl;
+			check(binds == 1 && draws == 1, "the stimuli of a frame are one bind and one draw");
+		}
+
+		// the layout before, with a texture per stimulus
+		{
+			RecordingSpriteDevice device;
+			BatchingRenderer renderer(device);
+
+			std::array<std::shared_ptr<const Experiment::ITexture>, 4> textures;
+			for (std::size_t i = 0; i < 4; i++)
+			{
+				textures[i] = renderer.CreateTexture(stimuli[i]);
+			}
+
+			auto views = Experiment::Scene::ComposeFlickerStereoViews(trial, renderer.CreateTextureArray(stimuli.data(), stimuli.size()));
+
+			for (auto* view : { &views.first, &views.second })
+			{
+				for (auto w = 0; w < 2; w++)
+				{
+					for (auto j = 0; j < 2; j++)
+					{
+						auto& image = (*view)[w][j];
+						image.image = textures[image.slice];
+						image.slice = 0;
+					}
+				}
+			}
+
+			const auto [binds, draws] = run(device, renderer, [&](const int frame)
+				{
+					Experiment::Scene::Draw(renderer, frame % 2 == 0 ? views.first : views.second);
+				});
+
+			std::cout << "texture per stimulus: " << binds << " binds, " << draws << " draws per stimuli frame; " << renderer.GetStatistics() << std::endl;
+			check(binds > 1 && draws > 1, "separate stimulus textures take several binds and draws");
+		}
+
+		// the start screen with its progress bar: the screen, then both bars from the white texel
+		{
+			RecordingSpriteDevice device;
+			BatchingRenderer renderer(device);
+
+			const auto screen = renderer.CreateTexture(Experiment::ConstRgba16View(*source));
+			const auto start = Experiment::Scene::ComposeStaticStereoView(screen, screen);
+
+			const auto [binds, draws] = run(device, renderer, [&](const int frame)
+				{
+					Experiment::Scene::Draw(renderer, start);
+					Experiment::Scene::DrawProgressBar(renderer, static_cast<float>(frame % 100) / 100);
+				});
+
+			std::cout << "start screen: " << binds << " binds, " << draws << " draws per frame" << std::endl;
+			check(binds == 2 && draws == 2, "the start screen is two binds and two draws");
+		}
+
+		// more sprites of one texture than a draw holds
+		{
+			RecordingSpriteDevice device;
+			Experiment::SpriteBatcher batcher(device);
+
+			const auto sprites = Experiment::SpriteBatcher::MaxInstances * 2 + 1;
+			for (std::size_t i = 0; i < sprites; i++)
+			{
+				batcher.Draw(source.get(), { static_cast<float>(i), 0 }, 1, 1, false, 0);
+			}
+
+			batcher.Flush();
+
+			check(device.binds == 1 && device.draws == 3 && device.drawn.size() == sprites, "a full batch is drawn without rebinding");
+			check(device.drawn.back().rectangle[0] == static_cast<float>(sprites - 1), "the sprites are drawn in order");
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Compiles the frame graph of the experiment and a few others, and checks what their plans elide and fold: the depth buffer
+	/// nothing reads, the HDR scene once the tone map runs in the shader of the opaque sprites, and passes nothing presented needs
+	int Graph(int, char**)
+	{
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		using Pass = Experiment::RenderGraph::Pass;
+
+		// the experiment, with opaque sprites
+		{
+			const Experiment::FrameGraph frame(7680, 2160);
+			const auto plan = frame.graph.Compile();
+
+			std::cout << "opaque sprites: " << frame.graph.Describe(plan) << std::endl;
+
+			check(plan.steps.size() == 2, "a frame is two steps");
+			check(!plan.IsAllocated(frame.depth), "the depth buffer is elided");
+			check(!plan.IsAllocated(frame.scene), "the HDR scene is elided");
+			check(plan.StepOf(frame.toneMap) == plan.StepOf(frame.composite), "the tone map is folded into the sprites");
+			check(plan.StepOf(frame.composite)->writes == std::vector<Experiment::RenderGraph::Resource>{ frame.backBuffer }, "the sprites write the back buffer");
+			check(plan.Runs(frame.present), "the frame is presented");
+			check(plan.elidedBytes == std::size_t{ 7680 } * 2160 * 12 && plan.allocatedBytes == 0, "nothing is allocated");
+		}
+
+		// sprites which blend need the linear scene
+		{
+			const Experiment::FrameGraph frame(7680, 2160, false);
+			const auto plan = frame.graph.Compile();
+
+			std::cout << "blended sprites: " << frame.graph.Describe(plan) << std::endl;
+
+			check(plan.steps.size() == 3, "a frame is three steps");
+			check(plan.IsAllocated(frame.scene) && !plan.IsAllocated(frame.depth), "only the HDR scene is allocated");
+			check(plan.StepOf(frame.toneMap)->pass == frame.toneMap, "the tone map is a pass of its own");
+		}
+
+		// another reader of the scene keeps it, and a pass whose output nobody reads is dropped
+		{
+			Experiment::FrameGraph frame(7680, 2160);
+
+			const auto overlay = frame.graph.Create("Overlay", 1024);
+
+			Pass debug;
+			debug.name = "Debug overlay";
+			debug.writes = { overlay };
+			const auto unused = frame.graph.AddPass(debug);
+
+			Pass capture;
+			capture.name = "Capture";
+			capture.reads = { frame.scene };
+			capture.sideEffects = true;
+			frame.graph.AddPass(capture);
+
+			const auto plan = frame.graph.Compile();
+
+			std::cout << "with a capture of the scene: " << frame.graph.Describe(plan) << std::endl;
+
+			check(!plan.Runs(unused) && !plan.IsAllocated(overlay), "the overlay nobody reads is dropped");
+			check(plan.IsAllocated(frame.scene) && plan.StepOf(frame.toneMap)->pass == frame.toneMap, "a scene read twice is not folded");
+		}
+
+		// an opaque pass overwriting the back buffer makes the passes before it dead
+		{
+			Experiment::RenderGraph graph;
+
+			const auto back = graph.Import("Back buffer");
+
+			Pass first;
+			first.name = "First";
+			first.writes = { back };
+			first.opaque = true;
+			const auto overwritten = graph.AddPass(first);
+
+			Pass second = first;
+			second.name = "Second";
+			const auto kept = graph.AddPass(second);
+
+			const auto plan = graph.Compile();
+
+			check(!plan.Runs(overwritten) && plan.Runs(kept), "an overwritten pass is dropped");
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// A swap chain with a sync interval of 1: a present returns at the next vertical blank of a display refreshing every `period`,
+	/// and records which blank it was queued for
+	class MockSwapChain final : public Experiment::IPresentTarget
+	{
+	public:
+		MockSwapChain(const std::chrono::steady_clock::time_point epoch, const std::chrono::steady_clock::duration period) : m_epoch(epoch), m_period(period) {}
+
+		void Present() override
+		{
+			if (failAt == blanks.size())
+			{
+				failAt = SIZE_MAX;
+				throw std::runtime_error("the device was removed");
+			}
+
+			const auto blank = (std::chrono::steady_clock::now() - m_epoch) / m_period + 1;
+			std::this_thread::sleep_until(m_epoch + blank * m_period);
+
+			blanks.push_back(blank);
+		}
+
+		/// The vertical blank of each present
+		std::vector<std::int64_t> blanks;
+
+		/// The present which fails, once
+		std::size_t failAt = SIZE_MAX;
+
+	private:
+		std::chrono::steady_clock::time_point m_epoch;
+		std::chrono::steady_clock::duration m_period;
+	};
+
+	/// Presents the two eyes of a stereo pair on mock swap chains of 60 Hz displays, one after the other as HDRViewer19 did and
+	/// through the present scheduler, and checks that the scheduler queues both eyes for the same vertical blank. Also checks the
+	/// barrier over many rounds and that a failed present is reported
+	int Present(int argc, char** argv)
+	{
+		const auto frames = argc > 0 ? std::stoi(argv[0]) : 120;
+		const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(1000.0 / 60));
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		// nobody leaves a round before everybody arrived
+		{
+			constexpr std::size_t threads = 4, rounds = 2000;
+
+			Experiment::Barrier barrier(threads);
+			std::atomic<std::size_t> arrived{ 0 };
+			std::atomic<std::size_t> early{ 0 };
+
+			std::vector<std::thread> workers;
+			for (std::size_t t = 0; t < threads; t++)
+			{
+				workers.emplace_back([&]
+					{
+						for (std::size_t round = 0; round < rounds; round++)
+						{
+							arrived++;
+							barrier.ArriveAndWait();
+
+							if (arrived.load() < threads * (round + 1)) early++;
+						}
+					});
+			}
+
+			for (auto& worker : workers) worker.join();
+
+			std::cout << "barrier: " << threads << " threads, " << rounds << " rounds, " << early.load() << " early" << std::endl;
+			check(early == 0 && arrived == threads * rounds, "the barrier holds every round");
+		}
+
+		// the fraction of frames whose eyes landed on the same vertical blank
+		const auto together = [](const MockSwapChain& left, const MockSwapChain& right)
+		{
+			std::size_t same = 0;
+			for (std::size_t i = 0; i < left.blanks.size() && i < right.blanks.size(); i++)
+			{
+				same += left.blanks[i] == right.blanks[i] ? 1 : 0;
+			}
+
+			return static_cast<double>(same) / static_cast<double>(std::max<std::size_t>(1, left.blanks.size()));
+		};
+
+		const auto epoch = std::chrono::steady_clock::now();
+
+		// one after the other
+		{
+			MockSwapChain left(epoch, period), right(epoch, period);
+
+			for (auto i = 0; i < frames; i++)
+			{
+				left.Present();
+				right.Present();
+			}
+
+			std::cout << "sequential: " << together(left, right) * 100 << "% of frames with both eyes on the same vertical blank" << std::endl;
+		}
+
+		{
+			MockSwapChain left(epoch, period), right(epoch, period);
+			Experiment::PresentScheduler scheduler({ &left, &right });
+
+			for (auto i = 0; i < frames; i++)
+			{
+				scheduler.Present();
+			}
+
+			const auto fraction = together(left, right);
+
+			std::cout << "scheduled: " << fraction * 100 << "% of frames with both eyes on the same vertical blank" << std::endl;
+			std::cout << "PresentScheduler: " << scheduler.GetStatistics() << std::endl;
+
+			check(scheduler.GetStatistics().frames == static_cast<std::size_t>(frames), "every frame is presented");
+			check(fraction >= 0.95, "the eyes are presented on the same vertical blank");
+			check(scheduler.GetStatistics().maxIssueSkew < period / 2, "the eyes are issued within half a frame");
+
+			// a present which fails is rethrown to the caller, and the next frame presents again
+			right.failAt = right.blanks.size();
+
+			auto thrown = false;
+			try
+			{
+				scheduler.Present();
+			}
+			catch (const std::runtime_error&)
+			{
+				thrown = true;
+			}
+
+			scheduler.Present();
+
+			check(thrown, "a failed present is rethrown");
+			check(right.blanks.size() == static_cast<std::size_t>(frames) + 1 && left.blanks.size() == static_cast<std::size_t>(frames) + 2, "presenting continues after a failure");
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Stress tests the queue between the message pump and the render thread: a producer and a consumer thread pass values
+	/// through a small queue, which must arrive in order and whole, and a render thread ticks while the UI thread posts bursts of
+	/// events larger than its queue and then blocks as in a modal dialog, which must not stall the ticks
+	int Thread(int argc, char** argv)
+	{
+		const auto count = argc > 0 ? static_cast<std::size_t>(std::stoull(argv[0])) : std::size_t(1000000);
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		// every value arrives once, in order, and with all of its fields written by the same push
+		{
+			Experiment::SpscQueue<Experiment::WindowEvent> queue(64);
+
+			std::size_t misordered = 0, torn = 0;
+
+			const auto start = std::chrono::steady_clock::now();
+
+			std::thread consumer([&]
+				{
+					Experiment::WindowEvent event;
+					for (std::size_t i = 0; i < count;)
+					{
+						if (!queue.TryPop(event))
+						{
+							std::this_thread::yield();
+							continue;
+						}
+
+						misordered += event.key != i ? 1 : 0;
+						torn += event.width != static_cast<int>(i & 0xFFFF) || event.height != static_cast<int>(~i & 0xFFFF) ? 1 : 0;
+						i++;
+					}
+				});
+
+			for (std::size_t i = 0; i < count;)
+			{
+				Experiment::WindowEvent event;
+				event.key = i;
+				event.width = static_cast<int>(i & 0xFFFF);
+				event.height = static_cast<int>(~i & 0xFFFF);
+
+				if (queue.TryPush(event))
+				{
+					i++;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			consumer.join();
+
+			const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			Experiment::WindowEvent event;
+
+			std::cout << "queue: " << count << " events through " << queue.Capacity() << " slots, " << elapsed / static_cast<double>(count) << " ns per event, "
+				<< misordered << " out of order, " << torn << " torn" << std::endl;
+
+			check(misordered == 0 && torn == 0, "the queue delivers every event in order");
+			check(!queue.TryPop(event) && queue.Size() == 0, "the queue is empty once drained");
+		}
+
+		// the render thread keeps ticking while the UI thread posts faster than it drains, and while the UI thread is blocked
+		{
+			constexpr std::size_t events = 20000;
+			constexpr auto frame = std::chrono::milliseconds(1);
+			constexpr auto blocked = std::chrono::milliseconds(250);
+
+			std::vector<Experiment::WindowEvent> received;
+			std::size_t onUiThread = 0;
+			std::atomic<std::size_t> ticks{ 0 };
+
+			const auto ui = std::this_thread::get_id();
+
+			Experiment::RenderThread renderThread(
+				[&](const Experiment::WindowEvent& event)
+				{
+					received.push_back(event);
+					onUiThread += std::this_thread::get_id() == ui ? 1 : 0;
+				},
+				[&]
+				{
+					std::this_thread::sleep_for(frame);
+					ticks++;
+				},
+				16);
+
+			const auto posting = std::chrono::steady_clock::now();
+
+			for (std::size_t i = 0; i < events; i++)
+			{
+				Experiment::WindowEvent event;
+				event.key = i;
+				renderThread.Post(event);
+			}
+
+			// a drag of the window while the queue is full: only the last move and size reach the render thread
+			for (int i = 1; i <= 3; i++)
+			{
+				Experiment::WindowEvent moved;
+				moved.type = Experiment::WindowEvent::Type::Moved;
+				renderThread.Post(moved);
+
+				Experiment::WindowEvent resized;
+				resized.type = Experiment::WindowEvent::Type::Resized;
+				resized.width = 100 * i;
+				resized.height = 50 * i;
+				renderThread.Post(resized);
+				renderThread.Post(resized);
+			}
+
+			const auto posted = std::chrono::steady_clock::now() - posting;
+
+			// a message pump stuck in a dialog or a size/move loop, which no longer hands over the events held back
+			const auto before = ticks.load();
+			std::this_thread::sleep_for(blocked);
+			const auto during = ticks.load() - before;
+
+			Experiment::WindowEvent last;
+			last.key = events;
+			renderThread.Post(last);
+
+			renderThread.Stop();
+
+			const auto statistics = renderThread.GetStatistics();
+
+			std::size_t keys = 0;
+			std::size_t misordered = 0;
+			std::vector<Experiment::WindowEvent> window;
+			for (const auto& event : received)
+			{
+				if (event.type == Experiment::WindowEvent::Type::KeyDown)
+				{
+					misordered += event.key != keys ? 1 : 0;
+					misordered += keys == events && window.size() != 2 ? 1 : 0;
+					keys++;
+				}
+				else
+				{
+					misordered += keys != events ? 1 : 0;
+					window.push_back(event);
+				}
+			}
+
+			std::cout << "render thread: " << std::chrono::duration<double, std::milli>(posted).count() << " ms to post " << events + 9 << " events, "
+				<< during << " ticks while the UI thread was blocked for " << blocked.count() << " ms" << std::endl;
+			std::cout << "RenderThread: " << statistics << std::endl;
+
+			check(keys == events + 1 && misordered == 0, "every posted key is dispatched in order, including the last before Stop");
+			check(onUiThread == 0, "events are dispatched on the render thread");
+			check(statistics.deferred > 0 && statistics.maxQueued <= 16, "posts beyond the queue are held back instead of being dropped");
+			check(posted < events / 16 * frame / 4, "posting never waits for the render thread to make room");
+			check(window.size() == 2 && statistics.merged == 7 && window[0].type == Experiment::WindowEvent::Type::Moved && window[1].width == 300 && window[1].height == 150,
+				"the moves and resizes held back are merged into the last of each");
+			check(during > 0, "the render thread ticks while the UI thread is blocked");
+			check(statistics.longestGap < blocked / 2, "no tick waits on the UI thread");
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Times a trace scope while tracing is disabled and enabled, records from several threads while the trace is written, and
+	/// checks the Chrome trace JSON: every event once, the names of the threads, and the events dropped by a full ring.
+	/// Writes the trace to `path`, if given, to open in chrome://tracing or the Perfetto UI
+	int TraceEvents(int argc, char** argv)
+	{
+		const auto count = argc > 0 ? static_cast<std::size_t>(std::stoull(argv[0])) : std::size_t(1000000);
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		const auto timeScopes = [](const std::size_t scopes)
+		{
+			const auto start = std::chrono::steady_clock::now();
+
+			for (std::size_t i = 0; i < scopes; i++)
+			{
+				TRACE_SCOPE("benchmark", "Scope");
+			}
+
+			return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(scopes);
+		};
+
+		// the calling thread's ring holds exactly the enabled scopes, and the few beyond them overwrite the oldest
+		const auto disabled = timeScopes(count);
+
+		Experiment::Trace::Enable(count);
+		const auto enabled = timeScopes(count);
+
+		constexpr std::size_t overflow = 10;
+		timeScopes(overflow);
+
+		std::cout << "scope: " << disabled << " ns disabled, " << enabled << " ns enabled" << std::endl;
+
+		check(disabled < 5, "a disabled scope costs a few nanoseconds");
+		check(enabled < 1000, "an enabled scope costs well under a microsecond");
+
+		// threads record while the trace is written, into buffers which fit their events
+		constexpr std::size_t threads = 4, perThread = 20000;
+		{
+			Experiment::Trace::Enable(perThread * 4);
+
+			std::atomic<bool> done{ false };
+
+			std::thread writer([&]
+				{
+					while (!done.load())
+					{
+						std::ostringstream partial;
+						Experiment::Trace::Write(partial);
+					}
+				});
+
+			std::vector<std::thread> workers;
+			for (std::size_t t = 0; t < threads; t++)
+			{
+				workers.emplace_back([]
+					{
+						TRACE_THREAD("Worker \"quoted\"");
+
+						for (std::size_t i = 0; i < perThread; i++)
+						{
+							TRACE_BEGIN("benchmark", "Region");
+							{
+								TRACE_SCOPE("benchmark", "Nested");
+							}
+							TRACE_END();
+							TRACE_INSTANT("benchmark", "Instant");
+						}
+					});
+			}
+
+			for (auto& worker : workers) worker.join();
+
+			done = true;
+			writer.join();
+		}
+
+		Experiment::Trace::Disable();
+		timeScopes(overflow);
+
+		const auto statistics = Experiment::Trace::GetStatistics();
+
+		std::ostringstream trace;
+		Experiment::Trace::Write(trace);
+		const auto json = trace.str();
+
+		const auto occurrences = [&](const std::string& what)
+		{
+			std::size_t n = 0;
+			for (auto i = json.find(what); i != std::string::npos; i = json.find(what, i + 1)) n++;
+			return n;
+		};
+
+		// brackets outside of strings balance
+		auto depth = 0, minimum = 0;
+		auto inString = false;
+		for (std::size_t i = 0; i < json.size(); i++)
+		{
+			if (inString)
+			{
+				if (json[i] == '\\') i++;
+				else if (json[i] == '"') inString = false;
+				continue;
+			}
+
+			if (json[i] == '"') inString = true;
+			if (json[i] == '{' || json[i] == '[') depth++;
+			if (json[i] == '}' || json[i] == ']') depth--;
+			minimum = std::min(minimum, depth);
+		}
+
+		std::cout << "Trace: " << statistics << ", " << json.size() / 1024 << " KB of JSON" << std::endl;
+
+		const auto recorded = count + threads * perThread * 4;
+
+		check(statistics.events == recorded && statistics.dropped == overflow, "every event is recorded once, and a full ring drops the oldest");
+		check(statistics.threads == threads + 1, "each thread records into a buffer of its own");
+		check(occurrences("\"ph\":\"X\"") == count + threads * perThread, "complete events");
+		check(occurrences("\"ph\":\"B\"") == threads * perThread && occurrences("\"ph\":\"E\"") == threads * perThread, "begin and end events");
+		check(occurrences("\"ph\":\"i\"") == threads * perThread, "instant events");
+		check(occurrences("\"thread_name\"") == threads && occurrences("Worker \\\"quoted\\\"") == threads, "thread names, escaped");
+		check(depth == 0 && minimum == 0 && !inString, "the JSON is well formed");
+
+		if (argc > 1)
+		{
+			Experiment::Trace::Write(std::filesystem::path(argv[1]));
+			std::cout << "wrote " << argv[1] << std::endl;
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Checks the memory accounting: charges and their peaks, budgets kept by evictors, from `threads` threads at once, and
+	/// the charges of the image cache, the preloader, the upload ring, the scratch arena and the CPU renderer's textures
+	int Memory(int argc, char** argv)
+	{
+		using Experiment::MemoryAccounting;
+		using Experiment::MemoryTag;
+
+		const auto threads = argc > 0 ? std::stoi(argv[0]) : 4;
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		{
+			MemoryAccounting accounting;
+
+			{
+				MemoryAccounting::Charge first(accounting, MemoryTag::Staging, 100);
+
+				{
+					MemoryAccounting::Charge second(accounting, MemoryTag::Staging, 50);
+					check(accounting.GetUsage(MemoryTag::Staging).current == 150, "two charges are summed");
+				}
+
+				const auto moved = std::move(first);
+				check(accounting.GetUsage(MemoryTag::Staging).current == 100, "a moved charge is released once");
+			}
+
+			const auto usage = accounting.GetUsage(MemoryTag::Staging);
+			check(usage.current == 0 && usage.peak == 150 && usage.allocations == 2, "released charges keep their peak");
+		}
+
+		{
+			MemoryAccounting accounting;
+			accounting.SetBudget(MemoryTag::DecodedFrames, 1000);
+
+			// the oldest charges are evicted first, like the entries of the image cache
+			std::vector<MemoryAccounting::Charge> held;
+			const auto id = accounting.AddEvictor(MemoryTag::DecodedFrames, [&](const std::size_t bytes)
+			{
+				std::size_t freed = 0;
+				while (!held.empty() && freed < bytes)
+				{
+					freed += held.front().Bytes();
+					held.erase(held.begin());
+				}
+
+				return freed;
+			});
+
+			auto within = true;
+			for (auto i = 0; i < 100; i++)
+			{
+				// charged before it is held, since the charge may run the evictor
+				MemoryAccounting::Charge charge(accounting, MemoryTag::DecodedFrames, 100);
+				held.push_back(std::move(charge));
+
+				within = within && accounting.GetUsage(MemoryTag::DecodedFrames).current <= 1000;
+			}
+
+			auto usage = accounting.GetUsage(MemoryTag::DecodedFrames);
+			check(within && usage.evicted >= 9000 && usage.overBudget == 0, "an evictor keeps a subsystem within its budget");
+
+			{
+				MemoryAccounting::Charge large(accounting, MemoryTag::DecodedFrames, 2000);
+
+				usage = accounting.GetUsage(MemoryTag::DecodedFrames);
+				check(held.empty() && usage.current == 2000 && usage.overBudget == 1, "a charge evictors cannot make room for is over budget");
+			}
+
+			accounting.RemoveEvictor(id);
+		}
+
+		{
+			MemoryAccounting accounting;
+			accounting.SetBudget(MemoryTag::DecodedFrames, std::size_t(1) << 20);
+
+			std::mutex mutex;
+			std::vector<MemoryAccounting::Charge> held;
+
+			const auto id = accounting.AddEvictor(MemoryTag::DecodedFrames, [&](const std::size_t bytes)
+			{
+				std::vector<MemoryAccounting::Charge> evicted;
+				std::size_t freed = 0;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					while (!held.empty() && freed < bytes)
+					{
+						freed += held.back().Bytes();
+						evicted.push_back(std::move(held.back()));
+						held.pop_back();
+					}
+				}
+
+				return freed;
+			});
+
+			constexpr auto iterations = 100000;
+
+			const auto start = std::chrono::steady_clock::now();
+
+			std::vector<std::thread> workers;
+			for (auto t = 0; t < threads; t++)
+			{
+				workers.emplace_back([&, t]
+				{
+					std::mt19937 random(t);
+					for (auto i = 0; i < iterations; i++)
+					{
+						MemoryAccounting::Charge charge(accounting, MemoryTag::DecodedFrames, 1 + random() % 16384);
+
+						std::lock_guard<std::mutex> lock(mutex);
+						held.push_back(std::move(charge));
+					}
+				});
+			}
+
+			for (auto& worker : workers) worker.join();
+
+			const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			held.clear();
+			accounting.RemoveEvictor(id);
+
+			const auto usage = accounting.GetUsage(MemoryTag::DecodedFrames);
+			std::cout << threads << " threads: " << elapsed / (static_cast<double>(threads) * iterations) << " ns per charge, evicted "
+				<< usage.evicted / (1024 * 1024) << " MB, over budget: " << usage.overBudget << std::endl;
+
+			check(usage.current == 0 && usage.allocations == static_cast<std::size_t>(threads) * iterations, "concurrent charges are all released");
+			check(usage.evicted > 0, "concurrent charges are evicted");
+		}
+
+		// the subsystems of the experiment, charged to the accounting of the process
+		auto& global = MemoryAccounting::Global();
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-memory";
+		std::filesystem::create_directories(directory);
+
+		std::vector<std::filesystem::path> paths;
+		for (auto i = 0; i < 6; i++)
+		{
+			paths.push_back(directory / ("image" + std::to_string(i) + ".ppm"));
+			Experiment::Ppm::Write(paths.back(), SyntheticFrame(256, 256));
+		}
+
+		const auto frameBytes = std::size_t(256) * 256 * 8;
+
+		{
+			// a cache larger than the budget, which only the evictor keeps within it
+			Experiment::ImageCache cache(std::size_t(1) << 30);
+
+			global.SetBudget(MemoryTag::DecodedFrames, 3 * frameBytes);
+			const auto id = global.AddEvictor(MemoryTag::DecodedFrames, [&](const std::size_t bytes) { return cache.Trim(bytes); });
+
+			for (const auto& path : paths)
+			{
+				const auto frame = cache.Get(path, [](const std::filesystem::path& p) { return Experiment::Ppm::Read(p); });
+			}
+
+			const auto usage = global.GetUsage(MemoryTag::DecodedFrames);
+			const auto statistics = cache.GetStatistics();
+			check(usage.current <= 3 * frameBytes && usage.current == statistics.bytes, "decoded frames are charged while the cache holds them");
+			check(statistics.evictions > 0 && usage.evicted > 0, "the image cache is trimmed to the budget of decoded frames");
+
+			cache.Clear();
+			check(global.GetUsage(MemoryTag::DecodedFrames).current == 0, "frames are released with the cache");
+
+			global.RemoveEvictor(id);
+			global.SetBudget(MemoryTag::DecodedFrames, MemoryAccounting::Unlimited);
+		}
+
+		{
+			Experiment::Preloader preloader(8, 64, 64, [&](const std::size_t index, Experiment::Frame& slot)
+			{
+				const auto frame = Experiment::Ppm::Read(paths[index % paths.size()]);
+				Experiment::CopyPixels(Experiment::ConstRgba16View(frame).Crop(0, 0, slot.width, slot.height), Experiment::Rgba16View(slot));
+			}, 2);
+
+			preloader.Start();
+			preloader.Wait();
+
+			MockUploadDevice device(1);
+			Experiment::UploadRing ring(device, 4, 64, 64);
+
+			Experiment::Arena arena(std::size_t(1) << 20);
+
+			Experiment::CpuRenderer renderer;
+			const auto texture = renderer.CreateTexture(Experiment::ConstRgba16View(SyntheticFrame(64, 48)));
+
+			check(global.GetUsage(MemoryTag::Preload).current == Experiment::Preloader::RequiredBytes(8, 64, 64), "the preloaded session is charged");
+			check(global.GetUsage(MemoryTag::Staging).current == std::size_t(4) * 64 * 64 * 8, "the staging slots are charged");
+			check(global.GetUsage(MemoryTag::Scratch).current == arena.GetStatistics().capacity, "the scratch arena is charged");
+			check(global.GetUsage(MemoryTag::Textures).current == std::size_t(64) * 48 * 4, "textures are charged");
+			check(global.GetUsage(MemoryTag::DecodedFrames).current == 0, "decoded frames are released once copied");
+
+			std::cout << global;
+		}
+
+		std::filesystem::remove_all(directory);
+
+		for (std::size_t i = 0; i < static_cast<std::size_t>(MemoryTag::Count); i++)
+		{
+			check(global.GetUsage(static_cast<MemoryTag>(i)).current == 0, std::string(Experiment::ToString(static_cast<MemoryTag>(i))) + " are released");
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Runs a session through the frame loop of the experiment, as Game::Update and Controller::SetFlickerStereoViews drive it:
+	/// preloaded stimuli scheduled into alternating texture sets on each response, uploads flushed within the slack of each
+	/// frame, the screens drawn by the CPU renderer with tracing enabled, and each present reported as Controller::Presented
+	/// does, to the trial monitor, the watchdog and the session log. Fails if any frame or trial switch after the first trial
+	/// allocates from the heap, as counted by the operator new above
+	int Allocations(int argc, char** argv)
+	{
+		const auto trials = argc > 0 ? std::stoi(argv[0]) : 20;
+		const auto threads = argc > 1 ? static_cast<unsigned>(std::stoi(argv[1])) : 0u;
+
+		using Clock = Experiment::UploadScheduler::Clock;
+		const auto dims = Experiment::Configuration::ImageDimensions;
+		const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(Experiment::Configuration::FlickerRate));
+		const auto budget = std::chrono::duration_cast<Clock::duration>(Experiment::Configuration::FrameBudget);
+		const auto transition = std::chrono::duration_cast<Clock::duration>(Experiment::Configuration::ImageTransitionDuration);
+
+		Experiment::Trace::Enable();
+
+		Experiment::CpuRenderer::Settings rendererSettings;
+		rendererSettings.threads = threads;
+		Experiment::CpuRenderer renderer(rendererSettings);
+
+		Clock::time_point now = {};
+
+		MockUploadDevice device(1);
+		Experiment::UploadRing ring(device, Experiment::Configuration::UploadSlots, dims.x, dims.y);
+
+		Experiment::UploadScheduler::Settings settings;
+		settings.bandRows = Experiment::Configuration::UploadBandRows;
+		settings.framePeriod = period;
+		Experiment::UploadScheduler scheduler(ring, settings, [&] { return now; });
+
+		// what the session loads up front: the preloaded stimuli, the two texture sets they are uploaded into, and the static screens
+		const auto source = SyntheticFrame(3840, 2160);
+		const auto black = SyntheticFrame(3840, 2160);
+
+		std::vector<std::vector<std::uint16_t>> targets(8, std::vector<std::uint16_t>(static_cast<std::size_t>(dims.x) * dims.y * 4));
+
+		// the mock device uploads into `targets`, so the textures drawn only stand in for those of the GPU
+		std::array<std::shared_ptr<const Experiment::ITexture>, 2> sets;
+		for (auto& set : sets)
+		{
+			const auto slice = Experiment::ConstRgba16View(black).Crop(0, 0, dims.x, dims.y);
+			const std::array<Experiment::ConstRgba16View, 4> slices = { slice, slice, slice, slice };
+			set = renderer.CreateTextureArray(slices.data(), slices.size());
+		}
+
+		const auto screen = [&](const Experiment::Frame& frame)
+		{
+			const auto texture = renderer.CreateTexture(Experiment::ConstRgba16View(frame));
+			return Experiment::Scene::ComposeStaticStereoView(texture, texture);
+		};
+
+		Experiment::Scene::StaticScreens screens;
+		screens.start = screen(source);
+		screens.transition = screen(black);
+		screens.response = screen(source);
+
+		std::vector<Experiment::Trial> run(trials);
+		for (auto t = 0; t < trials; t++)
+		{
+			run[t].correctOption = t % 2 == 0 ? Experiment::Option::Left : Experiment::Option::Right;
+		}
+
+		std::pair<Experiment::DuoView, Experiment::DuoView> stereoViews;
+		std::size_t set = 0;
+		auto lastRender = Clock::duration{};
+
+		// what Controller::Presented reports each frame to. The session runs faster or slower than real time, so the watchdog
+		// only takes the heartbeats: a stall would snapshot the trace on its own thread, which is no allocation of a frame
+		Experiment::TrialMonitor monitor(period, transition);
+
+		Experiment::Watchdog::Settings watchdogSettings;
+		watchdogSettings.deadline = std::chrono::minutes(1);
+
+		// the watchdog thread allocates its trace buffer when it starts, which is not to be counted against a frame
+		const auto traced = Experiment::Trace::GetStatistics().threads;
+		Experiment::Watchdog watchdog(watchdogSettings);
+		while (Experiment::Trace::GetStatistics().threads == traced) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		Experiment::Run session;
+		session.trials = run;
+
+		const auto logPath = std::filesystem::temp_directory_path() / "ppm-experiment-allocations.ppmlog";
+		std::optional<Experiment::SessionLog::Recorder> recorder;
+		recorder.emplace(logPath, session, true, [&] { return now; });
+
+		const auto switchTrial = [&](const int t)
+		{
+			recorder->Loaded(t);
+
+			set ^= 1;
+
+			const auto deadline = now + transition;
+			for (std::size_t i = 0; i < 4; i++)
+			{
+				const auto stimulus = Experiment::ConstRgba16View(source).Crop(static_cast<int>((t * 97 + i * 13) % (3840 - dims.x)), static_cast<int>((t * 31 + i * 7) % (2160 - dims.y)), dims.x, dims.y);
+				scheduler.Schedule(stimulus, &targets[set * 4 + i], deadline);
+			}
+
+			stereoViews = Experiment::Scene::ComposeFlickerStereoViews(run[t], sets[set]);
+		};
+
+		// a frame of Game::Update
+		auto flicker = false;
+		const auto frame = [&](const Experiment::Scene::Screen shown, const float progress, const std::chrono::milliseconds elapsed)
+		{
+			if (shown == Experiment::Scene::Screen::Stimuli) scheduler.Finish();
+
+			scheduler.Run(budget > lastRender ? budget - lastRender : Clock::duration{});
+
+			const auto start = std::chrono::steady_clock::now();
+
+			renderer.Begin();
+			Experiment::Scene::Draw(renderer, shown, screens, flicker ? stereoViews.first : stereoViews.second, progress);
+			renderer.End();
+
+			lastRender = std::chrono::steady_clock::now() - start;
+
+			TRACE_SCOPE("present", "Present");
+			renderer.Present();
+			device.Present();
+
+			monitor.Presented(shown, now);
+			watchdog.Beat();
+			recorder->Presented(shown, elapsed);
+
+			if (shown == Experiment::Scene::Screen::Stimuli) flicker = !flicker;
+			now += period;
+		};
+
+		std::size_t frames = 0, warmup = 0, steady = 0;
+
+		for (auto i = 0; i <= 4; i++)
+		{
+			frame(Experiment::Scene::ScreenAt(false, {}), i / 4.0f, {});
+		}
+
+		recorder->Started();
+
+		for (auto t = 0; t < trials; t++)
+		{
+			// the first trial fills what is only allocated once: the trace buffers, and the capacity of the queues
+			const auto before = g_allocations.load();
+
+			switchTrial(t);
+
+			const auto answered = t % 3 == 2 ? Experiment::Configuration::ImageTimeoutDuration + transition + std::chrono::seconds(1) : std::chrono::milliseconds(1500);
+
+			for (Clock::duration elapsed = {}; elapsed < answered; elapsed += period)
+			{
+				frame(Experiment::Scene::ScreenAt(true, elapsed), 1.0f, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed));
+				frames++;
+			}
+
+			recorder->Answered(run[t].correctOption);
+
+			(t == 0 ? warmup : steady) += g_allocations.load() - before;
+		}
+
+		const auto logged = recorder->Entries();
+		recorder.reset();
+		std::filesystem::remove(logPath);
+
+		std::cout << frames << " frames of " << trials << " trials: " << warmup << " allocations in the first trial, " << steady << " after it"
+			<< " (" << scheduler.GetStatistics() << ", watchdog: " << watchdog.GetStatistics() << ", session log: " << logged << " entries)" << std::endl;
+
+		// over-aligned allocations go through operators of their own, which must be counted as well
+		struct alignas(128) Line
+		{
+			std::uint8_t bytes[128];
+		};
+
+		const auto before = g_allocations.load();
+		auto aligned = false;
+		{
+			const std::vector<Line> lines(2);
+			aligned = reinterpret_cast<std::uintptr_t>(lines.data()) % alignof(Line) == 0;
+		}
+
+		const auto alignedCounted = aligned && g_allocations.load() - before == 1;
+		if (!alignedCounted) std::cerr << "FAILED: an over-aligned allocation is aligned and counted" << std::endl;
+
+		const auto ok = steady == 0 && alignedCounted;
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Checks the performance record of a trial: the transition, flicker frames and missed deadlines the trial monitor measures
+	/// from a timeline of presents, the read and decode times of Ppm::Read, and the columns Run::Export writes for them
+	int Performance(int, char**)
+	{
+		using Clock = Experiment::TrialMonitor::Clock;
+		using Screen = Experiment::Scene::Screen;
+		using std::chrono::milliseconds;
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		Experiment::TrialMonitor monitor(milliseconds(100), milliseconds(500));
+
+		const Clock::time_point start = {};
+		Experiment::TrialPerformance performance;
+
+		// six black frames, then the stimuli a frame late, and one of them a whole period late
+		for (auto t = 0; t < 600; t += 100) monitor.Presented(Screen::Transition, start + milliseconds(t));
+		for (const auto t : { 700, 800, 900, 1100, 1200, 1300 }) monitor.Presented(Screen::Stimuli, start + milliseconds(t));
+
+		monitor.Record(performance);
+		check(performance.transitionMilliseconds == 700.0, "the transition lasts from its first black frame to the first stimuli");
+		check(performance.flickerFrames == 6, "every stimuli frame is counted");
+		check(performance.missedDeadlines == 3, "the flicker is due from its first frame, and the skipped frame and those after it, which never catch up, miss their deadlines");
+
+		// the response screen, and the next trial on time
+		monitor.Presented(Screen::Response, start + milliseconds(1350));
+		for (auto t = 1400; t < 1900; t += 100) monitor.Presented(Screen::Transition, start + milliseconds(t));
+		for (auto t = 1900; t < 2500; t += 100) monitor.Presented(Screen::Stimuli, start + milliseconds(t + 20));
+
+		monitor.Record(performance);
+		check(performance.transitionMilliseconds == 520.0 && performance.flickerFrames == 6 && performance.missedDeadlines == 0, "a transition starts a new trial");
+
+		// frames which each take a little longer than a period, as a flicker timer waiting a period from the end of each frame
+		// shows them, drift off the schedule: 15 ms a frame is more than half a period behind from the fourth frame after the first
+		{
+			Experiment::TrialMonitor drifting(milliseconds(100), milliseconds(500));
+
+			for (auto frame = 0; frame < 6; frame++) drifting.Presented(Screen::Transition, start + milliseconds(frame * 115));
+			for (auto frame = 6; frame < 36; frame++) drifting.Presented(Screen::Stimuli, start + milliseconds(frame * 115));
+
+			Experiment::TrialPerformance drift;
+			drifting.Record(drift);
+			check(drift.flickerFrames == 30 && drift.missedDeadlines == 26, "a steady drift misses every deadline once it is half a period behind");
+		}
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-performance";
+		std::filesystem::create_directories(directory);
+
+		Experiment::Ppm::Write(directory / "image.ppm", SyntheticFrame(3840, 2160));
+
+		Experiment::Ppm::Timings timings;
+		const auto frame = Experiment::Ppm::Read(directory / "image.ppm", nullptr, &timings);
+		const auto readMs = std::chrono::duration<double, std::milli>(timings.read).count();
+		const auto decodeMs = std::chrono::duration<double, std::milli>(timings.decode).count();
+
+		std::cout << "read: " << readMs << " ms, decode: " << decodeMs << " ms" << std::endl;
+		check(timings.read.count() > 0 && timings.decode.count() > 0, "Ppm::Read times its read and its decode");
+
+		Experiment::Run run;
+		run.trials.resize(2);
+		run.trials[0].participantResponse = Experiment::Option::Left;
+		run.trials[0].performance = performance;
+		run.trials[0].performance.readMilliseconds = readMs;
+
+		run.Export(directory / "results.csv");
+
+		std::ifstream file(directory / "results.csv");
+		std::vector<std::string> lines;
+		for (std::string line; std::getline(file, line); ) lines.push_back(line);
+
+		std::filesystem::remove_all(directory);
+
+		const auto columns = [](const std::string& line) { return std::count(line.begin(), line.end(), ',') + 1; };
+
+		// the participant, the header, and the one trial with a response
+		check(lines.size() == 4, "the trials with a response are exported");
+		if (lines.size() == 4)
+		{
+			std::cout << lines[2] << "\n" << lines[3] << std::endl;
+			check(lines[2].find("Missed Deadlines") != std::string::npos && columns(lines[2]) == columns(lines[3]), "every exported column has a header");
+			check(lines[3].find(", 520, 6, 0") != std::string::npos, "the performance of a trial is exported");
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Writes a P6 image of a gradient with `bits` per channel, a row at a time, and flushes it to disk so that it can be
+	/// evicted from the page cache
+	void WriteSyntheticPpm(const std::filesystem::path& path, const int width, const int height, const int bits)
+	{
+		const auto bytes = bits > 8 ? 2 : 1;
+
+		{
+			std::ofstream file(path, std::ios::binary);
+			file << "P6\n" << width << " " << height << "\n" << (bits > 8 ? 65535 : 255) << "\n";
+
+			std::vector<std::uint8_t> row(static_cast<std::size_t>(width) * 3 * bytes);
+			for (auto y = 0; y < height; y++)
+			{
+				for (auto x = 0; x < width; x++)
+				{
+					const std::uint16_t rgb[] = { static_cast<std::uint16_t>(x * 17), static_cast<std::uint16_t>(y * 29), static_cast<std::uint16_t>((x + y) * 7) };
+					for (auto c = 0; c < 3; c++)
+					{
+						// 8-bit samples keep the low byte; 16-bit samples are big endian
+						auto* sample = &row[(static_cast<std::size_t>(x) * 3 + c) * bytes];
+						if (bytes == 1) sample[0] = static_cast<std::uint8_t>(rgb[c]);
+						else sample[0] = static_cast<std::uint8_t>(rgb[c] >> 8), sample[1] = static_cast<std::uint8_t>(rgb[c]);
+					}
+				}
+
+				file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+			}
+
+			if (!file) throw std::runtime_error("cannot write " + path.generic_string());
+		}
+
+		const auto fd = open(path.c_str(), O_RDONLY);
+		fdatasync(fd);
+		close(fd);
+	}
+
+	/// Evicts a file from the page cache, so that the next read comes from the disk. Returns false if the kernel refused
+	bool EvictFromPageCache(const std::filesystem::path& path)
+	{
+		const auto fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+
+		const auto evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(fd);
+
+		return evicted;
+	}
+
+	/// Times each stage of loading a stimulus, at 1080p, 4K and 8K and from 8 and 16-bit PPMs: reading the file from a cold
+	/// and a warm page cache, decoding it natively, the BGR to RGBA swizzle of the OpenCV path, the crop copy strided uploads
+	/// replaced, the fused decode of a crop, the ST.2084 tone map of a crop into a texture of the CPU renderer, the copy into a
+	/// staging slot of the upload ring, and Ppm::Read end to end. Reports the median and 99th percentile of `repeats` runs, the
+	/// throughput and, where perf_event_open allows, the instructions per cycle, bytes per cycle, LLC and dTLB misses per MB and
+	/// page faults per run. Appends them to `results` as CSV rows labelled `label` (a version, say), so that results of versions
+	/// can be compared
+	int Stages(int argc, char** argv)
+	{
+		const auto repeats = argc > 0 ? std::max(std::stoi(argv[0]), 1) : 10;
+		const auto results = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::path();
+		const auto label = argc > 2 ? std::string(argv[2]) : std::string("current");
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		struct Resolution
+		{
+			const char* name;
+			int width;
+			int height;
+		};
+
+		const Resolution resolutions[] = { { "1080p", 1920, 1080 }, { "4K", 3840, 2160 }, { "8K", 7680, 4320 } };
+
+		struct Result
+		{
+			std::string stage;
+			std::string resolution;
+			int bits;
+			std::string cache;
+			std::size_t bytes;
+			std::vector<double> milliseconds;
+
+			/// The sums over every run, empty for counters which are not available
+			PerfCounters::Values counters;
+
+			[[nodiscard]] double Percentile(const double p) const
+			{
+				return ::Percentile(milliseconds, p);
+			}
+
+			[[nodiscard]] std::optional<double> PerRun(const PerfCounters::Counter counter) const
+			{
+				if (!counters[counter]) return {};
+				return *counters[counter] / static_cast<double>(milliseconds.size());
+			}
+
+			[[nodiscard]] std::optional<double> PerMegabyte(const PerfCounters::Counter counter) const
+			{
+				if (!counters[counter]) return {};
+				return *counters[counter] / (static_cast<double>(bytes) * static_cast<double>(milliseconds.size()) / (1024 * 1024));
+			}
+
+			[[nodiscard]] std::optional<double> InstructionsPerCycle() const
+			{
+				if (!counters[PerfCounters::Instructions] || !counters[PerfCounters::Cycles] || *counters[PerfCounters::Cycles] == 0) return {};
+				return *counters[PerfCounters::Instructions] / *counters[PerfCounters::Cycles];
+			}
+
+			[[nodiscard]] std::optional<double> BytesPerCycle() const
+			{
+				if (!counters[PerfCounters::Cycles] || *counters[PerfCounters::Cycles] == 0) return {};
+				return static_cast<double>(bytes) * static_cast<double>(milliseconds.size()) / *counters[PerfCounters::Cycles];
+			}
+
+			[[nodiscard]] double MegabytesPerSecond() const
+			{
+				return static_cast<double>(bytes) / (1024 * 1024) / (Percentile(50) / 1000);
+			}
+		};
+
+		std::vector<Result> measured;
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-stages";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+
+		auto evicted = true;
+
+		PerfCounters counters;
+
+		std::string available, unavailable;
+		for (auto i = 0; i < PerfCounters::Count; i++)
+		{
+			const auto counter = static_cast<PerfCounters::Counter>(i);
+			auto& list = counters.IsAvailable(counter) ? available : unavailable;
+			list += (list.empty() ? "" : ", ") + std::string(PerfCounters::Name(counter));
+		}
+
+		std::cout << "counters: " << (available.empty() ? "none" : available) << (unavailable.empty() ? "" : " (unavailable: " + unavailable + ")") << std::endl;
+
+		// a counter which is not available is shown as a dash
+		const auto print = [](const std::optional<double>& value, const int precision)
+		{
+			std::ostringstream text;
+			if (value) text << std::fixed << std::setprecision(precision) << *value;
+			else text << "-";
+			return text.str();
+		};
+
+		std::cout << std::left << std::setw(14) << "stage" << std::setw(7) << "size" << std::setw(6) << "bits" << std::setw(8) << "cache"
+			<< std::right << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "MB/s"
+			<< std::setw(7) << "IPC" << std::setw(8) << "B/cycle" << std::setw(9) << "LLC/MB" << std::setw(9) << "dTLB/MB" << std::setw(8) << "faults" << std::endl;
+
+		for (const auto& resolution : resolutions)
+		{
+			for (const auto bits : { 8, 16 })
+			{
+				const auto path = directory / (std::string(resolution.name) + "_" + std::to_string(bits) + ".ppm");
+				WriteSyntheticPpm(path, resolution.width, resolution.height, bits);
+
+				const auto fileBytes = static_cast<std::size_t>(std::filesystem::file_size(path));
+				const auto frameBytes = static_cast<std::size_t>(resolution.width) * resolution.height * 8;
+				const auto cropBytes = static_cast<std::size_t>(dims.x) * dims.y * 8;
+				const auto x = (resolution.width - dims.x) / 2, y = (resolution.height - dims.y) / 2;
+
+				Experiment::Arena arena(fileBytes + (std::size_t(1) << 20));
+
+				// runs `run` `repeats` times after `prepare`, which is not timed
+				const auto time = [&](const char* stage, const char* cache, const std::size_t bytes, const std::function<void()>& prepare, const std::function<void()>& run)
+				{
+					Result result{ stage, resolution.name, bits, cache, bytes, {}, {} };
+
+					for (auto i = 0; i < repeats; i++)
+					{
+						prepare();
+
+						// the counters are started and read outside of the timed region
+						counters.Start();
+						const auto start = std::chrono::steady_clock::now();
+						run();
+						const auto end = std::chrono::steady_clock::now();
+						const auto values = counters.Stop();
+
+						result.milliseconds.push_back(Milliseconds(end - start).count());
+
+						for (auto c = 0; c < PerfCounters::Count; c++)
+						{
+							if (values[c]) result.counters[c] = result.counters[c].value_or(0.0) + *values[c];
+						}
+					}
+
+					std::cout << std::left << std::setw(14) << result.stage << std::setw(7) << result.resolution << std::setw(6) << result.bits << std::setw(8) << result.cache
+						<< std::right << std::fixed << std::setprecision(2) << std::setw(10) << result.Percentile(50) << std::setw(10) << result.Percentile(99)
+						<< std::setprecision(0) << std::setw(10) << result.MegabytesPerSecond() << std::defaultfloat << std::setprecision(6)
+						<< std::setw(7) << print(result.InstructionsPerCycle(), 2) << std::setw(8) << print(result.BytesPerCycle(), 2)
+						<< std::setw(9) << print(result.PerMegabyte(PerfCounters::LlcMisses), 0) << std::setw(9) << print(result.PerMegabyte(PerfCounters::DtlbMisses), 0)
+						<< std::setw(8) << print(result.PerRun(PerfCounters::PageFaults), 0) << std::endl;
+
+					measured.push_back(std::move(result));
+				};
+
+				const auto cold = [&] { evicted &= EvictFromPageCache(path); arena.Reset(); };
+				const auto warm = [&] { arena.Reset(); };
+				const auto nothing = [] {};
+
+				std::size_t size = 0;
+				const std::uint8_t* file = nullptr;
+				const auto read = [&] { file = Experiment::Ppm::ReadFile(path, arena, size); };
+
+				time("read", "cold", fileBytes, cold, read);
+				time("read", "warm", fileBytes, warm, read);
+
+				arena.Reset();
+				read();
+
+				const auto header = Experiment::Ppm::ReadHeader(file, size);
+
+				std::vector<std::uint16_t> frame(frameBytes / sizeof(std::uint16_t));
+				const Experiment::Rgba16View whole(frame.data(), resolution.width, resolution.height);
+
+				time("decode", "memory", fileBytes, nothing, [&] { Experiment::Ppm::Decode(file, size, whole); });
+
+				// 8-bit samples are brought to the full range, 255 becoming 65535
+				check(whole(5, 3)[1] == (bits > 8 ? 3 * 29 : (3 * 29 & 0xFF) * 257) && whole(5, 3)[2] == (bits > 8 ? 8 * 7 : (8 * 7 & 0xFF) * 257) && whole(5, 3)[3] == 0xFFFF,
+					std::string(resolution.name) + " " + std::to_string(bits) + "-bit: decoded pixels");
+
+				// the pixels of the file as OpenCV would have decoded them, in BGR order
+				Experiment::Pixels::SourceImage source = {};
+				source.data = file + header.dataOffset;
+				source.width = resolution.width;
+				source.height = resolution.height;
+				source.stride = static_cast<std::size_t>(resolution.width) * 3 * header.BytesPerChannel();
+				source.format = bits > 8 ? Experiment::Pixels::SourceFormat::Uint16 : Experiment::Pixels::SourceFormat::Uint8;
+				source.maxval = header.maxval;
+				source.order = Experiment::Pixels::ChannelOrder::Bgr;
+
+				Experiment::Pixels::DestinationImage destination = {};
+				destination.data = reinterpret_cast<std::uint8_t*>(frame.data());
+				destination.width = resolution.width;
+				destination.height = resolution.height;
+				destination.stride = static_cast<std::size_t>(resolution.width) * 8;
+
+				time("swizzle", "memory", fileBytes - header.dataOffset, nothing, [&] { Experiment::Pixels::Convert(source, 0, 0, destination, Experiment::Pixels::FullRange(source)); });
+
+				// the swizzle left the frame in BGR order and native endianness, so decode it again for the crops to compare with
+				Experiment::Ppm::Decode(file, size, whole);
+
+				std::vector<std::uint16_t> crop(cropBytes / sizeof(std::uint16_t));
+				const Experiment::Rgba16View cropView(crop.data(), dims.x, dims.y);
+				const auto region = Experiment::ConstRgba16View(whole).Crop(x, y, dims.x, dims.y);
+
+				time("crop", "memory", cropBytes, nothing, [&] { Experiment::CopyPixels(region, cropView); });
+
+				std::vector<std::uint16_t> fused(cropBytes / sizeof(std::uint16_t));
+				const Experiment::Rgba16View fusedView(fused.data(), dims.x, dims.y);
+
+				time("decode crop", "memory", cropBytes, nothing, [&] { Experiment::Ppm::Decode(file, size, fusedView, x, y); });
+
+				// the textures of the CPU renderer hold tone mapped pixels, on the calling thread only so that it counts all of it
+				Experiment::CpuRenderer::Settings single;
+				single.threads = 1;
+				Experiment::CpuRenderer renderer(single);
+				std::shared_ptr<const Experiment::ITexture> toneMapped;
+
+				time("pq", "memory", cropBytes, [&] { toneMapped.reset(); }, [&] { toneMapped = renderer.CreateTexture(Experiment::ConstRgba16View(fused.data(), dims.x, dims.y)); });
+				toneMapped.reset();
+
+				check(fused == crop, std::string(resolution.name) + " " + std::to_string(bits) + "-bit: the fused decode of a crop matches the crop of the decode");
+
+				// the CPU copy of an upload, into a staging slot; the device copies it to the texture on its next frame
+				MockUploadDevice device(1);
+				Experiment::UploadRing ring(device, Experiment::Configuration::UploadSlots, dims.x, dims.y);
+				std::vector<std::uint16_t> texture(cropBytes / sizeof(std::uint16_t));
+
+				time("upload", "memory", cropBytes, [&] { device.Present(); ring.Flush(); }, [&] { ring.Enqueue(region, &texture); ring.Flush(); });
+
+				device.Present();
+				check(texture == crop, std::string(resolution.name) + " " + std::to_string(bits) + "-bit: the upload lands in the texture");
+
+				const auto load = [&] { static_cast<void>(Experiment::Ppm::Read(path, &arena)); };
+
+				time("load", "cold", fileBytes, cold, load);
+				time("load", "warm", fileBytes, warm, load);
+
+				std::filesystem::remove(path);
+			}
+		}
+
+		std::filesystem::remove_all(directory);
+
+		if (!evicted)
+		{
+			std::cout << "the page cache could not be dropped, so cold runs may have been warm" << std::endl;
+		}
+
+		if (!results.empty())
+		{
+			const auto exists = std::filesystem::exists(results) && std::filesystem::file_size(results) > 0;
+
+			std::ofstream csv(results, std::ios::app);
+			if (!exists) csv << "label,stage,resolution,bits,cache,runs,bytes,p50_ms,p99_ms,mb_per_s,ipc,bytes_per_cycle,llc_misses_per_mb,dtlb_misses_per_mb,page_faults\n";
+
+			// counters which are not available are left empty
+			const auto field = [](const std::optional<double>& value) { return value ? std::to_string(*value) : std::string(); };
+
+			for (const auto& result : measured)
+			{
+				csv << label << "," << result.stage << "," << result.resolution << "," << result.bits << "," << result.cache << "," << result.milliseconds.size()
+					<< "," << result.bytes << "," << result.Percentile(50) << "," << result.Percentile(99) << "," << result.MegabytesPerSecond()
+					<< "," << field(result.InstructionsPerCycle()) << "," << field(result.BytesPerCycle()) << "," << field(result.PerMegabyte(PerfCounters::LlcMisses))
+					<< "," << field(result.PerMegabyte(PerfCounters::DtlbMisses)) << "," << field(result.PerRun(PerfCounters::PageFaults)) << "\n";
+			}
+
+			check(static_cast<bool>(csv), "the results are written to " + results.generic_string());
+			std::cout << "appended " << measured.size() << " results to " << results.generic_string() << std::endl;
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// A session as Game and Controller run it, headless: the stimuli, preloaded or streamed, are uploaded by the upload
+	/// scheduler to a mock GPU, and the frames of each screen drawn by the CPU renderer. Only waits (for a vertical blank, or
+	/// for the participant) are skipped, so its clock is the real one plus the time skipped
+	class HeadlessSession
+	{
+	public:
+		using Clock = Experiment::UploadScheduler::Clock;
+
+		/// Preloads the stimuli of `run`, waiting for them as the start screen does, or streams them per trial
+		HeadlessSession(const Experiment::Run& run, const bool preload) :
+			m_run(run),
+			m_renderer(Experiment::CpuRenderer::Settings{}),
+			m_cache(Experiment::Configuration::ImageCacheBytes),
+			m_device(1),
+			m_ring(m_device, Experiment::Configuration::UploadSlots, Dimensions().x, Dimensions().y),
+			m_scheduler(m_ring, SchedulerSettings(), [this] { return Now(); }),
+			m_targets(8, std::vector<std::uint16_t>(static_cast<std::size_t>(Dimensions().x) * Dimensions().y * 4)),
+			m_black(SyntheticFrame(3840, 2160)),
+			m_monitor(Period(), std::chrono::duration_cast<Clock::duration>(Experiment::Configuration::ImageTransitionDuration)),
+			m_epoch(Now())
+		{
+			const auto dims = Dimensions();
+
+			// the mock device uploads into `m_targets`, so the textures drawn only stand in for those of the GPU
+			for (auto& set : m_sets)
+			{
+				const auto slice = Experiment::ConstRgba16View(m_black).Crop(0, 0, dims.x, dims.y);
+				const std::array<Experiment::ConstRgba16View, 4> slices = { slice, slice, slice, slice };
+				set = m_renderer.CreateTextureArray(slices.data(), slices.size());
+			}
+
+			const auto blackTexture = m_renderer.CreateTexture(Experiment::ConstRgba16View(m_black));
+			m_screens.start = m_screens.transition = m_screens.response = Experiment::Scene::ComposeStaticStereoView(blackTexture, blackTexture);
+
+			// Controller::StartPreload
+			if (preload)
+			{
+				m_preloader = std::make_unique<Experiment::Preloader>(m_run.trials.size() * 4, dims.x, dims.y, [this](const std::size_t index, Experiment::Frame& slot)
+					{
+						const auto& trial = m_run.trials[index / 4];
+						const auto frame = Get(Experiment::Scene::StimulusPaths(trial)[index % 4]);
+						Experiment::CopyPixels(Experiment::ConstRgba16View(*frame).Crop(trial.position.x, trial.position.y, slot.width, slot.height), Experiment::Rgba16View(slot));
+					});
+
+				m_preloader->Start();
+				m_preloader->Wait();
+			}
+
+			m_epoch = Now();
+		}
+
+		[[nodiscard]] static Experiment::Vector Dimensions() { return Experiment::Configuration::ImageDimensions; }
+
+		[[nodiscard]] static Clock::duration Period()
+		{
+			return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(Experiment::Configuration::FlickerRate));
+		}
+
+		[[nodiscard]] Clock::time_point Now() const { return Clock::now() + m_skipped; }
+
+		void WaitUntil(const Clock::time_point t) { m_skipped += std::max(t - Now(), Clock::duration{}); }
+
+		/// Controller::SetFlickerStereoViews, scheduling the stimuli of trial `t` to be uploaded by the end of the transition
+		void Load(const int t)
+		{
+			const auto dims = Dimensions();
+			const auto& trial = m_run.trials[t];
+			m_set ^= 1;
+
+			const auto deadline = Now() + Experiment::Configuration::ImageTransitionDuration;
+			const auto paths = Experiment::Scene::StimulusPaths(trial);
+
+			for (std::size_t i = 0; i < 4; i++)
+			{
+				if (m_preloader)
+				{
+					m_scheduler.Schedule(Experiment::ConstRgba16View(*m_preloader->Get(static_cast<std::size_t>(t) * 4 + i)), &m_targets[m_set * 4 + i], deadline);
+				}
+				else
+				{
+					const auto frame = Get(paths[i]);
+					m_scheduler.Schedule(Experiment::ConstRgba16View(*frame).Crop(trial.position.x, trial.position.y, dims.x, dims.y), &m_targets[m_set * 4 + i], deadline, frame);
+				}
+			}
+
+			m_stereoViews = Experiment::Scene::ComposeFlickerStereoViews(trial, m_sets[m_set]);
+		}
+
+		/// Game::Update, drawing a frame of `screen` and presenting it at the next vertical blank
+		void Update(const Experiment::Scene::Screen screen)
+		{
+			using Screen = Experiment::Scene::Screen;
+
+			const auto budget = std::chrono::duration_cast<Clock::duration>(Experiment::Configuration::FrameBudget);
+			const auto refresh = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60));
+
+			if (screen == Screen::Stimuli) m_scheduler.Finish();
+			m_scheduler.Run(budget > m_lastRender ? budget - m_lastRender : Clock::duration{});
+
+			const auto start = Now();
+
+			m_renderer.Begin();
+			Experiment::Scene::Draw(m_renderer, screen, m_screens, m_flicker ? m_stereoViews.first : m_stereoViews.second);
+			m_renderer.End();
+
+			m_lastRender = Now() - start;
+
+			m_renderer.Present();
+			WaitUntil(m_epoch + ((Now() - m_epoch) / refresh + 1) * refresh);
+			m_device.Present();
+			m_monitor.Presented(screen, Now());
+
+			if (screen == Screen::Stimuli) m_flicker = !m_flicker;
+		}
+
+		/// The performance of the trial which has just been answered
+		void Record(Experiment::TrialPerformance& performance) { m_monitor.Record(performance); }
+
+		[[nodiscard]] Experiment::UploadScheduler::Statistics GetUploadStatistics() const { return m_scheduler.GetStatistics(); }
+
+	private:
+		static Experiment::UploadScheduler::Settings SchedulerSettings()
+		{
+			Experiment::UploadScheduler::Settings settings;
+			settings.bandRows = Experiment::Configuration::UploadBandRows;
+			settings.framePeriod = Period();
+			return settings;
+		}
+
+		std::shared_ptr<const Experiment::Frame> Get(const std::filesystem::path& path)
+		{
+			return m_cache.Get(path, [](const std::filesystem::path& p) { return Experiment::Ppm::Read(p); });
+		}
+
+		const Experiment::Run& m_run;
+
+		Clock::duration m_skipped = {};
+
+		Experiment::CpuRenderer m_renderer;
+		Experiment::ImageCache m_cache;
+
+		MockUploadDevice m_device;
+		Experiment::UploadRing m_ring;
+		Experiment::UploadScheduler m_scheduler;
+
+		std::vector<std::vector<std::uint16_t>> m_targets;
+
+		Experiment::Frame m_black;
+		std::array<std::shared_ptr<const Experiment::ITexture>, 2> m_sets;
+		Experiment::Scene::StaticScreens m_screens;
+
+		std::unique_ptr<Experiment::Preloader> m_preloader;
+
+		std::size_t m_set = 0;
+		std::pair<Experiment::DuoView, Experiment::DuoView> m_stereoViews;
+
+		Experiment::TrialMonitor m_monitor;
+
+		Clock::time_point m_epoch;
+		bool m_flicker = false;
+		Clock::duration m_lastRender = {};
+	};
+
+	/// A session of `trials` trials over a few synthetic 4K images written to `directory`, each a left and right original and
+	/// compressed frame, at random positions
+	Experiment::Run SyntheticRun(const std::filesystem::path& directory, const int trials)
+	{
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory / "original");
+		std::filesystem::create_directories(directory / "compressed");
+
+		constexpr auto images = 4;
+		const auto frame = SyntheticFrame(3840, 2160);
+
+		for (auto i = 0; i < images; i++)
+		{
+			for (const auto* side : { "_L", "_R" })
+			{
+				Experiment::Ppm::Write(directory / "original" / ("image" + std::to_string(i) + side + ".ppm"), frame);
+				Experiment::Ppm::Write(directory / "compressed" / ("image" + std::to_string(i) + side + ".ppm"), frame);
+			}
+		}
+
+		Experiment::Run run;
+
+		std::mt19937 random(7);
+		for (auto t = 0; t < trials; t++)
+		{
+			Experiment::Trial trial;
+			trial.originalDirectory = (directory / "original").string();
+			trial.decompressedDirectory = (directory / "compressed").string();
+			trial.imageName = "image" + std::to_string(t % images);
+			trial.correctOption = t % 2 == 0 ? Experiment::Option::Left : Experiment::Option::Right;
+			trial.position = { static_cast<int>(random() % (3840 - dims.x)), static_cast<int>(random() % (2160 - dims.y)) };
+			run.trials.push_back(trial);
+		}
+
+		return run;
+	}
+
+	/// Runs sessions of a HeadlessSession with a simulated participant, and reports the latency of trial switches as a
+	/// distribution: from a response to the first frame of the next trial, and to the first frame of its stimuli. The
+	/// participant answers `responseMs` (median) after the stimuli appear, and lets `timeoutPercent` of the trials time out to
+	/// the response screen first. The session is `session.csv`, whose images must exist, or `trials` trials over synthetic
+	/// 4K stimuli
+	int TrialSwitch(int argc, char** argv)
+	{
+		using Clock = HeadlessSession::Clock;
+		using Screen = Experiment::Scene::Screen;
+
+		const auto csv = argc > 0 && std::filesystem::path(argv[0]).extension() == ".csv";
+		const auto trials = argc > 0 && !csv ? std::stoi(argv[0]) : 20;
+		const auto responseMs = argc > 1 ? std::stod(argv[1]) : 1500.0;
+		const auto timeoutPercent = argc > 2 ? std::stoi(argv[2]) : 10;
+
+		const auto period = HeadlessSession::Period();
+		const auto transition = std::chrono::duration_cast<Clock::duration>(Experiment::Configuration::ImageTransitionDuration);
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-switch";
+		auto run = csv ? Experiment::Run::CreateRun(argv[0]) : SyntheticRun(directory, trials);
+
+		std::cout << "trial switches of " << run.size() << " trials, answered " << responseMs << " ms (median) after the stimuli, " << timeoutPercent << "% after a timeout" << std::endl;
+
+		for (const auto preload : { true, false })
+		{
+			HeadlessSession session(run, preload);
+			const auto now = [&] { return session.Now(); };
+
+			std::mt19937 random(11);
+			std::lognormal_distribution<double> reaction(std::log(responseMs), 0.35);
+
+			std::vector<double> firstFrame, stimuliLate, switchWork;
+			std::size_t transitionsFirst = 0, recorded = 0;
+
+			// the start press restarts the stopwatch, and Game::OnGamePadButton loads the first trial
+			session.Load(0);
+			auto nextFlicker = now();
+			auto trialStart = now();
+
+			// Game::Update, on the screen of the time since the last response
+			const auto update = [&]
+			{
+				const auto shown = Experiment::Scene::ScreenAt(true, now() - trialStart);
+				session.Update(shown);
+				return shown;
+			};
+
+			for (auto t = 0; t < run.size(); t++)
+			{
+				auto respondAt = Clock::time_point::max();
+				auto onset = Clock::time_point::max();
+				const auto timesOut = static_cast<int>(random() % 100) < timeoutPercent;
+				const auto answer = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(reaction(random)));
+
+				// the flicker timer, which ticks a period after the end of the last update, until the participant answers
+				while (respondAt > nextFlicker)
+				{
+					session.WaitUntil(nextFlicker);
+					const auto shown = update();
+					nextFlicker = now() + period;
+
+					if (shown == Screen::Stimuli && onset == Clock::time_point::max())
+					{
+						onset = now();
+						stimuliLate.push_back(Milliseconds(onset - trialStart - transition).count());
+						if (!timesOut) respondAt = onset + answer;
+					}
+
+					if (shown == Screen::Response && respondAt == Clock::time_point::max()) respondAt = now() + answer;
+				}
+
+				// Game::OnGamePadButton, as soon as the render thread is free: the response, the first frame of the next trial
+				// and the switch to it
+				session.WaitUntil(respondAt);
+				const auto responded = std::max(respondAt, now());
+
+				session.Record(run.trials[t].performance);
+				recorded += run.trials[t].performance.flickerFrames > 0 ? 1 : 0;
+
+				if (t + 1 == run.size()) break;
+
+				trialStart = now();
+				transitionsFirst += update() == Screen::Transition ? 1 : 0;
+				firstFrame.push_back(Milliseconds(now() - responded).count());
+
+				const auto start = now();
+				session.Load(t + 1);
+				switchWork.push_back(Milliseconds(now() - start).count());
+			}
+
+			const auto report = [&](const char* what, const std::vector<double>& values)
+			{
+				std::cout << std::fixed << std::setprecision(1) << "  " << what << ": p50 " << Percentile(values, 50) << " ms, p90 " << Percentile(values, 90)
+					<< " ms, p99 " << Percentile(values, 99) << " ms, max " << Percentile(values, 100) << " ms" << std::defaultfloat << std::setprecision(6) << std::endl;
+			};
+
+			std::size_t frames = 0, missed = 0;
+			for (const auto& trial : run.trials)
+			{
+				frames += trial.performance.flickerFrames;
+				missed += trial.performance.missedDeadlines;
+			}
+
+			std::cout << (preload ? "preloaded" : "streamed") << ", " << firstFrame.size() << " switches:" << std::endl;
+			report("response to the first frame of the next trial", firstFrame);
+			report("stimuli shown after the end of the transition", stimuliLate);
+			report("switching trials on the render thread", switchWork);
+			std::cout << "  missed flicker deadlines: " << missed << " of " << frames << " frames; " << session.GetUploadStatistics() << std::endl;
+
+			const std::string mode = preload ? "preloaded: " : "streamed: ";
+			check(firstFrame.size() + 1 == run.trials.size() && transitionsFirst == firstFrame.size(), mode + "each response is followed by the transition of the next trial");
+			check(recorded == run.trials.size(), mode + "each trial records its flicker frames");
+
+			if (preload)
+			{
+				check(Percentile(firstFrame, 99) < Milliseconds(period).count(), mode + "the next trial starts within a flicker period of a response");
+				check(Percentile(stimuliLate, 99) < Milliseconds(2 * period).count(), mode + "the stimuli follow the transition within two flicker periods");
+			}
+
+			for (auto& trial : run.trials) trial.performance = {};
+		}
+
+		if (!csv) std::filesystem::remove_all(directory);
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Replays session logs (see SessionLog.h) in a HeadlessSession, as fast as it renders: its frames are chosen on the
+	/// stopwatch readings of the log, the participant answers as logged, and the screens and loads of the replay are checked
+	/// to be those of the session. Reports the time frames and loads took, and how far the replay fell behind the session, and
+	/// appends them to `results.csv` as rows labelled `label`. Stimuli which are not on this machine are replaced by synthetic
+	/// 4K ones, which take as long to load. The logs are files or directories of them; without any, a synthetic session is
+	/// recorded with a simulated participant and replayed
+	int Replay(int argc, char** argv)
+	{
+		using Clock = HeadlessSession::Clock;
+		using Entry = Experiment::SessionLog::Entry;
+		using Screen = Experiment::Scene::Screen;
+
+		std::vector<std::filesystem::path> logs;
+		std::filesystem::path results;
+		std::string label = "current";
+
+		for (auto i = 0; i < argc; i++)
+		{
+			const std::filesystem::path argument = argv[i];
+
+			if (argument.extension() == ".csv")
+			{
+				results = argument;
+				if (i + 1 < argc) label = argv[i + 1];
+				break;
+			}
+
+			if (!std::filesystem::is_directory(argument))
+			{
+				logs.push_back(argument);
+				continue;
+			}
+
+			const auto first = logs.size();
+			for (const auto& file : std::filesystem::directory_iterator(argument))
+			{
+				if (file.path().extension() == ".ppmlog") logs.push_back(file.path());
+			}
+
+			std::sort(logs.begin() + static_cast<std::ptrdiff_t>(first), logs.end());
+		}
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-replay";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+
+		struct Result
+		{
+			std::string log;
+			std::size_t trials = 0;
+			bool preloaded = false;
+			std::vector<double> frames, loads;
+			double behind = 0.0;
+			bool identical = false;
+		};
+
+		std::vector<Result> measured;
+
+		const auto replay = [&](const std::filesystem::path& path)
+		{
+			const auto log = Experiment::SessionLog::Read(path);
+			auto run = log.run;
+
+			// stimuli recorded on another machine are stood in for by synthetic ones, one per image name
+			const auto stimuli = directory / "stimuli";
+			std::size_t substituted = 0;
+
+			for (auto& trial : run.trials)
+			{
+				if (std::filesystem::is_directory(trial.originalDirectory) && std::filesystem::is_directory(trial.decompressedDirectory)) continue;
+
+				trial.originalDirectory = (stimuli / "original").string();
+				trial.decompressedDirectory = (stimuli / "compressed").string();
+				substituted++;
+
+				for (const auto* kind : { "original", "compressed" })
+				{
+					for (const auto* side : { "_L", "_R" })
+					{
+						const auto image = stimuli / kind / (trial.imageName + side + ".ppm");
+						if (std::filesystem::exists(image)) continue;
+
+						std::filesystem::create_directories(image.parent_path());
+						Experiment::Ppm::Write(image, SyntheticFrame(3840, 2160));
+					}
+				}
+			}
+
+			Result result;
+			result.log = path.filename().string();
+			result.trials = run.trials.size();
+			result.preloaded = log.preloaded;
+
+			std::cout << result.log << ": " << run.size() << " trials, " << (log.preloaded ? "preloaded" : "streamed") << ", " << log.entries.size() << " entries"
+				<< (log.truncated ? ", truncated" : "") << (substituted > 0 ? ", " + std::to_string(substituted) + " trials on synthetic stimuli" : "") << std::endl;
+
+			HeadlessSession session(run, log.preloaded);
+			const auto now = [&] { return session.Now(); };
+
+			// the decisions of the replay, to compare with those logged
+			std::vector<Entry> replayed;
+
+			const auto origin = now() - (log.entries.empty() ? Clock::duration{} : log.entries.front().time);
+
+			auto started = false;
+			auto switching = false;
+			auto current = 0;
+
+			for (const auto& entry : log.entries)
+			{
+				session.WaitUntil(origin + entry.time);
+				result.behind = std::max(result.behind, Milliseconds(now() - (origin + entry.time)).count());
+
+				switch (entry.kind)
+				{
+				case Entry::Kind::Start:
+				{
+					// Game::OnGamePadButton loads the first trial once the session starts
+					if (!started)
+					{
+						const auto start = now();
+						session.Load(0);
+						result.loads.push_back(Milliseconds(now() - start).count());
+						replayed.push_back({ Entry::Kind::Load, entry.time, 0, {} });
+					}
+
+					started = true;
+					break;
+				}
+
+				case Entry::Kind::Response:
+					run.trials[current].participantResponse = static_cast<Experiment::Option>(entry.value);
+					session.Record(run.trials[current].performance);
+
+					// Game::OnGamePadButton draws a frame, then loads the next trial
+					switching = current + 1 < run.size();
+					break;
+
+				case Entry::Kind::Frame:
+				{
+					const auto screen = Experiment::Scene::ScreenAt(started, entry.elapsed);
+
+					// on the real clock, which leaves out the skipped wait for the vertical blank
+					const auto work = Clock::now();
+					session.Update(screen);
+					result.frames.push_back(Milliseconds(Clock::now() - work).count());
+					replayed.push_back({ Entry::Kind::Frame, entry.time, static_cast<int>(screen), entry.elapsed });
+
+					if (switching)
+					{
+						switching = false;
+
+						const auto start = now();
+						session.Load(++current);
+						result.loads.push_back(Milliseconds(now() - start).count());
+						replayed.push_back({ Entry::Kind::Load, entry.time, current, {} });
+					}
+
+					break;
+				}
+
+				case Entry::Kind::Load:
+					break;
+				}
+			}
+
+			// the screens and loads logged, which the replay must have decided alike
+			std::vector<Entry> logged;
+			std::copy_if(log.entries.begin(), log.entries.end(), std::back_inserter(logged), [](const Entry& e) { return e.kind == Entry::Kind::Frame || e.kind == Entry::Kind::Load; });
+
+			const auto same = [](const Entry& a, const Entry& b) { return a.kind == b.kind && a.value == b.value; };
+			const auto divergence = std::mismatch(logged.begin(), logged.end(), replayed.begin(), replayed.end(), same);
+
+			result.identical = divergence.first == logged.end() && divergence.second == replayed.end();
+
+			if (!result.identical)
+			{
+				std::cout << "  diverges at decision " << divergence.first - logged.begin() << ": logged ";
+				if (divergence.first != logged.end()) std::cout << *divergence.first; else std::cout << "none";
+				std::cout << ", replayed ";
+				if (divergence.second != replayed.end()) std::cout << *divergence.second; else std::cout << "none";
+				std::cout << std::endl;
+			}
+
+			const auto report = [](const char* what, const std::vector<double>& values)
+			{
+				if (values.empty()) return;
+
+				std::cout << std::fixed << std::setprecision(2) << "  " << what << ": p50 " << Percentile(values, 50) << " ms, p99 " << Percentile(values, 99)
+					<< " ms, max " << Percentile(values, 100) << " ms" << std::defaultfloat << std::setprecision(6) << std::endl;
+			};
+
+			std::size_t screens[4] = {};
+			for (const auto& entry : replayed)
+			{
+				if (entry.kind == Entry::Kind::Frame) screens[entry.value]++;
+			}
+
+			std::cout << "  " << result.frames.size() << " frames (" << screens[static_cast<int>(Screen::Start)] << " start, " << screens[static_cast<int>(Screen::Transition)]
+				<< " transition, " << screens[static_cast<int>(Screen::Stimuli)] << " stimuli, " << screens[static_cast<int>(Screen::Response)] << " response), "
+				<< result.loads.size() << " loads: " << (result.identical ? "the decisions of the session" : "DIVERGED") << std::endl;
+			report("frame", result.frames);
+			report("load", result.loads);
+			std::cout << std::fixed << std::setprecision(1) << "  behind the session by up to " << result.behind << " ms" << std::defaultfloat << std::setprecision(6) << std::endl;
+
+			check(result.identical, result.log + ": the replay decides the screens and loads of the session");
+			measured.push_back(result);
+
+			return result.identical;
+		};
+
+		if (logs.empty())
+		{
+			const auto path = directory / "Synthetic.ppmlog";
+			const auto run = SyntheticRun(directory / "synthetic", 6);
+			const auto period = HeadlessSession::Period();
+
+			std::size_t entries = 0;
+
+			// a participant who starts after a few frames of the start screen, and answers a second after the stimuli appear,
+			// or after the response screen of every fourth trial
+			{
+				HeadlessSession session(run, true);
+				Experiment::SessionLog::Recorder recorder(path, run, true, [&] { return session.Now(); });
+
+				auto started = false;
+				auto stopwatch = session.Now();
+				auto next = session.Now();
+
+				// Game::Update, as logged by Controller::Presented
+				const auto frame = [&]
+				{
+					const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(session.Now() - stopwatch);
+					const auto screen = Experiment::Scene::ScreenAt(started, elapsed);
+
+					session.Update(screen);
+					recorder.Presented(screen, elapsed);
+					return screen;
+				};
+
+				const auto tick = [&]
+				{
+					session.WaitUntil(next);
+					const auto screen = frame();
+					next = session.Now() + period;
+					return screen;
+				};
+
+				for (auto i = 0; i < 3; i++) tick();
+
+				started = true;
+				stopwatch = session.Now();
+				recorder.Started();
+				recorder.Loaded(0);
+				session.Load(0);
+
+				for (auto t = 0; t < run.size(); t++)
+				{
+					auto respondAt = Clock::time_point::max();
+
+					while (respondAt > next)
+					{
+						const auto screen = tick();
+						if (respondAt == Clock::time_point::max() && (screen == Screen::Response || (screen == Screen::Stimuli && t % 4 != 3))) respondAt = session.Now() + std::chrono::seconds(1);
+					}
+
+					session.WaitUntil(respondAt);
+					recorder.Answered(run.trials[t].correctOption);
+
+					if (t + 1 == run.size()) break;
+
+					stopwatch = session.Now();
+					frame();
+					recorder.Loaded(t + 1);
+					session.Load(t + 1);
+				}
+
+				entries = recorder.Entries();
+			}
+
+			const auto log = Experiment::SessionLog::Read(path);
+
+			auto sameRun = log.run.trials.size() == run.trials.size() && log.preloaded;
+			for (std::size_t t = 0; sameRun && t < run.trials.size(); t++)
+			{
+				const auto& a = log.run.trials[t];
+				const auto& b = run.trials[t];
+				sameRun = a.imageName == b.imageName && a.originalDirectory == b.originalDirectory && a.position.x == b.position.x && a.position.y == b.position.y && a.correctOption == b.correctOption;
+			}
+
+			check(sameRun, "the log keeps the run");
+			check(log.entries.size() == entries && !log.truncated, "the log keeps every entry");
+			std::cout << entries << " entries in " << std::filesystem::file_size(path) << " bytes" << std::endl;
+
+			replay(path);
+
+			// a log cut within its last entry, as by a crash, keeps the entries before it
+			const auto cut = directory / "Cut.ppmlog";
+			std::filesystem::copy_file(path, cut);
+			std::filesystem::resize_file(cut, std::filesystem::file_size(cut) - 1);
+
+			const auto truncated = Experiment::SessionLog::Read(cut);
+			check(truncated.truncated && truncated.entries.size() + 1 == entries, "a log cut within an entry keeps the entries before it");
+
+			auto rejected = false;
+			try
+			{
+				static_cast<void>(Experiment::SessionLog::Read(run.trials[0].imagePaths(Experiment::Mode::Stereo).leftOriginal));
+			}
+			catch (const std::runtime_error&)
+			{
+				rejected = true;
+			}
+
+			check(rejected, "a file which is not a session log is rejected");
+		}
+
+		for (const auto& log : logs)
+		{
+			try
+			{
+				replay(log);
+			}
+			catch (const std::exception& e)
+			{
+				check(false, log.generic_string() + ": " + e.what());
+			}
+		}
+
+		std::filesystem::remove_all(directory);
+
+		if (!results.empty())
+		{
+			const auto exists = std::filesystem::exists(results) && std::filesystem::file_size(results) > 0;
+
+			std::ofstream csv(results, std::ios::app);
+			if (!exists) csv << "label,log,trials,preloaded,frames,frame_p50_ms,frame_p99_ms,frame_max_ms,loads,load_p50_ms,load_p99_ms,load_max_ms,behind_ms,identical\n";
+
+			// a session which crashed before its first frame has none to measure
+			const auto percentile = [](const std::vector<double>& values, const double p) { return values.empty() ? 0.0 : Percentile(values, p); };
+
+			for (const auto& result : measured)
+			{
+				csv << label << "," << result.log << "," << result.trials << "," << result.preloaded << "," << result.frames.size() << "," << percentile(result.frames, 50)
+					<< "," << percentile(result.frames, 99) << "," << percentile(result.frames, 100) << "," << result.loads.size() << "," << percentile(result.loads, 50)
+					<< "," << percentile(result.loads, 99) << "," << percentile(result.loads, 100) << "," << result.behind << "," << result.identical << "\n";
+			}
+
+			check(static_cast<bool>(csv), "the results are written to " + results.generic_string());
+			std::cout << "appended " << measured.size() << " results to " << results.generic_string() << std::endl;
+		}
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Checks how logged messages are formatted, filtered by level and rate limited, logs from several threads at once into
+	/// queues which drop what they cannot hold, and times a log call on the hot path against formatting it with snprintf
+	int Logging(int argc, char** argv)
+	{
+		using Experiment::Log;
+
+		const auto count = argc > 0 ? static_cast<std::size_t>(std::stoull(argv[0])) : std::size_t(1000000);
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		const auto endsWith = [](const std::string& line, const std::string& what)
+		{
+			return line.size() >= what.size() && line.compare(line.size() - what.size(), what.size(), what) == 0;
+		};
+
+		std::mutex mutex;
+		std::vector<std::string> lines;
+
+		const auto start = [&](const std::size_t rateLimit, const std::chrono::steady_clock::duration ratePeriod)
+		{
+			Log::Settings settings;
+			settings.level = Log::Level::Info;
+			settings.rateLimit = rateLimit;
+			settings.ratePeriod = ratePeriod;
+			settings.sinks.push_back([&](Log::Level, const std::string& line)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					lines.push_back(line);
+				});
+
+			Log::Start(std::move(settings));
+		};
+
+		const auto take = [&]
+		{
+			Log::Flush();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			return std::exchange(lines, {});
+		};
+
+		// printf conversions of the captured arguments, whatever their type, and strings cut to the text of a message
+		{
+			start(1000, std::chrono::seconds(1));
+
+			LOG_INFO("%d frames, %zu bytes, %.1f ms, %s, 0x%x, 100%%", -3, std::size_t(42), 16.66, std::string("pq10"), 255u);
+			LOG_INFO("%5.2f|%-4s|%03d|%s", 3.14159f, "ab", 7, std::string_view("view"));
+			LOG_INFO("%s", std::string(2 * Log::TextBytes, 'x'));
+			LOG_INFO("%d and %d", 1);
+			Log::Write(Log::Level::Info, "a report\n");
+
+			const auto written = take();
+			check(written.size() == 5, "every message is written");
+
+			if (written.size() == 5)
+			{
+				check(endsWith(written[0], " info    -3 frames, 42 bytes, 16.7 ms, pq10, 0xff, 100%\n"), "integers, sizes, floating point numbers, strings and hexadecimal are formatted");
+				check(endsWith(written[1], " 3.14|ab  |007|view\n"), "widths, precisions and flags are kept");
+				check(endsWith(written[2], " " + std::string(Log::TextBytes - 1, 'x') + "\n"), "a string is cut to the text of a message");
+				check(endsWith(written[3], "1 and <missing>\n"), "a missing argument is marked");
+				check(endsWith(written[4], " info    a report\n"), "text is written as it is, in order");
+			}
+		}
+
+		// levels below the current one are not logged
+		{
+			LOG_DEBUG("hidden");
+			LOG_WARNING("warning %d", 1);
+			Log::SetLevel(Log::Level::Error);
+			LOG_WARNING("hidden");
+			LOG_ERROR("error %d", 2);
+			Log::Write(Log::Level::Info, "hidden");
+			Log::SetLevel(Log::Level::Info);
+
+			const auto written = take();
+			check(written.size() == 2 && endsWith(written[0], " warning warning 1\n") && endsWith(written[1], " error   error 2\n"), "levels filter messages");
+		}
+
+		// a call site over its rate limit is quiet for the rest of the period, then reports what it suppressed
+		{
+			constexpr std::size_t rateLimit = 5, burst = 20;
+			const auto ratePeriod = std::chrono::milliseconds(100);
+			start(rateLimit, ratePeriod);
+
+			const auto before = Log::GetStatistics();
+
+			for (std::size_t i = 0; i <= burst; i++)
+			{
+				if (i == burst) std::this_thread::sleep_for(ratePeriod + std::chrono::milliseconds(20));
+				LOG_INFO("burst %zu", i);
+			}
+
+			const auto written = take();
+			const auto after = Log::GetStatistics();
+
+			check(written.size() == rateLimit + 1, "a call site logs its rate limit per period");
+			check(!written.empty() && endsWith(written.back(), "burst 20 (15 more suppressed by the rate limit)\n"), "the next period reports the suppressed messages");
+			check(after.suppressed - before.suppressed == burst - rateLimit, "suppressed messages are counted");
+		}
+
+		// threads log at once, each in order, and what does not fit in their queues is dropped and counted
+		{
+			constexpr std::size_t threads = 4, perThread = 4 * Log::QueueMessages;
+			start(SIZE_MAX, std::chrono::seconds(1));
+
+			const auto before = Log::GetStatistics();
+
+			std::vector<std::thread> workers;
+			for (std::size_t t = 0; t < threads; t++)
+			{
+				workers.emplace_back([t]
+					{
+						for (std::size_t i = 0; i < perThread; i++) LOG_INFO("thread %zu message %zu", t, i);
+					});
+			}
+
+			for (auto& worker : workers) worker.join();
+
+			const auto written = take();
+			const auto after = Log::GetStatistics();
+
+			const auto logged = after.logged - before.logged, dropped = after.dropped - before.dropped;
+			check(logged + dropped == threads * perThread, "every message is logged or dropped");
+			check(written.size() == logged, "every message logged is written");
+
+			std::vector<long long> last(threads, -1);
+			auto ordered = true;
+
+			for (const auto& line : written)
+			{
+				std::size_t t = 0, i = 0;
+				const auto at = line.find("thread ");
+				if (at == std::string::npos || std::sscanf(line.c_str() + at, "thread %zu message %zu", &t, &i) != 2 || t >= threads) continue;
+
+				ordered = ordered && static_cast<long long>(i) > last[t];
+				last[t] = static_cast<long long>(i);
+			}
+
+			check(ordered, "the messages of a thread are written in order");
+
+			std::cout << "threads: " << threads << " x " << perThread << " messages, " << logged << " logged, " << dropped << " dropped" << std::endl;
+		}
+
+		// bursts which fit in the queue, drained between them as the logger thread would between frames
+		{
+			start(SIZE_MAX, std::chrono::seconds(1));
+
+			const auto burst = Log::QueueMessages / 2;
+			const std::string stage = "present";
+
+			const auto timeCalls = [&](const std::function<void(std::size_t)>& call)
+			{
+				std::chrono::steady_clock::duration total = {};
+
+				for (std::size_t done = 0; done < count; done += burst)
+				{
+					const auto calls = std::min(burst, count - done);
+					const auto begin = std::chrono::steady_clock::now();
+
+					for (std::size_t i = 0; i < calls; i++) call(done + i);
+
+					total += std::chrono::steady_clock::now() - begin;
+					Log::Flush();
+				}
+
+				return std::chrono::duration<double, std::nano>(total).count() / static_cast<double>(count);
+			};
+
+			const auto before = Log::GetStatistics();
+
+			const auto enabled = timeCalls([&](const std::size_t i) { LOG_INFO("frame %zu took %.3f ms in %s", i, 16.6, stage); });
+			const auto dropped = Log::GetStatistics().dropped - before.dropped;
+
+			Log::SetLevel(Log::Level::Error);
+			const auto disabled = timeCalls([&](const std::size_t i) { LOG_INFO("frame %zu took %.3f ms in %s", i, 16.6, stage); });
+			Log::SetLevel(Log::Level::Info);
+
+			start(0, std::chrono::seconds(10));
+			const auto suppressed = timeCalls([&](const std::size_t i) { LOG_INFO("frame %zu took %.3f ms in %s", i, 16.6, stage); });
+
+			// what the varargs Debug::Console::log did on the calling thread, before writing to the debugger
+			std::size_t characters = 0;
+			const auto formatted = timeCalls([&](const std::size_t i)
+				{
+					char buffer[1024];
+					characters += static_cast<std::size_t>(std::snprintf(buffer, sizeof(buffer), "frame %zu took %.3f ms in %s", i, 16.6, stage.c_str()));
+				});
+
+			take();
+
+			std::cout << "log: " << enabled << " ns enabled, " << disabled << " ns disabled, " << suppressed << " ns suppressed, "
+				<< formatted << " ns formatted with snprintf (" << characters / count << " characters)" << std::endl;
+
+			check(dropped == 0, "bursts which fit in the queue drop nothing");
+			check(enabled < 100, "a log call on the hot path costs under 100 ns");
+			check(disabled < 10, "a disabled log call costs a few nanoseconds");
+		}
+
+		Log::Stop();
+		std::cout << "Log: " << Log::GetStatistics() << std::endl;
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+
+		return ok ? 0 : 1;
+	}
+
+	/// Checks that the trace keeps the latest events and writes a window of them, then drives a render thread at 100 Hz whose
+	/// frames stall in each stage in turn, and checks that the watchdog reports each stall once, with its stage, and snapshots
+	/// the recent trace of the first ones, while frames on time and the time before the first frame go unreported
+	int WatchdogStalls(int, char**)
+	{
+		using std::chrono::milliseconds;
+
+		auto ok = true;
+
+		const auto check = [&](const bool condition, const std::string& what)
+		{
+			if (!condition)
+			{
+				std::cerr << "FAILED: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		const auto contains = [](const std::string& json, const std::string& what) { return json.find(what) != std::string::npos; };
+
+		constexpr std::size_t capacity = 1000;
+		Experiment::Trace::Enable(capacity);
+
+		// a window leaves out older events, and a full ring the oldest
+		{
+			TRACE_INSTANT("benchmark", "Old");
+			std::this_thread::sleep_for(milliseconds(50));
+			TRACE_INSTANT("benchmark", "Recent");
+
+			std::ostringstream window, all;
+			Experiment::Trace::Write(window, milliseconds(25));
+			Experiment::Trace::Write(all);
+
+			check(contains(window.str(), "Recent") && !contains(window.str(), "Old"), "a window holds the recent events only");
+			check(contains(all.str(), "Recent") && contains(all.str(), "Old"), "a trace holds every event");
+
+			for (std::size_t i = 0; i < capacity; i++) TRACE_INSTANT("benchmark", "Wrap");
+
+			std::ostringstream wrapped;
+			Experiment::Trace::Write(wrapped);
+
+			const auto statistics = Experiment::Trace::GetStatistics();
+			check(!contains(wrapped.str(), "Old") && !contains(wrapped.str(), "Recent"), "a full ring overwrites the oldest events");
+			check(statistics.events == capacity && statistics.dropped == 2, "the overwritten events are counted as dropped");
+		}
+
+		const auto directory = std::filesystem::temp_directory_path() / "ppm-experiment-stalls";
+		std::filesystem::remove_all(directory);
+
+		Experiment::Watchdog::Settings settings;
+		settings.deadline = milliseconds(50);
+		settings.window = milliseconds(100);
+		settings.directory = directory;
+		settings.maxSnapshots = 3;
+
+		std::mutex mutex;
+		std::vector<Experiment::Watchdog::Stall> stalls;
+
+		Experiment::Watchdog watchdog(settings, [&](const Experiment::Watchdog::Stall& stall)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stalls.push_back(stall);
+			});
+
+		// nothing is due before the first frame
+		std::this_thread::sleep_for(2 * settings.deadline);
+		check(watchdog.GetStatistics().stalls == 0, "no stall before the first frame");
+
+		// a stall in loading, in uploading, a long one in presenting, and one in dispatching input, which is over the snapshots
+		constexpr std::size_t decodeStall = 10, uploadStall = 20, presentStall = 30, inputStall = 40, frames = 55;
+		const auto stall = milliseconds(120);
+
+		std::atomic<std::size_t> frame{ 0 };
+
+		{
+			auto next = std::chrono::steady_clock::now();
+
+			Experiment::RenderThread renderThread(
+				[&](const Experiment::WindowEvent&) { std::this_thread::sleep_for(stall); },
+				[&]
+				{
+					const auto current = frame.load() + 1;
+
+					{
+						TRACE_SCOPE("load", "Decode");
+						if (current == decodeStall) std::this_thread::sleep_for(stall);
+					}
+
+					{
+						// enough events per frame to wrap the rings while snapshots read them
+						TRACE_SCOPE("upload", "Finish uploads");
+						for (auto band = 0; band < 50; band++)
+						{
+							TRACE_SCOPE("upload", "Band");
+						}
+						if (current == uploadStall) std::this_thread::sleep_for(stall);
+					}
+
+					{
+						TRACE_SCOPE("present", "Present");
+						next += milliseconds(10);
+						std::this_thread::sleep_until(next);
+						if (current == presentStall) std::this_thread::sleep_for(4 * stall);
+					}
+
+					// frames after a stall are due a period after it, rather than catching up
+					next = std::max(next, std::chrono::steady_clock::now());
+
+					watchdog.Beat();
+					frame.store(current);
+				});
+
+			// posted while frame 39 waits to present, so that it is dispatched before frame 40
+			while (frame.load() < inputStall - 2) std::this_thread::sleep_for(milliseconds(1));
+			renderThread.Post({});
+
+			while (frame.load() < frames) std::this_thread::sleep_for(milliseconds(1));
+			renderThread.Stop();
+		}
+
+		const auto statistics = watchdog.GetStatistics();
+		std::cout << "Watchdog: " << statistics << std::endl;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		check(statistics.stalls == 4 && stalls.size() == 4, "each stall is reported once, and frames on time are not");
+		check(statistics.snapshots == 3, "snapshots stop at their limit");
+
+		const std::pair<const char*, const char*> stages[] = { { "load", "Decode" }, { "upload", "Finish uploads" }, { "present", "Present" }, { "input", "Dispatch event" } };
+		const std::size_t stalledFrames[] = { decodeStall, uploadStall, presentStall, inputStall };
+
+		for (std::size_t i = 0; i < stalls.size() && i < 4; i++)
+		{
+			const auto& s = stalls[i];
+			const auto name = std::string(stages[i].first) + " stall";
+
+			std::cout << "  frame " << s.frame << " late by " << std::chrono::duration<double, std::milli>(s.late).count() << " ms in "
+				<< s.stage << ": " << s.scope << (s.snapshot.empty() ? "" : ", " + s.snapshot.generic_string()) << std::endl;
+
+			check(s.stage == stages[i].first && s.scope == stages[i].second, name + ": the stage the render thread is stuck in");
+			check(s.frame + 1 == stalledFrames[i], name + ": the frame which stalled");
+			check(s.late >= settings.deadline, name + ": detected past the deadline");
+			check(s.snapshot.empty() == (i >= settings.maxSnapshots), name + ": a snapshot while under the limit");
+
+			if (s.snapshot.empty()) continue;
+
+			std::ifstream file(s.snapshot, std::ios::binary);
+			const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+			auto depth = 0;
+			auto inString = false;
+			for (std::size_t c = 0; c < json.size(); c++)
+			{
+				if (inString)
+				{
+					if (json[c] == '\\') c++;
+					else if (json[c] == '"') inString = false;
+					continue;
+				}
+
+				if (json[c] == '"') inString = true;
+				if (json[c] == '{' || json[c] == '[') depth++;
+				if (json[c] == '}' || json[c] == ']') depth--;
+			}
+
+			check(depth == 0 && !inString, name + ": the snapshot is well formed");
+			check(contains(json, "\"stage\":\"" + std::string(stages[i].first) + "\""), name + ": the snapshot names the stage");
+			check(contains(json, "\"Band\"") && contains(json, "\"Stall\"") && contains(json, "\"Render\""), name + ": the snapshot holds the frames before the stall");
+			check(!contains(json, "\"Wrap\""), name + ": the snapshot holds only the recent trace");
+		}
+
+		check(!std::filesystem::exists(directory / "Stall4.json"), "no snapshot over the limit");
+
+		std::filesystem::remove_all(directory);
+
+		std::cout << (ok ? "ok" : "FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+
+	/// Renders the flickering and steady composites of every trial of a session at 7680x2160 on the CPU renderer, as the
+	/// participant saw them, into `<directory>/<trial>_<image>_flicker.ppm` and `_steady.ppm`. The stimuli of the next trial are
+	/// decoded while the current one is rendered, and frames are written while the next one renders
+	int Capture(int argc, char** argv)
+	{
+		if (argc < 2)
+		{
+			std::cerr << "usage: benchmark capture <session.csv> <directory> [pq10|pq16] [trials]" << std::endl;
+			return 1;
+		}
+
+		const auto run = Experiment::Run::CreateRun(argv[0]);
+		const std::filesystem::path directory = argv[1];
+		const auto encoding = argc > 2 && std::strcmp(argv[2], "pq10") == 0 ? Experiment::FrameCapture::Encoding::Pq10 : Experiment::FrameCapture::Encoding::Pq16;
+		const auto trials = std::min(run.size(), argc > 3 ? std::stoi(argv[3]) : run.size());
+
+		std::filesystem::create_directories(directory);
+
+		const auto dims = Experiment::Configuration::ImageDimensions;
+
+		Experiment::CpuRenderer renderer;
+		Experiment::FrameCapture capture(encoding);
+		Experiment::ImageCache cache(Experiment::Configuration::ImageCacheBytes);
+
+		using Stimuli = std::array<std::shared_ptr<const Experiment::Frame>, 4>;
+
+		const auto load = [&](const int t)
+		{
+			const auto paths = Experiment::Scene::StimulusPaths(run.trials[t]);
+
+			Stimuli stimuli;
+			for (std::size_t i = 0; i < 4; i++)
+			{
+				stimuli[i] = cache.Get(paths[i], [](const std::filesystem::path& path) { return Experiment::Ppm::Read(path); });
+			}
+
+			return stimuli;
+		};
+
+		const auto start = std::chrono::steady_clock::now();
+		auto next = std::async(std::launch::async, load, 0);
+
+		for (auto t = 0; t < trials; t++)
+		{
+			const auto& trial = run.trials[t];
+			const auto stimuli = next.get();
+
+			if (t + 1 < trials)
+			{
+				next = std::async(std::launch::async, load, t + 1);
+			}
+
+			std::array<Experiment::ConstRgba16View, 4> crops;
+			for (std::size_t i = 0; i < 4; i++)
+			{
+				crops[i] = Experiment::ConstRgba16View(*stimuli[i]).Crop(trial.position.x, trial.position.y, dims.x, dims.y);
+			}
+
+			const auto views = Experiment::Scene::ComposeFlickerStereoViews(trial, renderer.CreateTextureArray(crops.data(), crops.size()));
+
+			std::ostringstream name;
+			name << std::setw(4) << std::setfill('0') << t << "_" << trial.imageName;
+
+			for (const auto flicker : { true, false })
+			{
+				renderer.Begin();
+				Experiment::Scene::Draw(renderer, flicker ? views.second : views.first);
+				renderer.End();
+				renderer.Present();
+
+				capture.Write(directory / (name.str() + (flicker ? "_flicker.ppm" : "_steady.ppm")), renderer.GetFrontBuffer());
+			}
+		}
+
+		capture.Flush();
+
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "Renderer: " << renderer.GetStatistics() << std::endl;
+		std::cout << "Capture: " << capture.GetStatistics() << std::endl;
+		std::cout << trials << " trials in " << seconds << " s, " << seconds * 1000 / std::max(1, trials) << " ms per trial" << std::endl;
+
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: benchmark <order|cache|stimuli|preload|arena|views|pipeline|upload|schedule|render|batch|graph|present|thread|trace|memory|allocations|performance|stages|switch|replay|log|watchdog|capture> [arguments]" << std::endl;
+		return 1;
+	}
+
+	if (std::strcmp(argv[1], "order") == 0) return Order(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "cache") == 0) return Cache(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "stimuli") == 0) return StimulusCache(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "preload") == 0) return Preload(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "arena") == 0) return TrialArena(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "views") == 0) return Views(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "pipeline") == 0) return Pipeline(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "upload") == 0) return Upload(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "schedule") == 0) return Schedule(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "render") == 0) return Render(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "batch") == 0) return Batch(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "graph") == 0) return Graph(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "present") == 0) return Present(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "thread") == 0) return Thread(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "trace") == 0) return TraceEvents(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "memory") == 0) return Memory(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "allocations") == 0) return Allocations(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "performance") == 0) return Performance(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "stages") == 0) return Stages(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "switch") == 0) return TrialSwitch(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "replay") == 0) return Replay(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "log") == 0) return Logging(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "watchdog") == 0) return WatchdogStalls(argc - 2, argv + 2);
+	if (std::strcmp(argv[1], "capture") == 0) return Capture(argc - 2, argv + 2);
+
+	std::cerr << "unknown command " << argv[1] << std::endl;
+	return 1;
+}
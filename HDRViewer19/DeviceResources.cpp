@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "DeviceResources.h"
+#include <d3d11_4.h>
 
 using Microsoft::WRL::ComPtr;
 
@@ -236,6 +237,13 @@ void DX::DeviceResources::CreateDeviceResources()
 	ThrowIfFailed(device.As(&m_d3dDevice));
 	ThrowIfFailed(context.As(&m_d3dContext));
 	ThrowIfFailed(context.As(&m_d3dAnnotation));
+
+	// the windows are presented from threads of their own, which flush the immediate context
+	ComPtr<ID3D11Multithread> multithread;
+	if (SUCCEEDED(context.As(&multithread)))
+	{
+		multithread->SetMultithreadProtected(TRUE);
+	}
 }
 
 // These resources need to be recreated every time the window size is changed.
@@ -463,15 +471,20 @@ void DX::DeviceResources::ThreadPresent()
 		return;
 	}
 
-	//std::thread one([&]() { m_swapChain[0]->Present(1, 0); });
-	//std::thread two([&]() { m_swapChain[1]->Present(1, 0); });
+	if (!m_presentScheduler)
+	{
+		std::vector<Experiment::IPresentTarget*> targets;
 
+		for (int i = 0; i < m_numWindows; i++)
+		{
+			m_presenters.push_back(std::make_unique<SwapChainPresenter>(&m_swapChain[i]));
+			targets.push_back(m_presenters.back().get());
+		}
 
-	//one.join();
-	//two.join();
+		m_presentScheduler = std::make_unique<Experiment::PresentScheduler>(std::move(targets));
+	}
 
-	m_swapChain[0]->Present(1, 0);
-	m_swapChain[1]->Present(1, 0);
+	m_presentScheduler->Present();
 }
 
 // CleanFrame the contents of the swap chain to the screen.
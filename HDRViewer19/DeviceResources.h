@@ -5,6 +5,9 @@
 #pragma once
 #include <wrl/client.h>
 #include "pch.h"
+#include <memory>
+#include <vector>
+#include "../PPM Experiment/PresentScheduler.h"
 
 namespace DX
 {
@@ -40,7 +43,12 @@ namespace DX
 		void SetWindow(int i, HWND window, int width, int height);
 		bool WindowSizeChanged(int i, int width, int height);
 		void HandleDeviceLost();
+		/// Presents every window, each from a thread of its own so that the eyes are queued for the same vertical blank
 		void ThreadPresent();
+		[[nodiscard]] Experiment::PresentScheduler::Statistics GetPresentStatistics() const
+		{
+			return m_presentScheduler ? m_presentScheduler->GetStatistics() : Experiment::PresentScheduler::Statistics{};
+		}
 		void RegisterDeviceNotify(IDeviceNotify* deviceNotify) { m_deviceNotify = deviceNotify; }
 		void DiscardView(int i);
 
@@ -124,5 +132,20 @@ namespace DX
 		IDeviceNotify* m_deviceNotify;
 
 		int m_numWindows = 1;
+
+		/// Presents the current swap chain of a window, which is recreated with the device
+		class SwapChainPresenter final : public Experiment::IPresentTarget
+		{
+		public:
+			explicit SwapChainPresenter(Microsoft::WRL::ComPtr<IDXGISwapChain1>* swapChain) : m_swapChain(swapChain) {}
+
+			void Present() override { (*m_swapChain)->Present(1, 0); }
+
+		private:
+			Microsoft::WRL::ComPtr<IDXGISwapChain1>* m_swapChain;
+		};
+
+		std::vector<std::unique_ptr<SwapChainPresenter>> m_presenters;
+		std::unique_ptr<Experiment::PresentScheduler> m_presentScheduler;
 	};
 }
@@ -4,10 +4,12 @@
 
 #include "pch.h"
 #include "Game.h"
+#include "../PPM Experiment/Trace.h"
 #include <synchapi.h>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 extern void ExitGame();
 
@@ -40,8 +42,10 @@ Game::Game(const std::wstring& folderPath, bool flicker, bool stereo) noexcept(f
 	m_hdrScene = new std::unique_ptr<DX::RenderTexture>[m_numberOfWindows];
 	m_toneMap = new std::unique_ptr<DirectX::ToneMapPostProcess>[m_numberOfWindows];
 
-	m_textures = new ComPtr<ID3D11Texture2D>[2 * m_numberOfWindows];
-	m_shaderResourceViews = new ComPtr<ID3D11ShaderResourceView>[2 * m_numberOfWindows];
+	// the two frames of each window
+	m_textures.resize(2 * m_numberOfWindows);
+	m_textureCharges.resize(2 * m_numberOfWindows);
+	m_shaderResourceViews.resize(2 * m_numberOfWindows);
 
 	for (int i = 0; i < m_numberOfWindows; i++) {
 		m_hdrScene[i] = std::make_unique<DX::RenderTexture>(DXGI_FORMAT_R16G16B16A16_FLOAT);
@@ -53,7 +57,6 @@ Game::Game(const std::wstring& folderPath, bool flicker, bool stereo) noexcept(f
 void Game::Initialize(HWND windows[], int width, int height)
 {
 	m_flickerFrameFlag = new bool[m_numberOfWindows];
-	m_textures = new ComPtr<ID3D11Texture2D>[m_numberOfWindows];
 
 	for (int i = 0; i < m_numberOfWindows; i++)
 	{
@@ -85,6 +88,8 @@ void Game::Tick()
 
 void Game::OnArrowKeyDown(WPARAM key)
 {
+	TRACE_INSTANT("input", "Arrow key");
+
 	if (key == VK_LEFT)
 	{
 		m_imageSetIndex = (m_imageSetIndex == 0) ? m_files.size() - 1 : m_imageSetIndex - 1;
@@ -94,6 +99,8 @@ void Game::OnArrowKeyDown(WPARAM key)
 		m_imageSetIndex = (m_imageSetIndex + 1) % m_files.size();
 	}
 
+	TRACE_SCOPE("load", "Load images");
+
 	getImagesAsTextures(m_textures);
 	Prerender();
 }
@@ -101,6 +108,11 @@ void Game::OnArrowKeyDown(WPARAM key)
 
 void Game::OnEscapeKeyDown()
 {
+	std::stringstream ss;
+	ss << "PresentScheduler: " << m_deviceResources->GetPresentStatistics() << "\n";
+	ss << Experiment::MemoryAccounting::Global();
+	OutputDebugStringA(ss.str().c_str());
+
 	m_deviceResources.reset();
 	OnDeviceLost();
 
@@ -116,7 +128,10 @@ void Game::Update(DX::StepTimer const& timer)
 		Render(i);
 	}
 
-	m_deviceResources->ThreadPresent();
+	{
+		TRACE_SCOPE("present", "Present");
+		m_deviceResources->ThreadPresent();
+	}
 
 	for (int i = 0; i < m_numberOfWindows; i++)
 	{
@@ -138,7 +153,7 @@ void Game::Prerender()
 		auto hr = m_deviceResources->m_d3dDevice->CreateShaderResourceView(
 			m_textures[i].Get(),
 			&desc2,
-			m_shaderResourceViews[i].GetAddressOf()
+			m_shaderResourceViews[i].ReleaseAndGetAddressOf()
 		);
 	}
 }
@@ -157,6 +172,7 @@ void Game::Render(int i)
 	Clear(i);
 
 	m_deviceResources->PIXBeginEvent(L"Render");
+	TRACE_BEGIN("render", "Render");
 	auto context = m_deviceResources->GetD3DDeviceContext();
 
 	// Determines which image out of the possible four to present this frame. If NUM_WINDOWS is 2, i will be 1 50% of the time, else 0%
@@ -170,6 +186,7 @@ void Game::Render(int i)
 	m_spriteBatch->End();
 
 
+	TRACE_END();
 	m_deviceResources->PIXEndEvent();
 
 	auto renderTarget = m_deviceResources->GetRenderTargetView(i);
@@ -190,6 +207,7 @@ void Game::Render(int i)
 void Game::Clear(int i)
 {
 	m_deviceResources->PIXBeginEvent(L"Clear");
+	TRACE_SCOPE("render", "Clear");
 
 	// Clear the views.
 	auto context = m_deviceResources->GetD3DDeviceContext();
@@ -316,12 +334,14 @@ void Game::OnDeviceRestored()
 #pragma endregion
 
 
-void Game::getImagesAsTextures(ComPtr<ID3D11Texture2D>* textures)
+void Game::getImagesAsTextures(std::vector<ComPtr<ID3D11Texture2D>>& textures)
 {
 	auto filenames = m_files[m_imageSetIndex];
 
 	for (int i = 0; i < m_numberOfWindows * 2; i++)
 	{
+		TRACE_SCOPE("load", "Load image");
+
 		auto matrixoriginal = cv::imread(filenames[i], cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH);
 		cv::Mat matrix(matrixoriginal.size(), CV_MAKE_TYPE(matrixoriginal.depth(), 4));
 
@@ -342,7 +362,7 @@ void Game::getImagesAsTextures(ComPtr<ID3D11Texture2D>* textures)
 		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE | D3D11_CPU_ACCESS_READ;
 		desc.MiscFlags = 0;
 
-		auto hr = m_deviceResources->GetD3DDevice()->CreateTexture2D(&desc, nullptr, textures[i].GetAddressOf());
+		auto hr = m_deviceResources->GetD3DDevice()->CreateTexture2D(&desc, nullptr, textures[i].ReleaseAndGetAddressOf());
 
 		try {
 			cv::directx::convertToD3D11Texture2D(matrix, textures[i].Get());
@@ -357,6 +377,8 @@ void Game::getImagesAsTextures(ComPtr<ID3D11Texture2D>* textures)
 		{
 			throw std::exception("cannot read image");
 		}
+
+		m_textureCharges[i] = Experiment::MemoryAccounting::Charge(Experiment::MemoryAccounting::Global(), Experiment::MemoryTag::Textures, matrix.total() * 8);
 	}
 
 }
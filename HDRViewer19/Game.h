@@ -8,6 +8,8 @@
 #include "StepTimer.h"
 #include "RenderTexture.h"
 #include "SpriteBatch.h"
+#include "../PPM Experiment/MemoryAccounting.h"
+#include <vector>
 
 using string_ref = const std::string &;
 
@@ -28,7 +30,7 @@ public:
 	// IDeviceNotify
 	virtual void OnDeviceLost() override;
 	virtual void OnDeviceRestored() override;
-	void getImagesAsTextures(Microsoft::WRL::ComPtr<ID3D11Texture2D>* textures);
+	void getImagesAsTextures(std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>>& textures);
 	matrix<std::string> getFiles(const std::wstring& folder);
 
 	// Messages
@@ -65,8 +67,9 @@ private:
 	std::unique_ptr<DX::RenderTexture>* m_hdrScene;
 	std::unique_ptr<DirectX::ToneMapPostProcess>* m_toneMap;
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* m_shaderResourceViews;
-	Microsoft::WRL::ComPtr<ID3D11Texture2D>* m_textures;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> m_shaderResourceViews;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> m_textures;
+	std::vector<Experiment::MemoryAccounting::Charge> m_textureCharges;
 
 	bool* m_flickerFrameFlag;
 	int m_imageSetIndex = 0;
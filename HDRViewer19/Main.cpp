@@ -4,6 +4,8 @@
 
 #include "pch.h"
 #include "Game.h"
+#include "../PPM Experiment/RenderThread.h"
+#include "../PPM Experiment/Trace.h"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -20,9 +22,75 @@ using string_ref = const std::string &;
 namespace
 {
 	std::unique_ptr<Game> g_game;
+
+	// the thread which ticks the game once it is initialized, and the UI thread which pumps the messages of its windows
+	Experiment::RenderThread* g_renderThread = nullptr;
+	DWORD g_uiThread = 0;
 };
 
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
+
+// Handles a window event on the render thread, or on the UI thread before the render thread starts
+void Dispatch(Game& game, const Experiment::WindowEvent& event)
+{
+	switch (event.type)
+	{
+	case Experiment::WindowEvent::Type::Escape:
+		game.OnEscapeKeyDown();
+		break;
+
+	case Experiment::WindowEvent::Type::KeyDown:
+		game.OnArrowKeyDown(event.key);
+		break;
+
+	case Experiment::WindowEvent::Type::Moved:
+		game.OnWindowMoved(event.window);
+		break;
+
+	case Experiment::WindowEvent::Type::Resized:
+		game.OnWindowSizeChanged(event.window, event.width, event.height);
+		break;
+
+	case Experiment::WindowEvent::Type::Activated:
+		game.OnActivated();
+		break;
+
+	case Experiment::WindowEvent::Type::Deactivated:
+		game.OnDeactivated();
+		break;
+
+	case Experiment::WindowEvent::Type::Suspending:
+		game.OnSuspending();
+		break;
+
+	case Experiment::WindowEvent::Type::Resuming:
+		game.OnResuming();
+		break;
+	}
+}
+
+// Hands an event to the render thread without waiting for it, or handles it directly while the game is being initialized
+void Forward(Game* game, Experiment::WindowEvent::Type type, int windowIndex = 0, WPARAM key = 0, int width = 0, int height = 0)
+{
+	if (!game) return;
+
+	Experiment::WindowEvent event;
+	event.type = type;
+	event.window = windowIndex;
+	event.key = key;
+	event.width = width;
+	event.height = height;
+
+	if (g_renderThread)
+	{
+		g_renderThread->Post(event);
+	}
+	else
+	{
+		Dispatch(*game, event);
+	}
+}
+
 static int CALLBACK BrowseCallbackProc(HWND hwnd, UINT uMsg, LPARAM lParam, LPARAM lpData);
 
 // Indicates to hybrid graphics systems to prefer the discrete part by default
@@ -81,6 +149,14 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 	if (FAILED(hr))
 		return 1;
 
+	// tracing is opt in, through the path of the trace to write on exit
+	wchar_t tracePath[MAX_PATH];
+	if (GetEnvironmentVariableW(L"EXPERIMENT_TRACE_FILE", tracePath, MAX_PATH) > 0)
+	{
+		Experiment::Trace::Enable();
+		Experiment::Trace::WriteAtExit(tracePath);
+	}
+
 	MSG msg = {};
 
 	int w, h;
@@ -154,19 +230,42 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
 	g_game->Initialize(windows, rc.right - rc.left, rc.bottom - rc.top);
 
-		// Main message loop
-		while (WM_QUIT != msg.message)
+	// From here the game is only touched by the render thread, so that the message loop may block without stalling a frame
+	g_uiThread = GetCurrentThreadId();
+
+	Experiment::RenderThread renderThread(
+		[](const Experiment::WindowEvent& event) { Dispatch(*g_game, event); },
+		[] { g_game->Tick(); });
+
+	g_renderThread = &renderThread;
+
+	// Main message loop. It keeps pumping while events the render thread has no room for are held back, as the render thread
+	// may be waiting on this thread for a message DXGI sends it
+	for (;;)
+	{
+		if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
 		{
-			if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
-			{
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
-			}
-			else
-			{
-				g_game->Tick();
-			}
+			if (msg.message == WM_QUIT) break;
+
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
 		}
+		else if (renderThread.Flush())
+		{
+			MsgWaitForMultipleObjects(0, nullptr, FALSE, 1, QS_ALLINPUT);
+		}
+		else
+		{
+			WaitMessage();
+		}
+	}
+
+	renderThread.Stop();
+	g_renderThread = nullptr;
+
+	std::stringstream ss;
+	ss << "RenderThread: " << renderThread.GetStatistics() << "\n";
+	OutputDebugStringA(ss.str().c_str());
 
 		g_game.reset();
 
@@ -208,33 +307,26 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	switch (message)
 	{
 	case WM_PAINT:
-		if (s_in_sizemove && game)
-		{
-			game->Tick();
-		}
-		else
-		{
-			HDC hdc = BeginPaint(hWnd, &ps);
-			EndPaint(hWnd, &ps);
-		}
-		break;
+	{
+		// the render thread keeps presenting, including while the window is moved or resized
+		HDC hdc = BeginPaint(hWnd, &ps);
+		EndPaint(hWnd, &ps);
+	}
+	break;
 
 	case WM_KEYDOWN:
-		if (game && (wParam == VK_LEFT || wParam == VK_RIGHT))
+		if (wParam == VK_LEFT || wParam == VK_RIGHT)
 		{
-			game->OnArrowKeyDown(wParam);
+			Forward(game, Experiment::WindowEvent::Type::KeyDown, wndIndex, wParam);
 		}
-		if (game && wParam == VK_ESCAPE)
+		if (wParam == VK_ESCAPE)
 		{
-			game->OnEscapeKeyDown();
+			Forward(game, Experiment::WindowEvent::Type::Escape, wndIndex);
 		}
 		break;
 
 	case WM_MOVE:
-		if (game)
-		{
-			game->OnWindowMoved(wndIndex);
-		}
+		Forward(game, Experiment::WindowEvent::Type::Moved, wndIndex);
 		break;
 
 	case WM_SIZE:
@@ -243,21 +335,21 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 			if (!s_minimized)
 			{
 				s_minimized = true;
-				if (!s_in_suspend && game)
-					game->OnSuspending();
+				if (!s_in_suspend)
+					Forward(game, Experiment::WindowEvent::Type::Suspending, wndIndex);
 				s_in_suspend = true;
 			}
 		}
 		else if (s_minimized)
 		{
 			s_minimized = false;
-			if (s_in_suspend && game)
-				game->OnResuming();
+			if (s_in_suspend)
+				Forward(game, Experiment::WindowEvent::Type::Resuming, wndIndex);
 			s_in_suspend = false;
 		}
-		else if (!s_in_sizemove && game)
+		else if (!s_in_sizemove)
 		{
-			game->OnWindowSizeChanged(wndIndex, LOWORD(lParam), HIWORD(lParam));
+			Forward(game, Experiment::WindowEvent::Type::Resized, wndIndex, 0, LOWORD(lParam), HIWORD(lParam));
 		}
 		break;
 
@@ -267,12 +359,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 	case WM_EXITSIZEMOVE:
 		s_in_sizemove = false;
-		if (game)
 		{
 			RECT rc;
 			GetClientRect(hWnd, &rc);
 
-			game->OnWindowSizeChanged(wndIndex, rc.right - rc.left, rc.bottom - rc.top);
+			Forward(game, Experiment::WindowEvent::Type::Resized, wndIndex, 0, rc.right - rc.left, rc.bottom - rc.top);
 		}
 		break;
 
@@ -285,33 +376,23 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	break;
 
 	case WM_ACTIVATEAPP:
-		if (game)
-		{
-			if (wParam)
-			{
-				game->OnActivated();
-			}
-			else
-			{
-				game->OnDeactivated();
-			}
-		}
+		Forward(game, wParam ? Experiment::WindowEvent::Type::Activated : Experiment::WindowEvent::Type::Deactivated, wndIndex);
 		break;
 
 	case WM_POWERBROADCAST:
 		switch (wParam)
 		{
 		case PBT_APMQUERYSUSPEND:
-			if (!s_in_suspend && game)
-				game->OnSuspending();
+			if (!s_in_suspend)
+				Forward(game, Experiment::WindowEvent::Type::Suspending, wndIndex);
 			s_in_suspend = true;
 			return TRUE;
 
 		case PBT_APMRESUMESUSPEND:
 			if (!s_minimized)
 			{
-				if (s_in_suspend && game)
-					game->OnResuming();
+				if (s_in_suspend)
+					Forward(game, Experiment::WindowEvent::Type::Resuming, wndIndex);
 				s_in_suspend = false;
 			}
 			return TRUE;
@@ -366,9 +447,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 
 
-// Exit helper
+// Exit helper, also called from the render thread, which has no message loop of its own
 void ExitGame()
 {
-	PostQuitMessage(0);
+	PostThreadMessage(g_uiThread, WM_QUIT, 0, 0);
 }
 
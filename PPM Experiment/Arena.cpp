@@ -0,0 +1,145 @@
+#include "Arena.h"
+#include <algorithm>
+#include <new>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Experiment
+{
+	constexpr std::size_t HugePageSize = std::size_t(2) << 20;
+
+	static std::size_t AlignUp(const std::size_t value, const std::size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	Arena::Arena(const std::size_t capacity, const bool prefault)
+	{
+		m_capacity = AlignUp(std::max<std::size_t>(capacity, 1), HugePageSize);
+
+#ifdef _WIN32
+		// large pages need SeLockMemoryPrivilege, so fall back to regular pages without it
+		const auto largePage = GetLargePageMinimum();
+		if (largePage != 0)
+		{
+			const auto size = AlignUp(m_capacity, largePage);
+			m_base = static_cast<std::uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+
+			if (m_base != nullptr)
+			{
+				m_capacity = size;
+				m_hugePages = true;
+			}
+		}
+
+		if (m_base == nullptr)
+		{
+			m_base = static_cast<std::uint8_t*>(VirtualAlloc(nullptr, m_capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+		}
+
+		if (m_base == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+#else
+		// over-reserve by a huge page so that the base can be aligned to one
+		const auto reserved = m_capacity + HugePageSize;
+		auto* mapping = static_cast<std::uint8_t*>(mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+
+		if (mapping == MAP_FAILED)
+		{
+			throw std::bad_alloc();
+		}
+
+		m_base = reinterpret_cast<std::uint8_t*>(AlignUp(reinterpret_cast<std::uintptr_t>(mapping), HugePageSize));
+
+		// return the unaligned head and the unused tail
+		const auto head = static_cast<std::size_t>(m_base - mapping);
+		if (head > 0) munmap(mapping, head);
+		if (reserved - head > m_capacity) munmap(m_base + m_capacity, reserved - head - m_capacity);
+
+#ifdef MADV_HUGEPAGE
+		m_hugePages = madvise(m_base, m_capacity, MADV_HUGEPAGE) == 0;
+#endif
+#endif
+
+		if (prefault)
+		{
+			for (std::size_t i = 0; i < m_capacity; i += 4096)
+			{
+				m_base[i] = 0;
+			}
+		}
+
+		m_statistics.capacity = m_capacity;
+		m_statistics.hugePages = m_hugePages;
+
+		m_charge = MemoryAccounting::Charge(MemoryAccounting::Global(), MemoryTag::Scratch, m_capacity);
+	}
+
+	Arena::~Arena()
+	{
+#ifdef _WIN32
+		VirtualFree(m_base, 0, MEM_RELEASE);
+#else
+		munmap(m_base, m_capacity);
+#endif
+	}
+
+	void* Arena::Allocate(const std::size_t bytes, const std::size_t alignment)
+	{
+		m_statistics.allocations++;
+
+		const auto start = AlignUp(m_used, alignment);
+
+		if (start + bytes > m_capacity)
+		{
+			m_statistics.overflows++;
+
+			// over-allocate so that the overflow buffer can be aligned as well
+			m_overflow.emplace_back(new std::uint8_t[bytes + alignment]);
+			return reinterpret_cast<void*>(AlignUp(reinterpret_cast<std::uintptr_t>(m_overflow.back().get()), alignment));
+		}
+
+		m_used = start + bytes;
+		m_statistics.highWater = std::max(m_statistics.highWater, m_used);
+
+		return m_base + start;
+	}
+
+	void Arena::Reset()
+	{
+		m_statistics.resets++;
+
+		m_used = 0;
+		m_overflow.clear();
+	}
+
+	void Arena::Rewind(const Mark mark)
+	{
+		m_used = std::min(m_used, mark.used);
+
+		if (m_overflow.size() > mark.overflows)
+		{
+			m_overflow.resize(mark.overflows);
+		}
+	}
+
+	Arena::Statistics Arena::GetStatistics() const
+	{
+		auto statistics = m_statistics;
+		statistics.used = m_used;
+
+		return statistics;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MemoryAccounting.h"
+
+namespace Experiment
+{
+	/// A bump allocator over one pre-reserved block of (huge page backed, where available) memory.
+	/// Allocations are never freed individually; the whole arena, or everything after a mark, is released in O(1)
+	class Arena
+	{
+	public:
+		static constexpr std::size_t DefaultAlignment = 64;
+
+		struct Statistics
+		{
+			std::size_t capacity = 0;
+			std::size_t used = 0;
+			std::size_t highWater = 0;
+
+			std::size_t allocations = 0;
+			std::size_t resets = 0;
+
+			/// Allocations which did not fit and were served from the heap instead
+			std::size_t overflows = 0;
+
+			bool hugePages = false;
+		};
+
+		/// A position in the arena to rewind to
+		struct Mark
+		{
+			std::size_t used = 0;
+			std::size_t overflows = 0;
+		};
+
+		/// Releases everything allocated after it was constructed when it goes out of scope
+		class Scope
+		{
+		public:
+			explicit Scope(Arena& arena) : m_arena(arena), m_mark(arena.GetMark()) {}
+			~Scope() { m_arena.Rewind(m_mark); }
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			Arena& m_arena;
+			Mark m_mark;
+		};
+
+		/// Reserves `capacity` bytes. If `prefault` is set, every page is touched now so that later allocations never fault
+		explicit Arena(std::size_t capacity, bool prefault = true);
+		~Arena();
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		/// Returns `bytes` of uninitialized memory, valid until the arena is reset or rewound past it
+		void* Allocate(std::size_t bytes, std::size_t alignment = DefaultAlignment);
+
+		template<typename T>
+		T* Allocate(const std::size_t count)
+		{
+			return static_cast<T*>(Allocate(count * sizeof(T), alignof(T) > DefaultAlignment ? alignof(T) : DefaultAlignment));
+		}
+
+		/// Releases every allocation
+		void Reset();
+
+		[[nodiscard]] Mark GetMark() const { return { m_used, m_overflow.size() }; }
+
+		/// Releases every allocation made after `mark`
+		void Rewind(Mark mark);
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		std::uint8_t* m_base = nullptr;
+		std::size_t m_capacity = 0;
+		std::size_t m_used = 0;
+		bool m_hugePages = false;
+
+		/// The reserved block; overflows are short lived and left out
+		MemoryAccounting::Charge m_charge;
+
+		std::vector<std::unique_ptr<std::uint8_t[]>> m_overflow;
+
+		Statistics m_statistics;
+	};
+}
@@ -0,0 +1,196 @@
+#include "Capture.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace Experiment
+{
+	FrameCapture::FrameCapture(const Encoding encoding, const unsigned threads, const std::size_t queued) :
+		m_encoding(encoding),
+		m_threads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+		m_queued(std::max<std::size_t>(1, queued))
+	{
+		for (std::uint32_t code = 0; code < 1024; code++)
+		{
+			// replicating the high bits maps 1023 to 65535
+			const auto sample = encoding == Encoding::Pq10 ? code : code << 6 | code >> 4;
+
+			const std::uint8_t bytes[2] = { static_cast<std::uint8_t>(sample >> 8), static_cast<std::uint8_t>(sample & 0xFF) };
+			std::memcpy(&m_samples[code], bytes, sizeof(bytes));
+		}
+
+		m_writer = std::thread([this] { Work(); });
+	}
+
+	FrameCapture::~FrameCapture()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_changed.notify_all();
+		m_writer.join();
+	}
+
+	void FrameCapture::Write(const std::filesystem::path& path, const ImageView<const std::uint32_t, 1> frame)
+	{
+		Job job;
+		job.path = path;
+		job.header = "P6\n" + std::to_string(frame.width) + " " + std::to_string(frame.height) + "\n" + (m_encoding == Encoding::Pq10 ? "1023" : "65535") + "\n";
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			const auto start = std::chrono::steady_clock::now();
+			m_changed.wait(lock, [this] { return m_jobs.size() < m_queued || m_error; });
+			m_statistics.waiting += std::chrono::steady_clock::now() - start;
+
+			Rethrow();
+
+			if (!m_free.empty())
+			{
+				job.pixels = std::move(m_free.back());
+				m_free.pop_back();
+			}
+		}
+
+		job.pixels.resize(static_cast<std::size_t>(frame.width) * frame.height * 6);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		// a band of rows per thread, the last one on this thread
+		std::vector<std::thread> converters;
+		const auto band = (frame.height + static_cast<int>(m_threads) - 1) / static_cast<int>(m_threads);
+
+		for (auto top = 0; top + band < frame.height; top += band)
+		{
+			converters.emplace_back([&, top] { Convert(frame, job.pixels.data(), top, top + band); });
+		}
+
+		Convert(frame, job.pixels.data(), static_cast<int>(converters.size()) * band, frame.height);
+
+		for (auto& converter : converters)
+		{
+			converter.join();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_statistics.converting += std::chrono::steady_clock::now() - start;
+			m_statistics.frames++;
+			m_statistics.bytes += job.header.size() + job.pixels.size();
+
+			m_jobs.push_back(std::move(job));
+		}
+
+		m_changed.notify_all();
+	}
+
+	void FrameCapture::Flush()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		const auto start = std::chrono::steady_clock::now();
+		m_changed.wait(lock, [this] { return (m_jobs.empty() && !m_writing) || m_error; });
+		m_statistics.waiting += std::chrono::steady_clock::now() - start;
+
+		Rethrow();
+	}
+
+	FrameCapture::Statistics FrameCapture::GetStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_statistics;
+	}
+
+	void FrameCapture::Convert(const ImageView<const std::uint32_t, 1> frame, std::uint8_t* out, const int top, const int bottom) const
+	{
+		for (auto y = top; y < bottom; y++)
+		{
+			const auto* in = frame.Row(y);
+			auto* sample = out + static_cast<std::size_t>(y) * frame.width * 6;
+
+			for (auto x = 0; x < frame.width; x++, sample += 6)
+			{
+				const auto pixel = in[x];
+				const std::uint16_t rgb[3] = { m_samples[pixel & 1023], m_samples[pixel >> 10 & 1023], m_samples[pixel >> 20 & 1023] };
+
+				std::memcpy(sample, rgb, sizeof(rgb));
+			}
+		}
+	}
+
+	void FrameCapture::Work()
+	{
+		for (;;)
+		{
+			Job job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_changed.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+
+				// the queue is drained before stopping
+				if (m_jobs.empty()) return;
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+				m_writing = true;
+			}
+
+			std::exception_ptr error;
+
+			try
+			{
+				std::ofstream file(job.path, std::ios::binary);
+				file << job.header;
+				file.write(reinterpret_cast<const char*>(job.pixels.data()), static_cast<std::streamsize>(job.pixels.size()));
+
+				if (!file)
+				{
+					throw std::runtime_error(job.path.generic_string() + " cannot be written");
+				}
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				m_writing = false;
+				m_free.push_back(std::move(job.pixels));
+
+				if (error && !m_error) m_error = error;
+			}
+
+			m_changed.notify_all();
+		}
+	}
+
+	void FrameCapture::Rethrow()
+	{
+		if (m_error)
+		{
+			const auto error = m_error;
+			m_error = nullptr;
+
+			std::rethrow_exception(error);
+		}
+	}
+
+	std::ostream& operator<<(std::ostream& os, const FrameCapture::Statistics& s)
+	{
+		const auto milliseconds = [](const std::chrono::steady_clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+		os << "frames: " << s.frames << ", " << s.bytes / (1024 * 1024) << " MB, converting: " << milliseconds(s.converting)
+			<< " ms, waiting for the disk: " << milliseconds(s.waiting) << " ms";
+		return os;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ImageView.h"
+
+namespace Experiment
+{
+	/// Writes frames presented by the CPU renderer as PPMs of their ST.2084 codes, to check and archive what participants saw.
+	/// A frame is converted on several threads while the caller waits, and written to disk by a background thread while the
+	/// caller renders the next one
+	class FrameCapture
+	{
+	public:
+		enum class Encoding
+		{
+			/// The 10-bit codes as they are, with a maxval of 1023
+			Pq10,
+			/// The codes scaled to 16 bits, which more viewers open
+			Pq16
+		};
+
+		struct Statistics
+		{
+			std::size_t frames = 0;
+			std::size_t bytes = 0;
+
+			std::chrono::steady_clock::duration converting = {};
+
+			/// The time the caller waited for the disk to catch up
+			std::chrono::steady_clock::duration waiting = {};
+		};
+
+		/// Converts on `threads` threads, including the caller's (0 for one per core), and lets `queued` frames wait for the disk
+		explicit FrameCapture(Encoding encoding, unsigned threads = 0, std::size_t queued = 2);
+
+		/// Writes the frames still queued
+		~FrameCapture();
+
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		/// Converts the R10G10B10A2 `frame` and queues it to be written to `path`; `frame` may be reused once this returns.
+		/// Blocks while the queue is full, and rethrows the error of a failed write
+		void Write(const std::filesystem::path& path, ImageView<const std::uint32_t, 1> frame);
+
+		/// Blocks until every queued frame is written, and rethrows the error of a failed write
+		void Flush();
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		struct Job
+		{
+			std::filesystem::path path;
+			std::string header;
+			std::vector<std::uint8_t> pixels;
+		};
+
+		void Convert(ImageView<const std::uint32_t, 1> frame, std::uint8_t* out, int top, int bottom) const;
+
+		void Work();
+
+		/// Rethrows the error of a failed write, if any. Requires the lock
+		void Rethrow();
+
+		Encoding m_encoding;
+		unsigned m_threads;
+		std::size_t m_queued;
+
+		/// The sample of every 10-bit code, laid out big endian
+		std::uint16_t m_samples[1024];
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_changed;
+
+		std::deque<Job> m_jobs;
+		bool m_writing = false;
+
+		/// The pixel buffers of written frames, reused so that steady state captures do not allocate
+		std::vector<std::vector<std::uint8_t>> m_free;
+
+		std::exception_ptr m_error;
+		bool m_stop = false;
+
+		Statistics m_statistics;
+
+		std::thread m_writer;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const FrameCapture::Statistics& s);
+}
@@ -1,6 +1,9 @@
 #include "Controller.h"
+#include "Log.h"
+#include "Trace.h"
 #include <utility>
 #include <ctime>
+#include <array>
 
 extern void ExitGame();
 
@@ -8,7 +11,8 @@ namespace Experiment {
 	static const std::string DESTINATION_PATH = R"(C:\projects\VESA_phase3\Data\)";
 	constexpr int FRAME_INTERVAL = 20;
 
-	Controller::Controller(Run& run, DX::DeviceResources* deviceResources) : m_deviceResources(deviceResources), m_run(run)
+	Controller::Controller(Run& run, DX::DeviceResources* deviceResources, IRenderer* renderer) : m_deviceResources(deviceResources), m_renderer(renderer), m_run(run),
+		m_trialMonitor(std::chrono::duration_cast<TrialMonitor::Clock::duration>(std::chrono::duration<float>(Configuration::FlickerRate)), Configuration::ImageTransitionDuration)
 	{
 		m_audioEngine = std::make_unique<DirectX::AudioEngine>(DirectX::AudioEngine_Default);
 
@@ -19,24 +23,257 @@ namespace Experiment {
 		this->m_flickerTimer = std::make_unique<Utils::Timer<>>(Configuration::FlickerRate * 1000.0);
 
 		this->m_stopwatch = std::make_unique<Utils::Stopwatch<>>();
+
+		this->m_imageCache = std::make_unique<ImageCache>(Configuration::ImageCacheBytes);
+
+		auto& memory = MemoryAccounting::Global();
+		memory.SetBudget(MemoryTag::DecodedFrames, Configuration::DecodedFramesBudgetBytes);
+		m_imageCacheEvictor = memory.AddEvictor(MemoryTag::DecodedFrames, [this](const std::size_t bytes) { return m_imageCache->Trim(bytes); });
+
+		if (Configuration::StimulusCacheEnabled)
+		{
+			this->m_diskCache = std::make_unique<DiskCache>(std::filesystem::home() / Configuration::StimulusCacheDirectory, Configuration::StimulusCacheBytes);
+		}
+
+		if (Configuration::PreloadSession)
+		{
+			StartPreload();
+		}
+
+		if (Configuration::WatchdogEnabled)
+		{
+			const auto period = std::chrono::duration_cast<Watchdog::Clock::duration>(std::chrono::duration<float>(Configuration::FlickerRate));
+
+			Watchdog::Settings settings;
+			settings.deadline = period + period / 2;
+			settings.window = Configuration::WatchdogWindow;
+			settings.directory = std::filesystem::home() / Configuration::WatchdogDirectory
+				/ ("Id" + m_run.participant.id + "_Session" + std::to_string(m_run.session) + "_" + Utils::FormatTime("%Y-%m-%d_%H-%M", std::chrono::system_clock::now()));
+
+			m_watchdog = std::make_unique<Watchdog>(settings, [](const Watchdog::Stall& stall)
+				{
+					LOG_WARNING("Watchdog: frame %zu late by %.1f ms in %s: %s, %s", stall.frame,
+						std::chrono::duration<double, std::milli>(stall.late).count(), stall.stage, stall.scope,
+						stall.snapshot.empty() ? std::string("no snapshot") : stall.snapshot.generic_string());
+				});
+		}
+
+		if (Configuration::SessionLogEnabled)
+		{
+			const auto directory = std::filesystem::home() / Configuration::SessionLogDirectory;
+			const auto name = "Id" + m_run.participant.id + "_Session" + std::to_string(m_run.session) + "_" + Utils::FormatTime("%Y-%m-%d_%H-%M", std::chrono::system_clock::now()) + ".ppmlog";
+
+			// a session is run without its log rather than not at all
+			try
+			{
+				std::filesystem::create_directories(directory);
+				m_sessionLog = std::make_unique<SessionLog::Recorder>(directory / name, m_run, m_preloader != nullptr);
+			}
+			catch (const std::exception& e)
+			{
+				LOG_WARNING("SessionLog: %s, the session is not logged", e.what());
+			}
+		}
+	}
+
+	Controller::~Controller()
+	{
+		// the preload threads write into the caches and timings of the controller, so they stop before any member is destroyed
+		m_preloader.reset();
+
+		MemoryAccounting::Global().RemoveEvictor(m_imageCacheEvictor);
+	}
+
+	void Controller::CreateDeviceDependentResources()
+	{
+		const auto device = m_deviceResources->GetD3DDevice();
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = Configuration::ImageDimensions.x;
+		desc.Height = Configuration::ImageDimensions.y;
+		desc.MipLevels = 1;
+		desc.ArraySize = 4;
+		desc.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC view = {};
+		view.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		view.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		view.Texture2DArray.MipLevels = 1;
+		view.Texture2DArray.ArraySize = desc.ArraySize;
+
+		for (auto& set : m_stimulusTextures)
+		{
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader;
+
+			DX::ThrowIfFailed(device->CreateTexture2D(&desc, nullptr, set.texture.ReleaseAndGetAddressOf()));
+			DX::ThrowIfFailed(device->CreateShaderResourceView(set.texture.Get(), &view, shader.GetAddressOf()));
+
+			for (UINT i = 0; i < desc.ArraySize; i++)
+			{
+				set.slices[i] = { set.texture.Get(), D3D11CalcSubresource(0, i, desc.MipLevels) };
+			}
+
+			set.view = std::make_shared<D3D11Texture>(shader, desc.Width, desc.Height, desc.ArraySize);
+		}
+
+		m_uploadDevice = std::make_unique<D3D11UploadDevice>(device, m_deviceResources->GetD3DDeviceContext());
+		m_uploads = std::make_unique<UploadRing>(*m_uploadDevice, Configuration::UploadSlots, Configuration::ImageDimensions.x, Configuration::ImageDimensions.y);
+
+		UploadScheduler::Settings settings;
+		settings.bandRows = Configuration::UploadBandRows;
+		settings.framePeriod = std::chrono::duration_cast<UploadScheduler::Clock::duration>(std::chrono::duration<float>(Configuration::FlickerRate));
+
+		m_uploadScheduler = std::make_unique<UploadScheduler>(*m_uploads, settings);
+	}
+
+	void Controller::FlushUploads(const std::chrono::steady_clock::duration slack)
+	{
+		m_uploadScheduler->Run(slack);
 	}
 
-	static cv::Mat CropMatrix(const cv::Mat& mat, const cv::Rect& cropRegion)
+	void Controller::FinishUploads()
 	{
-		const cv::Mat croppedRef(mat, cropRegion);
+		if (!m_uploadScheduler->IsIdle())
+		{
+			m_uploadScheduler->Finish();
+		}
+	}
+
+	/// Records the read and decode times of the stimuli of a trial
+	static void Record(const Ppm::Timings& timings, TrialPerformance& performance)
+	{
+		performance.readMilliseconds = std::chrono::duration<double, std::milli>(timings.read).count();
+		performance.decodeMilliseconds = std::chrono::duration<double, std::milli>(timings.decode).count();
+	}
+
+	void Controller::Presented(const Scene::Screen screen, const std::chrono::milliseconds elapsed)
+	{
+		m_trialMonitor.Presented(screen, TrialMonitor::Clock::now());
+		if (m_watchdog) m_watchdog->Beat();
+		if (m_sessionLog) m_sessionLog->Presented(screen, elapsed);
+	}
 
-		cv::Mat cropped;
-		croppedRef.copyTo(cropped);
+	/// Preloads every stimulus of the run, unless they do not fit in memory, in which case they are streamed per trial
+	void Controller::StartPreload()
+	{
+		const auto stimuli = m_run.trials.size() * 4;
+		const auto dims = Configuration::ImageDimensions;
+
+		const auto bytes = Preloader::RequiredBytes(stimuli, dims.x, dims.y);
+		const auto headroom = Configuration::PreloadHeadroomBytes + Configuration::ImageCacheBytes;
+
+		if (!Preloader::Fits(bytes, headroom))
+		{
+			LOG_WARNING("Preloader: %zu MB do not fit in %zu MB of available memory, streaming instead",
+				bytes / (1024 * 1024), Preloader::AvailableMemory() / (1024 * 1024));
+			return;
+		}
+
+		m_preloadTimings.assign(stimuli, {});
+
+		m_preloader = std::make_unique<Preloader>(stimuli, dims.x, dims.y, [this](const std::size_t index, Frame& slot)
+			{
+				const auto& trial = m_run.trials[index / 4];
+				const auto path = Scene::StimulusPaths(trial)[index % 4];
+
+				auto& timings = m_preloadTimings[index];
+				const auto frame = m_imageCache->Get(path, [this, &timings](const std::filesystem::path& p) { return LoadFrame(p, timings, DiskCache::WhenFull::Wait); });
+
+				CopyPixels(ConstRgba16View(*frame).Crop(trial.position.x, trial.position.y, slot.width, slot.height), Rgba16View(slot));
+			});
+
+		m_preloader->Start();
+	}
+
+	float Controller::GetPreloadProgress() const
+	{
+		return m_preloader ? m_preloader->Progress() : 1.0f;
+	}
+
+	void Controller::Start()
+	{
+		m_startButtonHasBeenPressed = true;
+		m_stopwatch->Restart();
 
-		return cropped;
+		if (m_sessionLog) m_sessionLog->Started();
+	}
+
+	/// The scratch memory of decodes on the calling thread, which only holds the file being decoded. It is not prefaulted: each
+	/// preload thread would otherwise fault in the whole of its own before its first decode, and the first read faults in only
+	/// as much as the file, which later reads on the thread reuse
+	static Arena& DecodeScratch()
+	{
+		thread_local Arena arena(Configuration::DecodeScratchBytes, false);
+		return arena;
+	}
+
+	/// Decodes `image` into a full resolution RGBA16 frame for the GPU
+	static Frame DecodeFrame(const std::filesystem::path& image, Ppm::Timings& timings)
+	{
+		TRACE_SCOPE("load", "Decode");
+
+		const auto start = std::chrono::steady_clock::now();
+
+		// binary PPMs are decoded natively, reading the file into scratch memory; anything else goes through OpenCV
+		try
+		{
+			return Ppm::Read(image, &DecodeScratch(), &timings);
+		}
+		catch (const std::runtime_error&)
+		{
+		}
+
+		const auto matrix = cv::imread(image.generic_string(), cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH);
+
+		if (matrix.type() != CV_16UC3 && matrix.type() != CV_8UC3)
+		{
+			Utils::FatalError(image.generic_string() + " is not a 3 channel 8 or 16 bit image");
+		}
+
+		std::shared_ptr<uint16_t[]> pixels(new uint16_t[matrix.total() * 4]);
+
+		Frame frame = {};
+		frame.width = matrix.cols;
+		frame.height = matrix.rows;
+		frame.stride = static_cast<std::size_t>(matrix.cols) * frame.PixelBytes();
+		frame.data = reinterpret_cast<uint8_t*>(pixels.get());
+		frame.owner = MemoryAccounting::Track(MemoryTag::DecodedFrames, matrix.total() * 4 * sizeof(uint16_t), pixels);
+
+		// OpenCV decodes BGR without alpha, which is swizzled into opaque RGBA16: alpha is written as 0xFFFF
+		Pixels::SourceImage source = {};
+		source.data = matrix.data;
+		source.width = matrix.cols;
+		source.height = matrix.rows;
+		source.stride = matrix.step;
+		source.format = matrix.depth() == CV_16U ? Pixels::SourceFormat::Uint16 : Pixels::SourceFormat::Uint8;
+		source.order = Pixels::ChannelOrder::Bgr;
+		source.maxval = matrix.depth() == CV_16U ? 65535 : 255;
+
+		Pixels::DestinationImage destination = {};
+		destination.data = frame.data;
+		destination.width = frame.width;
+		destination.height = frame.height;
+		destination.stride = frame.stride;
+
+		Pixels::Convert(source, 0, 0, destination, Pixels::FullRange(source));
+
+		// OpenCV reads and decodes in one call, which is counted as decoding
+		timings.decode += std::chrono::steady_clock::now() - start;
+
+		return frame;
 	}
 
 	bool Controller::GetResponse(const WPARAM key)
 	{
 		if (key == VK_RETURN)
 		{
-			m_startButtonHasBeenPressed = true;
-			m_stopwatch->Restart();
+			// the session cannot start before it has been preloaded
+			if (GetPreloadProgress() < 1.0f) return false;
+
+			Start();
 			return false;
 		}
 
@@ -53,7 +290,8 @@ namespace Experiment {
 		const auto response = (key == VK_LEFT) ? Option::Right : Option::Left;
 		AppendResponse(response);
 
-		return true;
+		// there is no next trial once the last one has been answered
+		return !m_finished;
 	}
 
 	double timeAtPress = 0;
@@ -71,10 +309,9 @@ namespace Experiment {
 
 		if (m_buttons.a == PRESSED || m_buttons.b == PRESSED)
 		{
-			if (!m_startButtonHasBeenPressed)
+			if (!m_startButtonHasBeenPressed && GetPreloadProgress() >= 1.0f)
 			{
-				m_startButtonHasBeenPressed = true;
-				m_stopwatch->Restart();
+				Start();
 			}
 
 			return false;
@@ -93,14 +330,20 @@ namespace Experiment {
 		const auto response = (left == PRESSED) ? Option::Right : Option::Left;
 		AppendResponse(response);
 
-		return true;
+		return !m_finished;
 	}
 
 	void Controller::AppendResponse(const Option response)
 	{
+		if (m_sessionLog) m_sessionLog->Answered(response);
+
 		m_run.trials[m_currentImageIndex].participantResponse = response;
 		m_run.trials[m_currentImageIndex].duration = timeAtPress;
 
+		auto& performance = m_run.trials[m_currentImageIndex].performance;
+		m_trialMonitor.Record(performance);
+		performance.uploadMilliseconds = std::chrono::duration<double, std::milli>(m_uploadScheduler->GetStatistics().totalTime - m_uploadTimeAtSchedule).count();
+
 		if (response != m_run.trials[m_currentImageIndex].correctOption)
 		{
 			m_failureSound->Play();
@@ -114,115 +357,135 @@ namespace Experiment {
 
 			m_run.Export(DESTINATION_PATH + filename);
 
+			std::stringstream ss;
+			ss << "ImageCache: " << m_imageCache->GetStatistics() << "\n";
+			if (m_diskCache) ss << "DiskCache: " << m_diskCache->GetStatistics() << "\n";
+			ss << "Uploads: " << m_uploads->GetStatistics() << "\n";
+			ss << "UploadScheduler: " << m_uploadScheduler->GetStatistics() << "\n";
+			if (m_preloader) ss << "Preloader: " << m_preloader->GetStatistics().bytes / (1024 * 1024) << " MB in " << m_preloader->GetStatistics().milliseconds << " ms\n";
+			if (m_watchdog) ss << "Watchdog: " << m_watchdog->GetStatistics() << "\n";
+			if (m_sessionLog) ss << "SessionLog: " << m_sessionLog->Entries() << " entries\n";
+			ss << "Log: " << Log::GetStatistics() << "\n";
+			ss << MemoryAccounting::Global();
+			Log::Write(Log::Level::Info, ss.str());
+			Log::Flush();
+
 			m_startButtonHasBeenPressed = false;
 
+			// written now, as the session is over
+			m_sessionLog.reset();
+
 			std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
+			// the UI thread stops the render thread and destroys the game, which destroys the controller
+			m_finished = true;
 			ExitGame();
-			exit(0);
 		}
 	}
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Controller::ToResource(const std::filesystem::path& image) const
+	/// Maps the decoded frame from the stimulus cache of a previous session, or decodes and stores it
+	Frame Controller::LoadFrame(const std::filesystem::path& image, Ppm::Timings& timings, const DiskCache::WhenFull whenFull) const
 	{
-		return ToResourceBase(image, [](auto m)
-			{
-				return m;
-			});
-	}
+		if (!m_diskCache)
+		{
+			return DecodeFrame(image, timings);
+		}
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Controller::ToResource(const std::filesystem::path& image, Vector region) const
-	{
-		return ToResourceBase(image, [&](auto m)
-			{
-				return CropMatrix(m, cv::Rect(region.x, region.y, Configuration::ImageDimensions.x, Configuration::ImageDimensions.y));
-			});
-	}
+		const auto start = std::chrono::steady_clock::now();
+		const auto identity = FileIdentity::Of(image);
 
+		if (auto cached = m_diskCache->Load(identity))
+		{
+			timings.read += std::chrono::steady_clock::now() - start;
+			return *cached;
+		}
 
-	template<typename F>
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Controller::ToResourceBase(const std::filesystem::path& image, F&& matTransformFunction) const
+		auto frame = DecodeFrame(image, timings);
+		m_diskCache->Store(identity, frame, {}, whenFull);
+
+		return frame;
+	}
+
+	std::shared_ptr<const ITexture> Controller::ToResource(const std::filesystem::path& image) const
 	{
 		if (!is_regular_file(image))
 		{
 			Utils::FatalError("" + image.generic_string() + " is not a valid path");
 		}
 
-		Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
-		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader;
+		Ppm::Timings timings;
+		const auto frame = m_imageCache->Get(image, [&](const std::filesystem::path& path) { return LoadFrame(path, timings); });
 
-		auto matrixoriginal = cv::imread(image.generic_string(), cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH);
-		cv::Mat matrix(matrixoriginal.size(), CV_MAKE_TYPE(matrixoriginal.depth(), 4));
+		return m_renderer->CreateTexture(ConstRgba16View(*frame));
+	}
 
-		// red is blue and blue is red and alpha is none
-		int conversion[] = { 2, 0, 1, 1, 0, 2, -1, 3 };
-		cv::mixChannels(&matrixoriginal, 1, &matrix, 1, conversion, 4);
+	void Controller::Stage(const ConstRgba16View image, const std::size_t index, const UploadScheduler::Clock::time_point deadline, std::shared_ptr<const void> owner)
+	{
+		auto& set = m_stimulusTextures[m_stimulusSet];
 
-		auto cropped = matTransformFunction(matrix);
+		m_uploadScheduler->Schedule(image, &set.slices[index], deadline, std::move(owner));
+	}
 
-		D3D11_TEXTURE2D_DESC desc = {};
-		desc.Width = cropped.cols;
-		desc.Height = cropped.rows;
-		desc.MipLevels = desc.ArraySize = 1;
-		desc.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
-		desc.SampleDesc.Count = 1;
-		desc.SampleDesc.Quality = 0;
-		desc.Usage = D3D11_USAGE_DEFAULT;
-		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE | D3D11_CPU_ACCESS_READ;
-		desc.MiscFlags = 0;
+	SingleView Controller::SetStaticStereoView(const Utils::Duo<std::filesystem::path>& views) const
+	{
+		return Scene::ComposeStaticStereoView(ToResource(views.left), ToResource(views.right));
+	}
 
+	std::pair<DuoView, DuoView> Controller::SetFlickerStereoViews(const int trialIndex)
+	{
+		TRACE_SCOPE("load", "Load trial");
 
-		auto hr = m_deviceResources->GetD3DDevice()->CreateTexture2D(&desc, nullptr, texture.GetAddressOf());
+		if (m_sessionLog) m_sessionLog->Loaded(trialIndex);
 
-		DX::ThrowIfFailed(hr);
+		auto& trial = m_run.trials[trialIndex];
 
-		try {
-			cv::directx::convertToD3D11Texture2D(cropped, texture.Get());
-		}
-		catch (cv::Exception& e)
+		// the uploads of the trial are timed until its response
+		m_uploadTimeAtSchedule = m_uploadScheduler->GetStatistics().totalTime;
+
+		if (!m_preloader)
 		{
-			Utils::FatalError(e.err);
+			return SetFlickerStereoViews(trial);
 		}
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC desc2 = { };
-		desc2.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
-		desc2.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		desc2.Texture2D.MipLevels = 1;
+		std::array<const Frame*, 4> preloaded = {};
 
-		m_deviceResources->m_d3dDevice->CreateShaderResourceView(
-			texture.Get(),
-			&desc2,
-			shader.GetAddressOf()
-		);
+		for (std::size_t i = 0; i < 4; i++)
+		{
+			preloaded[i] = m_preloader->Get(static_cast<std::size_t>(trialIndex) * 4 + i);
 
-		return shader;
-	}
+			// stimuli which could not be preloaded are streamed instead
+			if (preloaded[i] == nullptr)
+			{
+				return SetFlickerStereoViews(trial);
+			}
+		}
 
+		Ppm::Timings timings;
+		for (std::size_t i = 0; i < 4; i++)
+		{
+			const auto& preloadTimings = m_preloadTimings[static_cast<std::size_t>(trialIndex) * 4 + i];
+			timings.read += preloadTimings.read;
+			timings.decode += preloadTimings.decode;
+		}
 
-	SingleView Controller::SetStaticStereoView(const Utils::Duo<std::filesystem::path>& views) const
-	{
-		const auto l = ToResource(views.left);
-		const auto r = ToResource(views.right);
+		Record(timings, trial.performance);
+
+		m_stimulusSet ^= 1;
 
-		const auto dims = m_deviceResources->GetDimensions();
+		// the stimuli are shown once the transition is over
+		const auto deadline = UploadScheduler::Clock::now() + Configuration::ImageTransitionDuration;
 
-		return {
-			Image{ l, {0, 0} },
-			Image{ r, {3840, 0} }
-		};
+		for (std::size_t i = 0; i < 4; i++)
+		{
+			Stage(ConstRgba16View(*preloaded[i]), i, deadline);
+		}
+
+		return Scene::ComposeFlickerStereoViews(trial, m_stimulusTextures[m_stimulusSet].view);
 	}
 
-	std::pair<DuoView, DuoView> Controller::SetFlickerStereoViews(const Trial& trial) const
+	std::pair<DuoView, DuoView> Controller::SetFlickerStereoViews(Trial& trial)
 	{
-
-		auto paths = trial.imagePaths(trial.mode);
-		auto files = std::vector<std::filesystem::path>{
-			paths.leftCompressed,
-			paths.leftOriginal,
-			paths.rightCompressed,
-			paths.rightOriginal
-		};
+		const auto files = Scene::StimulusPaths(trial);
 
 		for (auto& path : files)
 		{
@@ -232,40 +495,24 @@ namespace Experiment {
 			}
 		}
 
-		std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> views(4);
+		m_stimulusSet ^= 1;
 
-		std::transform(files.begin(), files.end(), views.begin(), [this, trial](const std::filesystem::path path)
-			{
-				return ToResource(path, trial.position);
-			});
-
-		//std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> views;
-		const auto dims = DirectX::SimpleMath::Vector2{ 3840 * 2, 2160 };
-
-		auto halfDist = static_cast<float>(Configuration::ImageDistance) / 2;
-		auto yPos = dims.y / 2 - static_cast<float>(Configuration::ImageDimensions.y) / 2;
-
-		using Vec = DirectX::SimpleMath::Vector2;
+		const auto deadline = UploadScheduler::Clock::now() + Configuration::ImageTransitionDuration;
 
-		auto ll = Vec(dims.x / 4 - halfDist - Configuration::ImageDimensions.x, yPos);
-		auto lr = Vec(dims.x / 4 + halfDist, yPos);
-		auto rl = Vec(dims.x * 3 / 4 - halfDist - Configuration::ImageDimensions.x, yPos);
-		auto rr = Vec(dims.x * 3 / 4 + halfDist, yPos);
+		Ppm::Timings timings;
 
-		DuoView no_flicker = {
-			{Image{views[1], ll}, Image{views[1], lr} },
-			{Image{views[3], rl}, Image{views[3], rr} }
-		};
-
-		DuoView flicker = no_flicker;
-		auto i = static_cast<int>(trial.correctOption) - 1;
-
-		flicker.left[i].image = views[0];
-		flicker.right[i].image = views[2];
+		for (std::size_t i = 0; i < 4; i++)
+		{
+			// the cached frame is kept alive until its crop has been uploaded
+			const auto frame = m_imageCache->Get(files[i], [&](const std::filesystem::path& path) { return LoadFrame(path, timings); });
+			const auto crop = ConstRgba16View(*frame).Crop(trial.position.x, trial.position.y, Configuration::ImageDimensions.x, Configuration::ImageDimensions.y);
 
+			Stage(crop, i, deadline, frame);
+		}
 
+		Record(timings, trial.performance);
 
-		return std::make_pair(no_flicker, flicker);
+		return Scene::ComposeFlickerStereoViews(trial, m_stimulusTextures[m_stimulusSet].view);
 	}
 
 }
\ No newline at end of file
@@ -4,27 +4,53 @@
 #include <GamePad.h>
 #include "Stopwatch.h"
 #include "Participant.h"
+#include "ImageCache.h"
+#include "MemoryAccounting.h"
+#include "ImageView.h"
+#include "PixelPipeline.h"
+#include "D3D11Renderer.h"
+#include "D3D11UploadDevice.h"
+#include "UploadScheduler.h"
+#include "DiskCache.h"
+#include "Preloader.h"
+#include "Ppm.h"
+#include "Scene.h"
+#include "TrialMonitor.h"
+#include "Watchdog.h"
+#include "SessionLog.h"
+#include <array>
 
 constexpr auto FAILURE = L"Success3.wav";
 
 namespace Experiment
 {
-	struct Image
-	{
-		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> image;
-		DirectX::SimpleMath::Vector2 position;
-	};
-
-	using DuoView = Utils::Duo<Utils::Duo<Image>>;
-	using SingleView = Utils::Duo<Image>;
-	
-
 	class Controller
 	{
 	public:
-		Controller(Run& run, DX::DeviceResources* deviceResources);
+		Controller(Run& run, DX::DeviceResources* deviceResources, IRenderer* renderer);
+		~Controller();
+
+		Controller(const Controller&) = delete;
+		Controller& operator=(const Controller&) = delete;
+
+		/// Creates the stimulus textures and the upload ring, once the device exists
+		void CreateDeviceDependentResources();
+
+		/// Schedules the uploads of the stimuli of trial `trialIndex` of the run, from the preloaded session if there is one,
+		/// to complete by the end of the transition. The views are valid to draw after FinishUploads. The time spent reading and
+		/// decoding the stimuli is recorded in the performance of the trial
+		[[nodiscard]] std::pair<DuoView, DuoView> SetFlickerStereoViews(int trialIndex);
+		[[nodiscard]] std::pair<DuoView, DuoView> SetFlickerStereoViews(Trial& trial);
 
-		[[nodiscard]] std::pair<DuoView, DuoView> SetFlickerStereoViews(const Trial& trial) const;
+		/// Uploads what the scheduled stimuli need this frame, spending at most `slack` unless a deadline requires more; called once per frame
+		void FlushUploads(std::chrono::steady_clock::duration slack);
+
+		/// Completes the scheduled stimulus uploads, before the stimuli are drawn
+		void FinishUploads();
+
+		/// Counts a frame of `screen`, chosen on the stopwatch reading `elapsed`, which has just been presented, for the performance
+		/// of the current trial and the session log
+		void Presented(Scene::Screen screen, std::chrono::milliseconds elapsed);
 
 		[[nodiscard]] SingleView SetStaticStereoView(const Utils::Duo<std::filesystem::path>& views) const;
 
@@ -38,8 +64,17 @@ namespace Experiment
 
 		[[nodiscard]] DirectX::AudioEngine* GetAudioEngine() const { return m_audioEngine.get(); }
 
+		[[nodiscard]] ImageCache* GetImageCache() const { return m_imageCache.get(); }
+
+		/// The fraction of the session preloaded, which is 1 when not preloading
+		[[nodiscard]] float GetPreloadProgress() const;
+
+		/// Whether the last trial has been answered and the results exported, after which the app is quitting
+		[[nodiscard]] bool IsFinished() const { return m_finished; }
+
 		int m_currentImageIndex = 0;
 		bool m_startButtonHasBeenPressed = false;
+		bool m_finished = false;
 
 		Run* GetRun()
 		{
@@ -48,13 +83,23 @@ namespace Experiment
 
 	private:
 		void AppendResponse(Option response);
-		
-		[[nodiscard]] Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ToResource(const std::filesystem::path& image) const;
-		[[nodiscard]] Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ToResource(const std::filesystem::path& image, Vector region) const;
-		template <class F>
-		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ToResourceBase(const std::filesystem::path& image,  F&& matTransformFunction) const;
+
+		void StartPreload();
+
+		/// Starts the session, once it has been preloaded
+		void Start();
+
+		/// Adds the time spent reading and decoding `image` to `timings`; mapping it from the stimulus cache counts as reading.
+		/// `whenFull` is Wait on the preload threads, which may wait for the stimulus cache to write what they decoded
+		[[nodiscard]] Frame LoadFrame(const std::filesystem::path& image, Ppm::Timings& timings, DiskCache::WhenFull whenFull = DiskCache::WhenFull::Skip) const;
+
+		[[nodiscard]] std::shared_ptr<const ITexture> ToResource(const std::filesystem::path& image) const;
+
+		/// Schedules `image` into slice `index` of the stimuli of the current set by `deadline`. `owner` keeps the pixels alive until the upload
+		void Stage(ConstRgba16View image, std::size_t index, UploadScheduler::Clock::time_point deadline, std::shared_ptr<const void> owner = nullptr);
 
 		DX::DeviceResources* m_deviceResources;
+		IRenderer* m_renderer;
 		Experiment::Run m_run;
 
 		DirectX::GamePad::ButtonStateTracker m_buttons;
@@ -66,6 +111,45 @@ namespace Experiment
 		std::unique_ptr<Utils::Timer<>> m_flickerTimer;
 
 		std::unique_ptr<Utils::Stopwatch<>> m_stopwatch;
+
+		std::unique_ptr<ImageCache> m_imageCache;
+		std::unique_ptr<DiskCache> m_diskCache;
+
+		/// Trims the image cache when decoded frames exceed their budget
+		std::size_t m_imageCacheEvictor = 0;
+
+		/// The read and decode times of each preloaded stimulus, each written by the preload thread which loads it
+		std::vector<Ppm::Timings> m_preloadTimings;
+
+		/// Declared after what its threads write into, so that it is destroyed, and its threads joined, first
+		std::unique_ptr<Preloader> m_preloader;
+
+		TrialMonitor m_trialMonitor;
+
+		/// Snapshots the trace when a frame is presented late
+		std::unique_ptr<Watchdog> m_watchdog;
+
+		/// Records what drives the session, to replay it
+		std::unique_ptr<SessionLog::Recorder> m_sessionLog;
+
+		/// The upload time of the scheduler when the current trial was scheduled
+		UploadScheduler::Clock::duration m_uploadTimeAtSchedule = {};
+
+		/// The four stimuli of a trial, as the slices of one texture array so that they are drawn with a single bind
+		struct StimulusTextures
+		{
+			Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+			std::array<D3D11UploadTarget, 4> slices;
+			std::shared_ptr<const ITexture> view;
+		};
+
+		/// Two sets, alternated per trial, so that the next trial is never uploaded into textures which are being drawn
+		std::array<StimulusTextures, 2> m_stimulusTextures;
+		std::size_t m_stimulusSet = 0;
+
+		std::unique_ptr<D3D11UploadDevice> m_uploadDevice;
+		std::unique_ptr<UploadRing> m_uploads;
+		std::unique_ptr<UploadScheduler> m_uploadScheduler;
 	};
 
 }
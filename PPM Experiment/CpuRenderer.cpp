@@ -0,0 +1,369 @@
+#include "CpuRenderer.h"
+#include "MemoryAccounting.h"
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CPU_RENDERER_SSE2
+#endif
+
+namespace Experiment
+{
+	namespace
+	{
+		/// The texture of the CPU renderer holds its pixels tone mapped, as they are presented
+		class CpuTexture final : public ITexture
+		{
+		public:
+			CpuTexture(const int width, const int height, const int slices) :
+				pixels(static_cast<std::size_t>(width) * height * slices), m_width(width), m_height(height), m_slices(slices),
+				m_charge(MemoryAccounting::Global(), MemoryTag::Textures, pixels.size() * sizeof(std::uint32_t)) {}
+
+			[[nodiscard]] int Width() const override { return m_width; }
+			[[nodiscard]] int Height() const override { return m_height; }
+			[[nodiscard]] int Slices() const override { return m_slices; }
+
+			[[nodiscard]] const std::uint32_t* Slice(const int slice) const { return pixels.data() + static_cast<std::size_t>(m_width) * m_height * slice; }
+
+			/// The slices, one after the other
+			std::vector<std::uint32_t> pixels;
+
+		private:
+			int m_width;
+			int m_height;
+			int m_slices;
+
+			MemoryAccounting::Charge m_charge;
+		};
+
+		/// The rows of a band, small enough to balance the threads and large enough to amortize taking one
+		constexpr int BandRows = 16;
+
+		/// Rec.709 to Rec.2020 primaries, which DirectXTK's tone map applies before the ST.2084 curve
+		constexpr float From709To2020[3][3] = {
+			{ 0.6274040f, 0.3292820f, 0.0433136f },
+			{ 0.0690970f, 0.9195400f, 0.0113612f },
+			{ 0.0163916f, 0.0880132f, 0.8955950f }
+		};
+
+		/// The ST.2084 curve of a luminance normalized to 10000 nits
+		double ST2084(const double normalized)
+		{
+			constexpr auto m1 = 2610.0 / 16384;
+			constexpr auto m2 = 2523.0 / 4096 * 128;
+			constexpr auto c1 = 3424.0 / 4096;
+			constexpr auto c2 = 2413.0 / 4096 * 32;
+			constexpr auto c3 = 2392.0 / 4096 * 32;
+
+			const auto p = std::pow(std::abs(normalized), m1);
+			return std::pow((c1 + c2 * p) / (1 + c3 * p), m2);
+		}
+
+		std::uint32_t Quantize(const double value, const std::uint32_t maximum)
+		{
+			return static_cast<std::uint32_t>(std::lround(std::clamp(value, 0.0, 1.0) * maximum));
+		}
+	}
+
+	CpuRenderer::CpuRenderer() : CpuRenderer(Settings{})
+	{
+	}
+
+	CpuRenderer::CpuRenderer(const Settings settings) :
+		m_settings(settings),
+		m_codes(65536),
+		m_clear(ToneMap({ 0, 0, 0, 0 }, settings.paperWhiteNits))
+	{
+		for (std::size_t i = 0; i < m_codes.size(); i++)
+		{
+			m_codes[i] = static_cast<std::uint16_t>(Quantize(ST2084(i / 65535.0 * settings.paperWhiteNits / 10000), 1023));
+		}
+
+		for (auto& buffer : m_buffers)
+		{
+			buffer.assign(static_cast<std::size_t>(settings.width) * settings.height, m_clear);
+		}
+
+		// a few windows and the progress bar; more only grow the list once
+		m_commands.reserve(16);
+
+		const auto threads = settings.threads > 0 ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+
+		for (unsigned i = 1; i < threads; i++)
+		{
+			m_workers.emplace_back([this] { Work(); });
+		}
+	}
+
+	CpuRenderer::~CpuRenderer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_wake.notify_all();
+
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	std::shared_ptr<const ITexture> CpuRenderer::CreateTexture(const ConstRgba16View pixels)
+	{
+		return CreateTextureArray(&pixels, 1);
+	}
+
+	std::shared_ptr<const ITexture> CpuRenderer::CreateTextureArray(const ConstRgba16View* slices, const std::size_t count)
+	{
+		if (count == 0)
+		{
+			throw std::invalid_argument("CpuRenderer: a texture has at least one slice");
+		}
+
+		const auto width = slices[0].width, height = slices[0].height;
+
+		for (std::size_t i = 1; i < count; i++)
+		{
+			if (slices[i].width != width || slices[i].height != height)
+			{
+				throw std::invalid_argument("CpuRenderer: the slices of a texture array differ in size");
+			}
+		}
+
+		auto texture = std::make_shared<CpuTexture>(width, height, static_cast<int>(count));
+		auto* out = texture->pixels.data();
+
+		// the rows of every slice, as one column of images
+		Parallel(height * static_cast<int>(count), [&](const int top, const int bottom)
+			{
+				for (auto y = top; y < bottom; y++)
+				{
+					ToneMapRow(slices[y / height].Row(y % height), out + static_cast<std::size_t>(y) * width, width);
+				}
+			});
+
+		return texture;
+	}
+
+	void CpuRenderer::Begin()
+	{
+		m_commands.clear();
+	}
+
+	void CpuRenderer::Draw(const ITexture& texture, const Point position, const bool flipHorizontally, const int slice)
+	{
+		const auto* cpuTexture = dynamic_cast<const CpuTexture*>(&texture);
+
+		if (cpuTexture == nullptr)
+		{
+			throw std::invalid_argument("CpuRenderer: the texture was created by another renderer");
+		}
+
+		if (slice < 0 || slice >= texture.Slices())
+		{
+			throw std::out_of_range("CpuRenderer: the texture has no slice " + std::to_string(slice));
+		}
+
+		const auto x = static_cast<int>(std::lround(position.x));
+		const auto y = static_cast<int>(std::lround(position.y));
+
+		m_commands.push_back({ cpuTexture->Slice(slice), { x, y, x + texture.Width(), y + texture.Height() }, flipHorizontally, 0 });
+	}
+
+	void CpuRenderer::Fill(const Rect& rectangle, const Color color)
+	{
+		m_commands.push_back({ nullptr, rectangle, false, ToneMap(color, m_settings.paperWhiteNits) });
+	}
+
+	void CpuRenderer::End()
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		Parallel(m_settings.height, [this](const int top, const int bottom) { RenderRows(top, bottom); });
+
+		const auto duration = std::chrono::steady_clock::now() - start;
+
+		m_statistics.frames++;
+		m_statistics.draws += m_commands.size();
+		m_statistics.longestFrame = std::max(m_statistics.longestFrame, duration);
+		m_statistics.totalFrames += duration;
+	}
+
+	void CpuRenderer::Present()
+	{
+		m_back ^= 1;
+	}
+
+	ImageView<const std::uint32_t, 1> CpuRenderer::GetFrontBuffer() const
+	{
+		return { m_buffers[m_back ^ 1].data(), m_settings.width, m_settings.height };
+	}
+
+	void CpuRenderer::Parallel(const int rows, const std::function<void(int top, int bottom)>& work)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_work = &work;
+			m_rows = rows;
+			m_nextBand = 0;
+			m_working = m_workers.size();
+			m_generation++;
+		}
+
+		m_wake.notify_all();
+
+		RunBands();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_working == 0; });
+	}
+
+	void CpuRenderer::Work()
+	{
+		std::size_t generation = 0;
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+
+				if (m_stop) return;
+				generation = m_generation;
+			}
+
+			RunBands();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_working == 0) m_done.notify_one();
+			}
+		}
+	}
+
+	void CpuRenderer::RunBands()
+	{
+		const auto bands = (m_rows + BandRows - 1) / BandRows;
+
+		for (auto band = m_nextBand++; band < bands; band = m_nextBand++)
+		{
+			(*m_work)(band * BandRows, std::min(m_rows, (band + 1) * BandRows));
+		}
+	}
+
+	void CpuRenderer::RenderRows(const int top, const int bottom)
+	{
+		auto& buffer = m_buffers[m_back];
+
+		for (auto y = top; y < bottom; y++)
+		{
+			auto* out = buffer.data() + static_cast<std::size_t>(y) * m_settings.width;
+
+			std::fill_n(out, m_settings.width, m_clear);
+
+			// in the order drawn, each over the previous ones
+			for (const auto& command : m_commands)
+			{
+				const auto& r = command.rectangle;
+				const auto left = std::max(r.left, 0);
+				const auto right = std::min(r.right, m_settings.width);
+
+				if (y < r.top || y >= r.bottom || left >= right) continue;
+
+				if (command.pixels == nullptr)
+				{
+					std::fill(out + left, out + right, command.fill);
+					continue;
+				}
+
+				const auto* row = command.pixels + static_cast<std::size_t>(y - r.top) * (r.right - r.left);
+
+				if (command.flip)
+				{
+					// the rightmost column of the texture is drawn at its left
+					std::reverse_copy(row + (r.right - right), row + (r.right - left), out + left);
+				}
+				else
+				{
+					std::copy(row + (left - r.left), row + (right - r.left), out + left);
+				}
+			}
+		}
+	}
+
+	void CpuRenderer::ToneMapRow(const std::uint16_t* in, std::uint32_t* out, const int count) const
+	{
+		const auto* codes = m_codes.data();
+		const auto& m = From709To2020;
+
+#ifdef CPU_RENDERER_SSE2
+		// each pixel is one vector: the channels are rotated to Rec.2020 by summing the columns of the matrix they weigh,
+		// which also scales alpha to its two bits, and rounded to the indices of the codes
+		const auto zero = _mm_setzero_si128();
+		const auto red = _mm_setr_ps(m[0][0], m[1][0], m[2][0], 0);
+		const auto green = _mm_setr_ps(m[0][1], m[1][1], m[2][1], 0);
+		const auto blue = _mm_setr_ps(m[0][2], m[1][2], m[2][2], 0);
+		const auto alpha = _mm_setr_ps(0, 0, 0, 3.0f / 65535);
+		const auto maximum = _mm_set1_ps(65535);
+
+		for (auto i = 0; i < count; i++, in += 4)
+		{
+			const auto pixel = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)), zero));
+
+			auto mixed = _mm_mul_ps(_mm_shuffle_ps(pixel, pixel, 0x00), red);
+			mixed = _mm_add_ps(mixed, _mm_mul_ps(_mm_shuffle_ps(pixel, pixel, 0x55), green));
+			mixed = _mm_add_ps(mixed, _mm_mul_ps(_mm_shuffle_ps(pixel, pixel, 0xAA), blue));
+			mixed = _mm_add_ps(mixed, _mm_mul_ps(_mm_shuffle_ps(pixel, pixel, 0xFF), alpha));
+
+			alignas(16) std::int32_t index[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvtps_epi32(_mm_min_ps(mixed, maximum)));
+
+			out[i] = codes[index[0]] | static_cast<std::uint32_t>(codes[index[1]]) << 10 | static_cast<std::uint32_t>(codes[index[2]]) << 20 | static_cast<std::uint32_t>(index[3]) << 30;
+		}
+#else
+		const auto index = [&](const int channel)
+		{
+			const auto mixed = m[channel][0] * in[0] + m[channel][1] * in[1] + m[channel][2] * in[2];
+			return static_cast<std::uint32_t>(std::min(mixed, 65535.0f) + 0.5f);
+		};
+
+		for (auto i = 0; i < count; i++, in += 4)
+		{
+			const auto a = (static_cast<std::uint32_t>(in[3]) * 3 + 32767) / 65535;
+			out[i] = codes[index(0)] | static_cast<std::uint32_t>(codes[index(1)]) << 10 | static_cast<std::uint32_t>(codes[index(2)]) << 20 | a << 30;
+		}
+#endif
+	}
+
+	std::uint32_t CpuRenderer::ToneMap(const Color color, const float paperWhiteNits)
+	{
+		const double in[3] = { color.r, color.g, color.b };
+
+		auto pixel = Quantize(color.a, 3) << 30;
+
+		for (auto channel = 0; channel < 3; channel++)
+		{
+			const auto& row = From709To2020[channel];
+			const auto mixed = row[0] * in[0] + row[1] * in[1] + row[2] * in[2];
+
+			pixel |= Quantize(ST2084(mixed * paperWhiteNits / 10000), 1023) << (10 * channel);
+		}
+
+		return pixel;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const CpuRenderer::Statistics& s)
+	{
+		const auto milliseconds = [](const std::chrono::steady_clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+		os << "frames: " << s.frames << ", draws: " << s.draws << ", longest frame: " << milliseconds(s.longestFrame) << " ms, mean: "
+			<< (s.frames > 0 ? milliseconds(s.totalFrames) / static_cast<double>(s.frames) : 0.0) << " ms";
+		return os;
+	}
+}
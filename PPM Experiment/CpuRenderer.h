@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Renderer.h"
+
+namespace Experiment
+{
+	/// Renders into memory what the D3D11 renderer renders on the GPU, so that the experiment runs headless. Draws are opaque, as those
+	/// of the experiment are, so the tone map of a pixel does not depend on what it is drawn over: textures are tone mapped once when
+	/// created, and End composites the draws of a frame by copying their rows, mirrored if flipped. Both run in bands of rows on every
+	/// core. Textures must outlive the End of the frames drawing them
+	class CpuRenderer final : public IRenderer
+	{
+	public:
+		struct Settings
+		{
+			/// Both windows, side by side
+			int width = 7680;
+			int height = 2160;
+
+			/// The luminance of a scene value of 1, as given to ToneMapPostProcess::SetST2084Parameter
+			float paperWhiteNits = 64;
+
+			/// The threads rendering, including the calling one; 0 for one per core
+			unsigned threads = 0;
+		};
+
+		struct Statistics
+		{
+			std::size_t frames = 0;
+			std::size_t draws = 0;
+
+			/// The time End took, which is the whole cost of a frame once its textures exist
+			std::chrono::steady_clock::duration longestFrame = {};
+			std::chrono::steady_clock::duration totalFrames = {};
+		};
+
+		CpuRenderer();
+		explicit CpuRenderer(Settings settings);
+		~CpuRenderer() override;
+
+		CpuRenderer(const CpuRenderer&) = delete;
+		CpuRenderer& operator=(const CpuRenderer&) = delete;
+
+		/// Creates a texture of the tone mapped `pixels`
+		[[nodiscard]] std::shared_ptr<const ITexture> CreateTexture(ConstRgba16View pixels) override;
+		[[nodiscard]] std::shared_ptr<const ITexture> CreateTextureArray(const ConstRgba16View* slices, std::size_t count) override;
+
+		void Begin() override;
+		void Draw(const ITexture& texture, Point position, bool flipHorizontally = false, int slice = 0) override;
+		void Fill(const Rect& rectangle, Color color) override;
+		void End() override;
+		void Present() override;
+
+		/// The last frame presented, as R10G10B10A2 pixels like those of the swap chain
+		[[nodiscard]] ImageView<const std::uint32_t, 1> GetFrontBuffer() const;
+
+		[[nodiscard]] Statistics GetStatistics() const { return m_statistics; }
+
+		/// The R10G10B10A2 pixel a scene color is tone mapped to, computed exactly: the Rec.709 color in Rec.2020 primaries, ST.2084 encoded
+		[[nodiscard]] static std::uint32_t ToneMap(Color color, float paperWhiteNits);
+
+	private:
+		/// A rectangle of the scene, filled either with the tone mapped pixels of a texture or with a tone mapped color
+		struct Command
+		{
+			const std::uint32_t* pixels = nullptr;
+			Rect rectangle;
+			bool flip = false;
+			std::uint32_t fill = 0;
+		};
+
+		/// Runs `work` over `rows` in bands, on every thread
+		void Parallel(int rows, const std::function<void(int top, int bottom)>& work);
+
+		/// Runs the bands of the current work not taken by another thread yet
+		void RunBands();
+
+		void RenderRows(int top, int bottom);
+
+		/// Tone maps a row of `count` pixels
+		void ToneMapRow(const std::uint16_t* in, std::uint32_t* out, int count) const;
+
+		void Work();
+
+		Settings m_settings;
+
+		/// The 10-bit ST.2084 code of every Rec.2020 value scaled to 16 bits
+		std::vector<std::uint16_t> m_codes;
+		std::uint32_t m_clear;
+
+		std::vector<Command> m_commands;
+
+		std::vector<std::uint32_t> m_buffers[2];
+		std::size_t m_back = 0;
+
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		std::size_t m_generation = 0;
+		std::size_t m_working = 0;
+		bool m_stop = false;
+
+		const std::function<void(int, int)>* m_work = nullptr;
+		int m_rows = 0;
+		std::atomic<int> m_nextBand{ 0 };
+
+		Statistics m_statistics;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const CpuRenderer::Statistics& s);
+}
@@ -0,0 +1,228 @@
+#include "pch.h"
+#include "D3D11Renderer.h"
+#include "Log.h"
+#include "Trace.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Experiment
+{
+	D3D11Texture::D3D11Texture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> view, const int width, const int height, const int slices) :
+		m_view(std::move(view)),
+		m_width(width),
+		m_height(height),
+		m_slices(slices),
+		m_charge(MemoryAccounting::Global(), MemoryTag::Textures, static_cast<std::size_t>(width) * height * slices * 8)
+	{
+	}
+
+	D3D11Renderer::D3D11Renderer(DX::DeviceResources* deviceResources, const FrameGraph& frame) : m_deviceResources(deviceResources)
+	{
+		const auto plan = frame.graph.Compile();
+
+		m_hdrScenePass = plan.IsAllocated(frame.scene);
+		m_depthBuffer = plan.IsAllocated(frame.depth);
+
+		Log::Write(Log::Level::Info, "D3D11Renderer: " + frame.graph.Describe(plan));
+
+		if (m_hdrScenePass)
+		{
+			m_hdrScene = std::make_unique<DX::RenderTexture>(DXGI_FORMAT_R16G16B16A16_FLOAT);
+		}
+	}
+
+	void D3D11Renderer::CreateDeviceDependentResources()
+	{
+		auto device = m_deviceResources->GetD3DDevice();
+
+		m_spriteDevice = std::make_unique<D3D11SpriteDevice>(device, m_deviceResources->GetD3DDeviceContext(), m_hdrScenePass ? 0 : PaperWhiteNits);
+		m_batcher = std::make_unique<SpriteBatcher>(*m_spriteDevice);
+
+		// a single white texel, stretched and tinted to draw solid rectangles
+		{
+			const uint16_t white[] = { 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF };
+
+			m_whiteTexture = CreateTexture(ConstRgba16View(white, 1, 1));
+		}
+
+		if (m_hdrScenePass)
+		{
+			m_hdrScene->SetDevice(device);
+			m_toneMap = std::make_unique<DirectX::ToneMapPostProcess>(device);
+
+			m_toneMap->SetST2084Parameter(PaperWhiteNits);
+		}
+	}
+
+	void D3D11Renderer::CreateWindowSizeDependentResources() const
+	{
+		if (!m_hdrScenePass) return;
+
+		auto size = m_deviceResources->GetOutputSize();
+		m_hdrScene->SetWindow(size);
+		m_hdrSceneCharge = MemoryAccounting::Charge(MemoryAccounting::Global(), MemoryTag::Textures, static_cast<std::size_t>(size.right - size.left) * (size.bottom - size.top) * 8);
+
+		m_toneMap->SetHDRSourceTexture(m_hdrScene->GetShaderResourceView());
+	}
+
+	void D3D11Renderer::OnDeviceLost()
+	{
+		if (m_hdrScene) m_hdrScene->ReleaseDevice();
+		m_hdrSceneCharge = {};
+
+		m_toneMap.reset();
+		m_batcher.reset();
+		m_spriteDevice.reset();
+		m_whiteTexture.reset();
+	}
+
+	std::shared_ptr<const ITexture> D3D11Renderer::CreateTexture(const ConstRgba16View pixels)
+	{
+		return CreateTextureArray(&pixels, 1);
+	}
+
+	std::shared_ptr<const ITexture> D3D11Renderer::CreateTextureArray(const ConstRgba16View* slices, const std::size_t count)
+	{
+		if (count == 0)
+		{
+			throw std::invalid_argument("D3D11Renderer: a texture has at least one slice");
+		}
+
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader;
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = slices[0].width;
+		desc.Height = slices[0].height;
+		desc.MipLevels = 1;
+		desc.ArraySize = static_cast<UINT>(count);
+		desc.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = 0;
+
+		std::vector<D3D11_SUBRESOURCE_DATA> data(count);
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			if (slices[i].width != slices[0].width || slices[i].height != slices[0].height)
+			{
+				throw std::invalid_argument("D3D11Renderer: the slices of a texture array differ in size");
+			}
+
+			data[i].pSysMem = slices[i].data;
+			data[i].SysMemPitch = static_cast<UINT>(slices[i].stride);
+		}
+
+		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateTexture2D(&desc, data.data(), texture.GetAddressOf()));
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC view = {};
+		view.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		view.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		view.Texture2DArray.MipLevels = 1;
+		view.Texture2DArray.ArraySize = desc.ArraySize;
+
+		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateShaderResourceView(texture.Get(), &view, shader.GetAddressOf()));
+
+		return std::make_shared<D3D11Texture>(shader, slices[0].width, slices[0].height, static_cast<int>(count));
+	}
+
+	// Helper method to clear the back buffers.
+	void D3D11Renderer::Clear()
+	{
+		m_deviceResources->PIXBeginEvent(L"Clear");
+		TRACE_SCOPE("render", "Clear");
+
+		// Clear the views.
+		auto context = m_deviceResources->GetD3DDeviceContext();
+
+		// black is 0 both in the linear scene and in ST.2084
+		auto renderTarget = m_hdrScenePass ? m_hdrScene->GetRenderTargetView() : m_deviceResources->GetRenderTargetView();
+		const auto depthStencil = m_depthBuffer ? m_deviceResources->GetDepthStencilView() : nullptr;
+
+		DirectX::XMVECTORF32 color;
+		auto actual = DirectX::FXMVECTOR({ {0, 0, 0, 0} });
+		color.v = DirectX::XMColorSRGBToRGB(actual);
+		context->ClearRenderTargetView(renderTarget, color);
+
+		if (depthStencil)
+		{
+			context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+		}
+
+		context->OMSetRenderTargets(1, &renderTarget, depthStencil);
+
+		// Set the viewport.
+		auto viewport = m_deviceResources->GetScreenViewport();
+		context->RSSetViewports(1, &viewport);
+
+		m_deviceResources->PIXEndEvent();
+	}
+
+	void D3D11Renderer::Begin()
+	{
+		Clear();
+
+		m_deviceResources->PIXBeginEvent(L"Render");
+		TRACE_BEGIN("render", "Render");
+
+		const auto viewport = m_deviceResources->GetScreenViewport();
+		m_spriteDevice->Begin(static_cast<int>(viewport.Width), static_cast<int>(viewport.Height));
+
+		// the tone map of the previous frame bound its own texture
+		m_batcher->Invalidate();
+	}
+
+	void D3D11Renderer::Draw(const ITexture& texture, const Point position, const bool flipHorizontally, const int slice)
+	{
+		const auto* d3dTexture = dynamic_cast<const D3D11Texture*>(&texture);
+
+		if (d3dTexture == nullptr)
+		{
+			throw std::invalid_argument("D3D11Renderer: the texture was created by another renderer");
+		}
+
+		if (slice < 0 || slice >= texture.Slices())
+		{
+			throw std::out_of_range("D3D11Renderer: the texture has no slice " + std::to_string(slice));
+		}
+
+		m_batcher->Draw(d3dTexture->GetView(), position, texture.Width(), texture.Height(), flipHorizontally, slice);
+	}
+
+	void D3D11Renderer::Fill(const Rect& rectangle, const Color color)
+	{
+		m_batcher->Fill(static_cast<const D3D11Texture&>(*m_whiteTexture).GetView(), rectangle, color);
+	}
+
+	void D3D11Renderer::End()
+	{
+		auto context = m_deviceResources->GetD3DDeviceContext();
+
+		m_batcher->Flush();
+
+		TRACE_END();
+		m_deviceResources->PIXEndEvent();
+
+		if (!m_hdrScenePass) return;
+
+		auto renderTarget = m_deviceResources->GetRenderTargetView();
+		context->OMSetRenderTargets(1, &renderTarget, nullptr);
+
+		m_toneMap->Process(context);
+
+		ID3D11ShaderResourceView* nullsrv[] = { nullptr };
+		context->PSSetShaderResources(0, 1, nullsrv);
+	}
+
+	void D3D11Renderer::Present()
+	{
+		m_deviceResources->ThreadPresent();
+
+		m_deviceResources->DiscardView();
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <wrl/client.h>
+#include "pch.h"
+#include "DeviceResources.h"
+#include "RenderTexture.h"
+#include <PostProcess.h>
+#include "D3D11SpriteDevice.h"
+#include "MemoryAccounting.h"
+#include "Renderer.h"
+#include "RenderGraph.h"
+#include "SpriteBatcher.h"
+
+namespace Experiment
+{
+	/// The texture of the D3D11 renderer is the shader resource view of a texture array, of a single slice unless created as an array.
+	/// Its texels are charged to the memory accounting as RGBA16, the format of the stimuli
+	class D3D11Texture final : public ITexture
+	{
+	public:
+		D3D11Texture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> view, int width, int height, int slices = 1);
+
+		[[nodiscard]] int Width() const override { return m_width; }
+		[[nodiscard]] int Height() const override { return m_height; }
+		[[nodiscard]] int Slices() const override { return m_slices; }
+
+		[[nodiscard]] ID3D11ShaderResourceView* GetView() const { return m_view.Get(); }
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_view;
+		int m_width;
+		int m_height;
+		int m_slices;
+
+		MemoryAccounting::Charge m_charge;
+	};
+
+	/// The renderer of the experiment: sprites into an RGBA16F scene, tone mapped to ST.2084 into the HDR10 swap chain of `deviceResources`.
+	/// Sprites are batched into instanced draws, one per run of sprites of the same texture. Only the passes and attachments the
+	/// compiled `frame` keeps exist: with the tone map folded into the sprites, they are tone mapped straight onto the back buffer
+	class D3D11Renderer final : public IRenderer
+	{
+	public:
+		/// The luminance of a scene value of 1
+		static constexpr float PaperWhiteNits = 64;
+
+		D3D11Renderer(DX::DeviceResources* deviceResources, const FrameGraph& frame);
+
+		void CreateDeviceDependentResources();
+		void CreateWindowSizeDependentResources() const;
+		void OnDeviceLost();
+
+		/// Creates an immutable texture of `pixels`. Rows are read `pixels.stride` bytes apart, so crops are uploaded without a copy
+		[[nodiscard]] std::shared_ptr<const ITexture> CreateTexture(ConstRgba16View pixels) override;
+		[[nodiscard]] std::shared_ptr<const ITexture> CreateTextureArray(const ConstRgba16View* slices, std::size_t count) override;
+
+		void Begin() override;
+		void Draw(const ITexture& texture, Point position, bool flipHorizontally = false, int slice = 0) override;
+		void Fill(const Rect& rectangle, Color color) override;
+		void End() override;
+		void Present() override;
+
+		/// The sprites, draws and binds since the device was created
+		[[nodiscard]] SpriteBatcher::Statistics GetStatistics() const { return m_batcher ? m_batcher->GetStatistics() : SpriteBatcher::Statistics{}; }
+
+	private:
+		void Clear();
+
+		DX::DeviceResources* m_deviceResources;
+
+		/// Whether the sprites are drawn into the HDR scene and tone mapped by a pass of their own, and whether they bind a depth buffer
+		bool m_hdrScenePass;
+		bool m_depthBuffer;
+
+		std::unique_ptr<D3D11SpriteDevice> m_spriteDevice;
+		std::unique_ptr<SpriteBatcher> m_batcher;
+		std::shared_ptr<const ITexture> m_whiteTexture;
+
+		std::unique_ptr<DX::RenderTexture>		m_hdrScene;
+		mutable MemoryAccounting::Charge		m_hdrSceneCharge;
+		std::unique_ptr<DirectX::ToneMapPostProcess>	m_toneMap;
+	};
+}
@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "D3D11SpriteDevice.h"
+#include <d3dcompiler.h>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+namespace Experiment
+{
+	namespace
+	{
+		static_assert(sizeof(ISpriteDevice::Instance) == 48, "the instances are laid out as in the constant buffer");
+
+		/// Texels are loaded rather than sampled: sprites are drawn unscaled, and a fill stretches the single texel of its texture
+		constexpr char SpriteShaders[] = R"(
+struct Sprite
+{
+	float4 rectangle;
+	float4 color;
+	uint4 options;
+};
+
+cbuffer Sprites : register(b0)
+{
+	float2 SceneSize;
+	float2 Padding;
+	Sprite Instances[64];
+};
+
+Texture2DArray<float4> Textures : register(t0);
+
+struct Interpolants
+{
+	float4 position : SV_Position;
+	float2 texel : TEXCOORD0;
+	float4 color : COLOR0;
+	nointerpolation uint slice : SLICE;
+};
+
+Interpolants VSMain(uint vertex : SV_VertexID, uint instance : SV_InstanceID)
+{
+	const Sprite sprite = Instances[instance];
+	const float2 corner = float2(vertex & 1, vertex >> 1);
+	const float2 position = sprite.rectangle.xy + corner * sprite.rectangle.zw;
+
+	Interpolants output;
+	output.position = float4(position / SceneSize * float2(2, -2) + float2(-1, 1), 0, 1);
+	output.texel = float2(sprite.options.y ? 1 - corner.x : corner.x, corner.y) * sprite.rectangle.zw;
+	output.color = sprite.color;
+	output.slice = sprite.options.x;
+	return output;
+}
+
+float4 PSMain(Interpolants input) : SV_Target
+{
+	uint width, height, slices;
+	Textures.GetDimensions(width, height, slices);
+
+	const int2 texel = min(int2(input.texel), int2(width, height) - 1);
+	const float4 color = Textures.Load(int4(texel, input.slice, 0)) * input.color;
+
+#ifdef PAPER_WHITE_NITS
+	// Rec.709 to Rec.2020 primaries, then the ST.2084 curve of the luminance normalized to 10000 nits
+	const float3x3 from709To2020 = {
+		0.6274040, 0.3292820, 0.0433136,
+		0.0690970, 0.9195400, 0.0113612,
+		0.0163916, 0.0880132, 0.8955950
+	};
+
+	const float3 normalized = mul(from709To2020, color.rgb) * (PAPER_WHITE_NITS / 10000.0);
+
+	const float m1 = 2610.0 / 16384, m2 = 2523.0 / 4096 * 128;
+	const float c1 = 3424.0 / 4096, c2 = 2413.0 / 4096 * 32, c3 = 2392.0 / 4096 * 32;
+
+	const float3 p = pow(abs(normalized), m1);
+	return float4(pow((c1 + c2 * p) / (1 + c3 * p), m2), color.a);
+#else
+	return color;
+#endif
+}
+)";
+
+		Microsoft::WRL::ComPtr<ID3DBlob> Compile(const char* entryPoint, const char* target, const D3D_SHADER_MACRO* defines)
+		{
+			Microsoft::WRL::ComPtr<ID3DBlob> code;
+			Microsoft::WRL::ComPtr<ID3DBlob> errors;
+
+			const auto hr = D3DCompile(SpriteShaders, sizeof(SpriteShaders) - 1, "SpriteShaders", defines, nullptr, entryPoint, target,
+				D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, code.GetAddressOf(), errors.GetAddressOf());
+
+			if (FAILED(hr))
+			{
+				const auto message = errors ? std::string(static_cast<const char*>(errors->GetBufferPointer()), errors->GetBufferSize()) : std::string();
+				throw std::runtime_error(std::string("D3D11SpriteDevice: ") + entryPoint + " does not compile: " + message);
+			}
+
+			return code;
+		}
+	}
+
+	D3D11SpriteDevice::D3D11SpriteDevice(ID3D11Device* device, ID3D11DeviceContext* context, const float paperWhiteNits) : m_context(context)
+	{
+		const auto nits = std::to_string(paperWhiteNits);
+		const D3D_SHADER_MACRO toneMap[] = { { "PAPER_WHITE_NITS", nits.c_str() }, { nullptr, nullptr } };
+
+		const auto vertexShader = Compile("VSMain", "vs_4_0", nullptr);
+		const auto pixelShader = Compile("PSMain", "ps_4_0", paperWhiteNits > 0 ? toneMap : nullptr);
+
+		DX::ThrowIfFailed(device->CreateVertexShader(vertexShader->GetBufferPointer(), vertexShader->GetBufferSize(), nullptr, m_vertexShader.GetAddressOf()));
+		DX::ThrowIfFailed(device->CreatePixelShader(pixelShader->GetBufferPointer(), pixelShader->GetBufferSize(), nullptr, m_pixelShader.GetAddressOf()));
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = sizeof(Constants);
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, m_constants.GetAddressOf()));
+
+		m_states = std::make_unique<DirectX::CommonStates>(device);
+	}
+
+	void D3D11SpriteDevice::Begin(const int width, const int height)
+	{
+		m_sceneSize[0] = static_cast<float>(width);
+		m_sceneSize[1] = static_cast<float>(height);
+
+		// the quads are generated by the vertex shader, without vertex buffers
+		m_context->IASetInputLayout(nullptr);
+		m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+		m_context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+		m_context->VSSetConstantBuffers(0, 1, m_constants.GetAddressOf());
+		m_context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+
+		// the stimuli are opaque, as the CPU renderer assumes
+		m_context->OMSetBlendState(m_states->Opaque(), nullptr, 0xFFFFFFFF);
+		m_context->OMSetDepthStencilState(m_states->DepthNone(), 0);
+		m_context->RSSetState(m_states->CullNone());
+	}
+
+	void D3D11SpriteDevice::Bind(const void* texture)
+	{
+		auto* view = const_cast<ID3D11ShaderResourceView*>(static_cast<const ID3D11ShaderResourceView*>(texture));
+
+		m_context->PSSetShaderResources(0, 1, &view);
+	}
+
+	void D3D11SpriteDevice::Draw(const Instance* instances, const std::size_t count)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		DX::ThrowIfFailed(m_context->Map(m_constants.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+
+		auto* constants = static_cast<Constants*>(mapped.pData);
+		std::memcpy(constants->sceneSize, m_sceneSize, sizeof(m_sceneSize));
+		std::memcpy(constants->instances, instances, count * sizeof(Instance));
+
+		m_context->Unmap(m_constants.Get(), 0);
+
+		m_context->DrawInstanced(4, static_cast<UINT>(count), 0, 0);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <wrl/client.h>
+#include "pch.h"
+#include <CommonStates.h>
+#include <memory>
+#include "SpriteBatcher.h"
+
+namespace Experiment
+{
+	/// The sprite device of the experiment: a quad per instance, generated from the vertex and instance ids, which loads its texels
+	/// from a slice of the bound texture array, so that sprites of one array are a single DrawInstanced. Textures are the shader
+	/// resource views of texture arrays
+	class D3D11SpriteDevice final : public ISpriteDevice
+	{
+	public:
+		/// Writes the linear scene, or with a `paperWhiteNits` above 0, tone maps the sprites to ST.2084 as ToneMapPostProcess does,
+		/// for a render target which is the HDR10 back buffer
+		D3D11SpriteDevice(ID3D11Device* device, ID3D11DeviceContext* context, float paperWhiteNits = 0);
+
+		/// Sets the pipeline state of the sprites for a render target of `width` by `height` pixels. Draws follow until another
+		/// pass changes the state
+		void Begin(int width, int height);
+
+		void Bind(const void* texture) override;
+		void Draw(const Instance* instances, std::size_t count) override;
+
+	private:
+		/// The layout of the constant buffer of the vertex shader
+		struct Constants
+		{
+			float sceneSize[2];
+			float padding[2];
+			Instance instances[SpriteBatcher::MaxInstances];
+		};
+
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_context;
+
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> m_pixelShader;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> m_constants;
+
+		std::unique_ptr<DirectX::CommonStates> m_states;
+
+		float m_sceneSize[2] = {};
+	};
+}
@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "D3D11UploadDevice.h"
+
+namespace Experiment
+{
+	D3D11UploadDevice::D3D11UploadDevice(ID3D11Device* device, ID3D11DeviceContext* context) : m_device(device), m_context(context)
+	{
+	}
+
+	void D3D11UploadDevice::CreateSlots(const std::size_t count, const int width, const int height)
+	{
+		m_staging.resize(count);
+		m_fences.resize(count);
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_STAGING;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		D3D11_QUERY_DESC fence = {};
+		fence.Query = D3D11_QUERY_EVENT;
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			DX::ThrowIfFailed(m_device->CreateTexture2D(&desc, nullptr, m_staging[i].ReleaseAndGetAddressOf()));
+			DX::ThrowIfFailed(m_device->CreateQuery(&fence, m_fences[i].ReleaseAndGetAddressOf()));
+		}
+	}
+
+	IUploadDevice::Mapping D3D11UploadDevice::Map(const std::size_t slot)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+
+		const auto hr = m_context->Map(m_staging[slot].Get(), 0, D3D11_MAP_WRITE, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+		if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+		{
+			return {};
+		}
+
+		DX::ThrowIfFailed(hr);
+
+		return { static_cast<std::uint8_t*>(mapped.pData), mapped.RowPitch };
+	}
+
+	void D3D11UploadDevice::Unmap(const std::size_t slot)
+	{
+		m_context->Unmap(m_staging[slot].Get(), 0);
+	}
+
+	void D3D11UploadDevice::CopyToTarget(const std::size_t slot, void* target, const int targetRow, const int rows)
+	{
+		D3D11_TEXTURE2D_DESC desc = {};
+		m_staging[slot]->GetDesc(&desc);
+
+		const D3D11_BOX box = { 0, 0, 0, desc.Width, static_cast<UINT>(rows), 1 };
+
+		const auto* destination = static_cast<const D3D11UploadTarget*>(target);
+
+		m_context->CopySubresourceRegion(destination->texture, destination->subresource, 0, static_cast<UINT>(targetRow), 0, m_staging[slot].Get(), 0, &box);
+		m_context->End(m_fences[slot].Get());
+	}
+
+	bool D3D11UploadDevice::IsComplete(const std::size_t slot)
+	{
+		BOOL done = FALSE;
+		return m_context->GetData(m_fences[slot].Get(), &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK && done;
+	}
+
+	void D3D11UploadDevice::Update(void* target, const ConstRgba16View source, const int targetRow)
+	{
+		const D3D11_BOX box = { 0, static_cast<UINT>(targetRow), 0, static_cast<UINT>(source.width), static_cast<UINT>(targetRow + source.height), 1 };
+
+		const auto* destination = static_cast<const D3D11UploadTarget*>(target);
+
+		m_context->UpdateSubresource(destination->texture, destination->subresource, &box, source.data, static_cast<UINT>(source.stride), 0);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <wrl/client.h>
+#include "pch.h"
+#include <vector>
+#include "UploadRing.h"
+
+namespace Experiment
+{
+	/// A target of the D3D11 upload device: a subresource of a texture, such as a slice of a texture array
+	struct D3D11UploadTarget
+	{
+		ID3D11Texture2D* texture = nullptr;
+		UINT subresource = 0;
+	};
+
+	/// The upload device of the experiment: staging textures on the immediate context, fenced with event queries.
+	/// Targets are D3D11UploadTargets
+	class D3D11UploadDevice final : public IUploadDevice
+	{
+	public:
+		D3D11UploadDevice(ID3D11Device* device, ID3D11DeviceContext* context);
+
+		void CreateSlots(std::size_t count, int width, int height) override;
+
+		Mapping Map(std::size_t slot) override;
+		void Unmap(std::size_t slot) override;
+
+		void CopyToTarget(std::size_t slot, void* target, int targetRow, int rows) override;
+		bool IsComplete(std::size_t slot) override;
+
+		void Update(void* target, ConstRgba16View source, int targetRow) override;
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D11Device> m_device;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_context;
+
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> m_staging;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> m_fences;
+	};
+}
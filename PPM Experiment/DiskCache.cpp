@@ -0,0 +1,466 @@
+#include "DiskCache.h"
+#include "MemoryAccounting.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Experiment
+{
+	constexpr std::size_t PageSize = 4096;
+	constexpr char Magic[4] = { 'P', 'P', 'M', 'C' };
+
+	/// The fixed part of the header of a cache entry, followed by the key and padded to a page
+	struct EntryHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t channels;
+		std::uint32_t bytesPerChannel;
+		std::uint64_t stride;
+		std::uint64_t dataOffset;
+		std::uint32_t keyLength;
+		std::uint32_t reserved;
+	};
+
+	static std::string EntryKey(const FileIdentity& source, const Region region)
+	{
+		return source.Key() + "|" + std::to_string(region.x) + "," + std::to_string(region.y)
+			+ "," + std::to_string(region.width) + "," + std::to_string(region.height);
+	}
+
+	/// 64-bit FNV-1a
+	static std::uint64_t Hash(const std::string& s)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (const auto c : s)
+		{
+			hash ^= static_cast<std::uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::filesystem::path& path)
+	{
+		m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+		{
+			m_file = nullptr;
+			throw std::runtime_error(path.generic_string() + " cannot be opened");
+		}
+
+		LARGE_INTEGER size = {};
+		GetFileSizeEx(m_file, &size);
+		m_size = static_cast<std::size_t>(size.QuadPart);
+
+		m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr)
+		{
+			CloseHandle(m_file);
+			throw std::runtime_error(path.generic_string() + " cannot be mapped");
+		}
+
+		m_data = static_cast<const std::uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_data == nullptr)
+		{
+			CloseHandle(m_mapping);
+			CloseHandle(m_file);
+			throw std::runtime_error(path.generic_string() + " cannot be mapped");
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+	}
+#else
+	MappedFile::MappedFile(const std::filesystem::path& path)
+	{
+		const auto file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			throw std::runtime_error(path.generic_string() + " cannot be opened");
+		}
+
+		struct stat status = {};
+		fstat(file, &status);
+		m_size = static_cast<std::size_t>(status.st_size);
+
+		auto* data = m_size == 0 ? MAP_FAILED : mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+
+		if (data == MAP_FAILED)
+		{
+			throw std::runtime_error(path.generic_string() + " cannot be mapped");
+		}
+
+		m_data = static_cast<const std::uint8_t*>(data);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		munmap(const_cast<std::uint8_t*>(m_data), m_size);
+	}
+#endif
+
+	DiskCache::DiskCache(std::filesystem::path directory, const std::size_t budget) : m_directory(std::move(directory)), m_budget(budget)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(m_directory, error);
+
+		// remove interrupted writes and entries of other versions
+		for (const auto& entry : std::filesystem::directory_iterator(m_directory, error))
+		{
+			const auto& path = entry.path();
+
+			if (path.extension() == ".tmp")
+			{
+				std::filesystem::remove(path, error);
+				continue;
+			}
+
+			if (path.extension() != ".frame")
+			{
+				continue;
+			}
+
+			EntryHeader header = {};
+			std::ifstream file(path, std::ios::binary);
+			file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+			if (!file || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version)
+			{
+				file.close();
+				std::filesystem::remove(path, error);
+				m_statistics.invalidated++;
+			}
+		}
+
+		Evict();
+
+		m_writer = std::thread([this] { Work(); });
+	}
+
+	DiskCache::~DiskCache()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_changed.notify_all();
+		m_writer.join();
+	}
+
+	std::filesystem::path DiskCache::EntryPath(const std::string& key) const
+	{
+		std::stringstream name;
+		name << std::hex << Hash(key) << ".frame";
+
+		return m_directory / name.str();
+	}
+
+	std::optional<Frame> DiskCache::Load(const FileIdentity& source, const Region region)
+	{
+		TRACE_SCOPE("load", "Map cached frame");
+
+		const auto key = EntryKey(source, region);
+		const auto path = EntryPath(key);
+
+		std::error_code error;
+		if (!std::filesystem::exists(path, error))
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_statistics.misses++;
+
+			return std::nullopt;
+		}
+
+		try
+		{
+			auto mapping = std::make_shared<MappedFile>(path);
+
+			EntryHeader header = {};
+			if (mapping->Size() < sizeof(header))
+			{
+				throw std::runtime_error("Truncated cache entry");
+			}
+
+			std::memcpy(&header, mapping->Data(), sizeof(header));
+
+			// used now, so that it is evicted last; a failure only makes it look older
+			std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+			const auto* storedKey = reinterpret_cast<const char*>(mapping->Data() + sizeof(header));
+			const auto valid = std::memcmp(header.magic, Magic, sizeof(Magic)) == 0
+				&& header.version == Version
+				&& header.keyLength == key.size()
+				&& sizeof(header) + header.keyLength <= header.dataOffset
+				&& header.dataOffset + header.stride * header.height <= mapping->Size()
+				&& std::memcmp(storedKey, key.data(), key.size()) == 0;
+
+			if (!valid)
+			{
+				throw std::runtime_error("Stale cache entry");
+			}
+
+			Frame frame = {};
+			frame.width = static_cast<int>(header.width);
+			frame.height = static_cast<int>(header.height);
+			frame.channels = static_cast<int>(header.channels);
+			frame.bytesPerChannel = static_cast<int>(header.bytesPerChannel);
+			frame.stride = static_cast<std::size_t>(header.stride);
+
+			// the mapping is read only; frames are never written to once decoded
+			frame.data = const_cast<std::uint8_t*>(mapping->Data() + header.dataOffset);
+			frame.owner = MemoryAccounting::Track(MemoryTag::MappedFrames, mapping->Size(), mapping);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_statistics.hits++;
+
+			return frame;
+		}
+		catch (const std::exception&)
+		{
+			std::filesystem::remove(path, error);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_statistics.invalidated++;
+			m_statistics.misses++;
+
+			return std::nullopt;
+		}
+	}
+
+	void DiskCache::Store(const FileIdentity& source, const Frame& frame, const Region region, const WhenFull whenFull)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (whenFull == WhenFull::Wait)
+			{
+				m_changed.wait(lock, [this] { return m_jobs.size() < MaxQueuedStores; });
+			}
+
+			if (m_jobs.size() >= MaxQueuedStores)
+			{
+				m_statistics.skipped++;
+				return;
+			}
+
+			m_jobs.push_back({ EntryKey(source, region), frame });
+		}
+
+		m_changed.notify_all();
+	}
+
+	void DiskCache::Flush()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this] { return m_jobs.empty() && !m_writing; });
+	}
+
+	void DiskCache::Write(const std::string& key, const Frame& frame)
+	{
+		TRACE_SCOPE("load", "Store cached frame");
+
+		const auto path = EntryPath(key);
+
+		const auto rowBytes = static_cast<std::size_t>(frame.width) * frame.PixelBytes();
+
+		EntryHeader header = {};
+		std::memcpy(header.magic, Magic, sizeof(Magic));
+		header.version = Version;
+		header.width = static_cast<std::uint32_t>(frame.width);
+		header.height = static_cast<std::uint32_t>(frame.height);
+		header.channels = static_cast<std::uint32_t>(frame.channels);
+		header.bytesPerChannel = static_cast<std::uint32_t>(frame.bytesPerChannel);
+		header.stride = rowBytes;
+		header.dataOffset = (sizeof(header) + key.size() + PageSize - 1) / PageSize * PageSize;
+		header.keyLength = static_cast<std::uint32_t>(key.size());
+
+		// write to a temporary file first, so that readers never map a partial entry
+		std::random_device random;
+		auto temporary = path;
+		temporary += "." + std::to_string(random()) + ".tmp";
+
+		std::error_code error;
+
+		{
+			std::ofstream file(temporary, std::ios::binary);
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(key.data(), static_cast<std::streamsize>(key.size()));
+
+			const std::vector<char> padding(header.dataOffset - sizeof(header) - key.size(), 0);
+			file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+			for (auto y = 0; y < frame.height; y++)
+			{
+				file.write(reinterpret_cast<const char*>(frame.Row(y)), static_cast<std::streamsize>(rowBytes));
+			}
+
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(temporary, error);
+				return;
+			}
+		}
+
+		// an entry written again, as after a failed load, replaces the bytes of the previous one
+		const auto replaced = std::filesystem::file_size(path, error);
+		const auto previous = error ? 0 : replaced;
+
+		std::filesystem::rename(temporary, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+
+		m_bytes += header.dataOffset + rowBytes * frame.height;
+		m_bytes -= std::min(previous, m_bytes);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_statistics.stores++;
+	}
+
+	void DiskCache::Work()
+	{
+		for (;;)
+		{
+			Job job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_changed.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+
+				// the queue is drained before stopping
+				if (m_jobs.empty()) return;
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+				m_writing = true;
+			}
+
+			// a store waiting for room may queue the next frame while this one is written
+			m_changed.notify_all();
+
+			Write(job.key, job.frame);
+
+			// the entries are only scanned once they no longer fit
+			if (m_bytes > m_budget)
+			{
+				Evict();
+			}
+
+			// the frame is released before waiting for the next job
+			job.frame = {};
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_writing = false;
+			}
+
+			m_changed.notify_all();
+		}
+	}
+
+	void DiskCache::Evict()
+	{
+		struct Entry
+		{
+			std::filesystem::path path;
+			std::filesystem::file_time_type used;
+			std::uintmax_t bytes;
+		};
+
+		std::vector<Entry> entries;
+		std::uintmax_t total = 0;
+
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(m_directory, error))
+		{
+			if (entry.path().extension() != ".frame") continue;
+
+			const auto bytes = entry.file_size(error);
+			if (error) continue;
+
+			const auto used = entry.last_write_time(error);
+			if (error) continue;
+
+			entries.push_back({ entry.path(), used, bytes });
+			total += bytes;
+		}
+
+		m_bytes = total;
+		if (total <= m_budget) return;
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+
+		std::size_t evicted = 0;
+		std::size_t unevictable = 0;
+
+		// on POSIX an entry mapped by a reader stays readable until it is unmapped; on Windows a mapped entry cannot be deleted,
+		// so it is passed over for the next oldest, and the cache stays over its budget only if every older entry is mapped
+		for (const auto& entry : entries)
+		{
+			if (total <= m_budget) break;
+
+			if (std::filesystem::remove(entry.path, error))
+			{
+				total -= entry.bytes;
+				evicted++;
+			}
+			else
+			{
+				unevictable++;
+			}
+		}
+
+		m_bytes = total;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_statistics.evicted += evicted;
+		m_statistics.unevictable += unevictable;
+	}
+
+	DiskCache::Statistics DiskCache::GetStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_statistics;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const DiskCache::Statistics& s)
+	{
+		os << "hits: " << s.hits << ", misses: " << s.misses << ", stores: " << s.stores << ", skipped: " << s.skipped << ", invalidated: " << s.invalidated << ", evicted: " << s.evicted << ", unevictable: " << s.unevictable;
+		return os;
+	}
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include "Frame.h"
+#include "ImageCache.h"
+
+namespace Experiment
+{
+	/// A region of a frame to cache; an empty region stands for the whole frame
+	struct Region
+	{
+		int x = 0, y = 0, width = 0, height = 0;
+
+		[[nodiscard]] bool IsEmpty() const { return width == 0 || height == 0; }
+	};
+
+	/// A read only view of a file mapped into memory
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::filesystem::path& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		[[nodiscard]] const std::uint8_t* Data() const { return m_data; }
+		[[nodiscard]] std::size_t Size() const { return m_size; }
+
+	private:
+		const std::uint8_t* m_data = nullptr;
+		std::size_t m_size = 0;
+
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+
+	/// A persistent directory of decoded frames, stored page aligned so that they can be mapped instead of decoded.
+	/// Entries are named after the identity of their source file, so a modified source is never served stale,
+	/// and entries written by another `Version` are deleted when the cache is opened. Entries are written by a background thread.
+	/// The entries are kept within a byte budget: the least recently used ones are deleted when the cache is opened and when a
+	/// store takes it over the budget, a hit marking its entry as used by touching its modification time
+	class DiskCache
+	{
+	public:
+		static constexpr std::uint32_t Version = 2;
+
+		/// The stores which may wait for the writer thread; each keeps a whole decoded frame alive until it is written
+		static constexpr std::size_t MaxQueuedStores = 2;
+
+		/// What a store does when it finds `MaxQueuedStores` queued
+		enum class WhenFull
+		{
+			/// Skips the store, so that a miss on the render thread never waits for the disk
+			Skip,
+
+			/// Waits for room, on threads which only load, such as those of the preloader
+			Wait
+		};
+
+		struct Statistics
+		{
+			std::size_t hits = 0;
+			std::size_t misses = 0;
+			std::size_t stores = 0;
+
+			/// Stores which found `MaxQueuedStores` queued
+			std::size_t skipped = 0;
+
+			std::size_t invalidated = 0;
+
+			/// Entries deleted to keep the cache within its budget
+			std::size_t evicted = 0;
+
+			/// Deletions of entries to keep the cache within its budget which failed, as on Windows while a reader has the entry
+			/// mapped; the entry is tried again by the next eviction
+			std::size_t unevictable = 0;
+		};
+
+		/// Opens the cache in `directory`, whose entries may take `budget` bytes
+		DiskCache(std::filesystem::path directory, std::size_t budget);
+
+		/// Writes the stores still queued
+		~DiskCache();
+
+		DiskCache(const DiskCache&) = delete;
+		DiskCache& operator=(const DiskCache&) = delete;
+
+		/// Maps the cached frame of `source`, if there is a valid one
+		std::optional<Frame> Load(const FileIdentity& source, Region region = {});
+
+		/// Queues `frame`, the decoded `region` of `source`, to be written to the cache without waiting for the disk, as a miss
+		/// on the render thread may. The queue keeps the frame alive until it is written. A store which finds the queue full is
+		/// skipped or waits, as `whenFull` says, and failures leave the cache unchanged
+		void Store(const FileIdentity& source, const Frame& frame, Region region = {}, WhenFull whenFull = WhenFull::Skip);
+
+		/// Blocks until the queued stores are written
+		void Flush();
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+		[[nodiscard]] const std::filesystem::path& GetDirectory() const { return m_directory; }
+
+	private:
+		struct Job
+		{
+			std::string key;
+			Frame frame;
+		};
+
+		[[nodiscard]] std::filesystem::path EntryPath(const std::string& key) const;
+
+		/// Writes the entry of `key`, on the writer thread
+		void Write(const std::string& key, const Frame& frame);
+
+		/// Deletes the least recently used entries until the rest fit in the budget, and counts the bytes of the rest
+		void Evict();
+
+		void Work();
+
+		std::filesystem::path m_directory;
+		std::size_t m_budget;
+
+		/// The bytes of the entries, counted when the entries are scanned and added to by each store. Only touched by the writer
+		/// thread once the cache is opened
+		std::uintmax_t m_bytes = 0;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_changed;
+
+		std::deque<Job> m_jobs;
+		bool m_writing = false;
+		bool m_stop = false;
+
+		Statistics m_statistics;
+
+		std::thread m_writer;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const DiskCache::Statistics& s);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Experiment
+{
+	/// A decoded image in memory. The pixels are kept alive by `owner`, which may be any buffer
+	struct Frame
+	{
+		int width = 0;
+		int height = 0;
+		int channels = 4;
+		int bytesPerChannel = 2;
+
+		/// The number of bytes between the start of two consecutive rows
+		std::size_t stride = 0;
+
+		std::uint8_t* data = nullptr;
+		std::shared_ptr<void> owner;
+
+		[[nodiscard]] std::size_t PixelBytes() const
+		{
+			return static_cast<std::size_t>(channels) * bytesPerChannel;
+		}
+
+		[[nodiscard]] std::size_t Bytes() const
+		{
+			return stride * height;
+		}
+
+		[[nodiscard]] std::uint8_t* Row(const int y) const
+		{
+			return data + stride * y;
+		}
+	};
+}
@@ -5,9 +5,12 @@
 #include "pch.h"
 #include "Game.h"
 #include <filesystem>
+#include <sstream>
 #include <utility>
 #include "Controller.h"
+#include "Log.h"
 #include "Stopwatch.h"
+#include "Trace.h"
 
 extern void ExitGame();
 
@@ -17,21 +20,35 @@ namespace Experiment
 
 	Game::Game(Run& run) noexcept(false)
 	{
+		int width, height;
+		GetDefaultSize(width, height);
+
+		// the depth buffer is only created if a pass of the frame reads it
+		const FrameGraph frame(width, height);
+		const auto plan = frame.graph.Compile();
+
 		m_deviceResources = std::make_unique<DX::DeviceResources>(
 			DXGI_FORMAT_R10G10B10A2_UNORM,
-			DXGI_FORMAT_D32_FLOAT,
+			plan.IsAllocated(frame.depth) ? DXGI_FORMAT_D32_FLOAT : DXGI_FORMAT_UNKNOWN,
 			2,
 			D3D_FEATURE_LEVEL_10_0,
 			DX::DeviceResources::c_EnableHDR
 		);
 
 		m_deviceResources->RegisterDeviceNotify(this);
-		m_controller = new Controller(run, m_deviceResources.get());
 
-		// m_hdrScene = new std::unique_ptr<DX::RenderTexture>[NUMBER_OF_WINDOWS];
-		// m_toneMap = new std::unique_ptr<DirectX::ToneMapPostProcess>[NUMBER_OF_WINDOWS];
+		m_renderer = std::make_unique<D3D11Renderer>(m_deviceResources.get(), frame);
+		m_controller = new Controller(run, m_deviceResources.get(), m_renderer.get());
+	}
 
-		m_hdrScene = std::make_unique<DX::RenderTexture>(DXGI_FORMAT_R16G16B16A16_FLOAT);
+	Game::~Game()
+	{
+		if (m_deviceResources->GetSwapChain())
+		{
+			m_deviceResources->GetSwapChain()->SetFullscreenState(false, nullptr);
+		}
+
+		delete m_controller;
 	}
 
 	// Initialize the Direct3D resources required to run.
@@ -53,9 +70,18 @@ namespace Experiment
 
 		m_deviceResources->GoFullscreen();
 
-		m_stereoViews = m_controller->SetFlickerStereoViews(m_controller->GetRun()->trials[0]);
+		// loaded once, so that the frames never build a path or create a texture
+		m_screens.start = m_controller->SetStaticStereoView({
+			wd + "/instructions/startscreen_L.ppm",
+			wd + "/instructions/startscreen_R.ppm"
+		});
+
+		m_screens.transition = m_controller->SetStaticStereoView({
+			wd + "/black/blackscreen_L.ppm",
+			wd + "/black/blackscreen_R.ppm"
+		});
 
-		m_responseView = m_controller->SetStaticStereoView({
+		m_screens.response = m_controller->SetStaticStereoView({
 			wd + "/instructions/responsescreen_L.ppm",
 			wd + "/instructions/responsescreen_R.ppm"
 		});
@@ -68,6 +94,11 @@ namespace Experiment
 	// Executes the basic game loop.
 	void Game::Tick()
 	{
+		if (m_exiting || m_controller->IsFinished())
+		{
+			return;
+		}
+
 		m_controller->GetFPSTimer()->Tick([&]()
 			{
 				m_controller->GetAudioEngine()->Update();
@@ -79,170 +110,102 @@ namespace Experiment
 
 	void Game::OnEscapeKeyDown()
 	{
-		m_deviceResources->GetSwapChain()->SetFullscreenState(false, nullptr);
-
-		delete m_controller;
-
-		m_spriteBatch.reset();
-		m_gamePad.reset();
-
-		m_deviceResources.reset();
-		exit(0);
+		// the session is released by the destructor, on the UI thread once the render thread has been joined, rather than by
+		// exiting from here while the UI thread and the singletons are still in use
+		m_exiting = true;
+		ExitGame();
 	}
 
 
 	void Game::OnGamePadButton(const WPARAM key)
 	{
+		TRACE_SCOPE("input", "Input");
+
+		if (m_exiting || m_controller->IsFinished())
+		{
+			return;
+		}
+
+		if (key == VK_F12)
+		{
+			std::stringstream ss;
+			ss << MemoryAccounting::Global();
+			Log::Write(Log::Level::Info, ss.str());
+			return;
+		}
+
 		const auto state = m_gamePad->GetState(0);
+		const auto started = m_controller->m_startButtonHasBeenPressed;
 
 		auto shouldGoToNextImage = state.IsConnected()
 			? m_controller->GetResponse(state)
 			: m_controller->GetResponse(key);
 
+		// the first trial is loaded once the session starts, which waits for the preload, so that its stimuli are taken from
+		// the preload rather than decoded while the preload threads run
+		if (!started && m_controller->m_startButtonHasBeenPressed)
+		{
+			m_stereoViews = m_controller->SetFlickerStereoViews(0);
+		}
+
 		if (shouldGoToNextImage)
 		{
 			m_controller->GetStopwatch()->Restart();
 			Update();
 
-			auto q = m_controller->GetRun()->trials[++m_controller->m_currentImageIndex];
-			m_stereoViews = m_controller->SetFlickerStereoViews(q);
+			m_stereoViews = m_controller->SetFlickerStereoViews(++m_controller->m_currentImageIndex);
 		}
 	}
 
 	// Updates the world.
 	void Game::Update()
 	{
-		// before session has started, present the start screen
-		if (!m_controller->m_startButtonHasBeenPressed)
-		{
-			const auto stereo = m_controller->SetStaticStereoView({
-				wd + "/instructions/startscreen_L.ppm",
-				wd + "/instructions/startscreen_R.ppm"
-			});
-
-			Render(stereo);
-			return;
-		}
+		TRACE_SCOPE("frame", "Update");
 
 		const auto elapsed = m_controller->GetStopwatch()->Elapsed();
-		const auto delta = Configuration::ImageTransitionDuration;
+		const auto screen = Scene::ScreenAt(m_controller->m_startButtonHasBeenPressed, elapsed);
 
-		// if it is transiting between two images, show a black screen for the duration of the transition (intermediateDuration)
-		if (elapsed < delta)
-		{
-			auto black = m_controller->SetStaticStereoView({
-				wd + "/black/blackscreen_L.ppm",
-				wd + "/black/blackscreen_R.ppm"
-			});
-
-			Render(black);
-			return;
-		}
+		// before the session has started, the start screen shows the preload progress
+		const auto progress = screen == Scene::Screen::Start ? m_controller->GetPreloadProgress() : 1.0f;
 
-		// if more than timeOut time has passed with the image visible, render the response view
-		if (elapsed > Configuration::ImageTimeoutDuration + delta)
+		// the stimuli must have been uploaded by the end of the transition
+		if (screen == Scene::Screen::Stimuli)
 		{
-			Render(m_responseView);
-			return;
+			m_controller->FinishUploads();
 		}
 
-		// under all other circumstances render the appropriate pair of DuoViews
-		Render(m_shouldFlicker ? m_stereoViews.first : m_stereoViews.second);
-		m_shouldFlicker = !m_shouldFlicker;
-	}
-#pragma endregion
+		const auto& stimuli = m_shouldFlicker ? m_stereoViews.first : m_stereoViews.second;
 
-	void Game::Render(const DuoView& duo_view)
-	{
-		RenderBase([&](int i)
-		{
-			for (size_t j = 0; j < 2; j++)
-			{
-				m_spriteBatch->Draw(
-					duo_view[i][j].image.Get(),
-					duo_view[i][j].position,
-					nullptr,
-					DirectX::Colors::White,
-					0,
-					DirectX::g_XMZero,
-					1.0,
-					DirectX::SpriteEffects_FlipHorizontally
-				);
-			}
-		});
-	}
+		RenderBase([&]() { Scene::Draw(*m_renderer, screen, m_screens, stimuli, progress); });
+		m_controller->Presented(screen, elapsed);
 
-	void Game::Render(const SingleView& single_view)
-	{
-		RenderBase([&](int i)
+		if (screen == Scene::Screen::Stimuli)
 		{
-			m_spriteBatch->Draw(single_view[i].image.Get(), single_view[i].position);
-		});
+			m_shouldFlicker = !m_shouldFlicker;
+		}
 	}
+#pragma endregion
 
 	template<typename F>
 	void Game::RenderBase(F&& drawFunction)
 	{
-		
-		auto context = m_deviceResources->GetD3DDeviceContext();
-
-		Clear();
-
-		m_deviceResources->PIXBeginEvent(L"Render");
-
-		m_spriteBatch->Begin();
-
-		for (size_t i = 0; i < 2; ++i)
-		{
-			drawFunction(i);
-		}
-
-		m_spriteBatch->End();
-
-		m_deviceResources->PIXEndEvent();
-
-		auto renderTarget = m_deviceResources->GetRenderTargetView();
-		context->OMSetRenderTargets(1, &renderTarget, nullptr);
+		// uploads get what the last frame left of the frame budget
+		const auto slack = Configuration::FrameBudget - m_lastRenderDuration;
+		m_controller->FlushUploads(std::max<std::chrono::steady_clock::duration>(slack, {}));
 
-		m_toneMap->Process(context);
+		const auto start = std::chrono::steady_clock::now();
 
-		ID3D11ShaderResourceView* nullsrv[] = { nullptr };
-		context->PSSetShaderResources(0, 1, nullsrv);
+		m_renderer->Begin();
+		drawFunction();
+		m_renderer->End();
 
-		m_deviceResources->ThreadPresent();
+		// excluding the wait for the vertical blank in Present
+		m_lastRenderDuration = std::chrono::steady_clock::now() - start;
 
-		m_deviceResources->DiscardView();
+		TRACE_SCOPE("present", "Present");
+		m_renderer->Present();
 	}
 
-#pragma region Frame Render
-	// Helper method to clear the back buffers.
-	void Game::Clear()
-	{
-		m_deviceResources->PIXBeginEvent(L"Clear");
-
-		// Clear the views.
-		auto context = m_deviceResources->GetD3DDeviceContext();
-
-		auto renderTarget = m_hdrScene->GetRenderTargetView();
-		const auto depthStencil = m_deviceResources->GetDepthStencilView();
-
-		DirectX::XMVECTORF32 color;
-		auto actual = DirectX::FXMVECTOR({ {0, 0, 0, 0} });
-		color.v = DirectX::XMColorSRGBToRGB(actual);
-		context->ClearRenderTargetView(renderTarget, color);
-
-
-		context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-		context->OMSetRenderTargets(1, &renderTarget, depthStencil);
-
-		// Set the viewport.
-		auto viewport = m_deviceResources->GetScreenViewport();
-		context->RSSetViewports(1, &viewport);
-
-		m_deviceResources->PIXEndEvent();
-	}
-#pragma endregion
-
 #pragma region Message Handlers
 	// Message handlers
 	void Game::OnActivated()
@@ -296,39 +259,19 @@ namespace Experiment
 	// These are the resources that depend on the device.
 	void Game::CreateDeviceDependentResources()
 	{
-		auto device = m_deviceResources->GetD3DDevice();
-
-		try {
-			cv::directx::ocl::initializeContextFromD3D11Device(device);
-		}
-		catch (cv::Exception& e)
-		{
-			auto msg = e.msg;
-			throw;
-		}
-
-		m_spriteBatch = std::make_unique<DirectX::SpriteBatch>(m_deviceResources->GetD3DDeviceContext());
-
-		m_hdrScene->SetDevice(device);
-		m_toneMap = std::make_unique<DirectX::ToneMapPostProcess>(device);
-
-		m_toneMap->SetST2084Parameter(64);
+		m_controller->CreateDeviceDependentResources();
+		m_renderer->CreateDeviceDependentResources();
 	}
 
 	// Allocate all memory resources that change on a window SizeChanged event.
 	void Game::CreateWindowSizeDependentResources() const
 	{
-		auto size = m_deviceResources->GetOutputSize();
-		m_hdrScene->SetWindow(size);
-
-		m_toneMap->SetHDRSourceTexture(m_hdrScene->GetShaderResourceView());
+		m_renderer->CreateWindowSizeDependentResources();
 	}
 
 	void Game::OnDeviceLost()
 	{
-		m_hdrScene->ReleaseDevice();
-
-		m_toneMap.reset();
+		m_renderer->OnDeviceLost();
 	}
 
 	void Game::OnDeviceRestored()
@@ -5,13 +5,12 @@
 #pragma once
 
 #include "DeviceResources.h"
-#include "RenderTexture.h"
-#include "SpriteBatch.h"
+#include "D3D11Renderer.h"
 #include "GamePad.h"
 #include "Participant.h"
 #include "SimpleMath.h"
 #include "Controller.h"
-#include <PostProcess.h>
+#include "Scene.h"
 
 namespace Experiment {
 
@@ -23,6 +22,10 @@ namespace Experiment {
 	public:
 
 		Game(Run& run);
+
+		/// Leaves fullscreen and releases the session, on the UI thread once the render thread has stopped
+		~Game();
+
 		// Initialization and management
 		void Initialize(HWND window, int width, int height);
 		// Basic game loop
@@ -45,18 +48,11 @@ namespace Experiment {
 		// Properties
 		void GetDefaultSize(int& width, int& height) const;
 
-		void Clear();
-
 	private:
 
 		void Update();
 
-		/// This renders two seperate stereo images displayed concurrently given a DuoView
-		void Render(const DuoView& duo_view);
-
-		/// This renders a single fullscreen stereo image from a Duo of ShaderViews
-		void Render(const SingleView& single_view);
-
+		/// Renders a frame of what `drawFunction` draws, after flushing the uploads within the slack of the last frame
 		template<typename F>
 		void RenderBase(F&& drawFunction);
 
@@ -66,20 +62,23 @@ namespace Experiment {
 		// Device resources.
 		std::unique_ptr<DX::DeviceResources> m_deviceResources;
 
-		std::unique_ptr<DirectX::SpriteBatch> m_spriteBatch;
-
-		std::unique_ptr<DX::RenderTexture>		m_hdrScene;
-		std::unique_ptr<DirectX::ToneMapPostProcess>	m_toneMap;
+		std::unique_ptr<D3D11Renderer> m_renderer;
 
 		bool m_shouldFlicker = false;
 
+		/// The time the last frame took to draw and present, excluding uploads
+		std::chrono::steady_clock::duration m_lastRenderDuration = {};
+
 		std::unique_ptr<DirectX::GamePad>  m_gamePad;
 		DirectX::GamePad::ButtonStateTracker m_buttons;
 
 		Controller* m_controller;
 
+		/// Set once the participant pressed Escape; the game stops ticking while the UI thread stops the render thread
+		bool m_exiting = false;
+
 		std::pair<DuoView, DuoView> m_stereoViews;
-		SingleView m_responseView;
+		Scene::StaticScreens m_screens;
 	};
 
 }
@@ -0,0 +1,179 @@
+#include "ImageCache.h"
+#include <algorithm>
+#include <iterator>
+#include <ostream>
+
+namespace Experiment
+{
+	FileIdentity FileIdentity::Of(const std::filesystem::path& file)
+	{
+		std::error_code error;
+
+		auto canonical = std::filesystem::canonical(file, error);
+		if (error)
+		{
+			canonical = file;
+		}
+
+		FileIdentity identity = {};
+		identity.path = canonical.generic_string();
+		identity.size = std::filesystem::file_size(canonical, error);
+		identity.mtime = error ? 0 : static_cast<long long>(std::filesystem::last_write_time(canonical, error).time_since_epoch().count());
+
+		return identity;
+	}
+
+	std::string FileIdentity::Key() const
+	{
+		return path + "|" + std::to_string(size) + "|" + std::to_string(mtime);
+	}
+
+	ImageCache::ImageCache(const std::size_t budgetBytes) : m_budget(budgetBytes)
+	{
+	}
+
+	std::shared_ptr<const Frame> ImageCache::Get(const std::filesystem::path& file, const Loader& load)
+	{
+		const auto key = FileIdentity::Of(file).Key();
+
+		std::promise<std::shared_ptr<const Frame>> promise;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			const auto cached = m_index.find(key);
+			if (cached != m_index.end())
+			{
+				m_entries.splice(m_entries.begin(), m_entries, cached->second);
+				m_statistics.hits++;
+
+				return cached->second->frame;
+			}
+
+			// another thread is already decoding this file; share its result
+			const auto loading = m_loading.find(key);
+			if (loading != m_loading.end())
+			{
+				auto future = loading->second;
+				m_statistics.hits++;
+
+				lock.unlock();
+				return future.get();
+			}
+
+			m_statistics.misses++;
+			m_loading.emplace(key, promise.get_future().share());
+		}
+
+		std::shared_ptr<const Frame> frame;
+
+		try
+		{
+			frame = std::make_shared<const Frame>(load(file));
+		}
+		catch (...)
+		{
+			promise.set_exception(std::current_exception());
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_loading.erase(key);
+
+			throw;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			Insert(key, frame);
+			m_loading.erase(key);
+		}
+
+		promise.set_value(frame);
+		return frame;
+	}
+
+	void ImageCache::Insert(const std::string& key, const std::shared_ptr<const Frame>& frame)
+	{
+		const auto bytes = frame->Bytes();
+
+		// frames larger than the whole budget are handed out but never retained
+		if (bytes > m_budget)
+		{
+			return;
+		}
+
+		while (!m_entries.empty() && m_statistics.bytes + bytes > m_budget)
+		{
+			const auto& last = m_entries.back();
+
+			m_statistics.bytes -= last.frame->Bytes();
+			m_statistics.evictions++;
+
+			m_index.erase(last.key);
+			m_entries.pop_back();
+		}
+
+		m_entries.push_front({ key, frame });
+		m_index[key] = m_entries.begin();
+
+		m_statistics.bytes += bytes;
+		m_statistics.peakBytes = std::max(m_statistics.peakBytes, m_statistics.bytes);
+	}
+
+	std::size_t ImageCache::Trim(const std::size_t bytes)
+	{
+		std::list<Entry> evicted;
+		std::size_t dropped = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			while (!m_entries.empty() && dropped < bytes)
+			{
+				const auto& last = m_entries.back();
+
+				dropped += last.frame->Bytes();
+				m_statistics.bytes -= last.frame->Bytes();
+				m_statistics.evictions++;
+
+				m_index.erase(last.key);
+				evicted.splice(evicted.begin(), m_entries, std::prev(m_entries.end()));
+			}
+		}
+
+		// the frames are freed here, outside of the lock
+		return dropped;
+	}
+
+	ImageCache::Statistics ImageCache::GetStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto statistics = m_statistics;
+		statistics.entries = m_entries.size();
+
+		return statistics;
+	}
+
+	void ImageCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_entries.clear();
+		m_index.clear();
+		m_statistics.bytes = 0;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const ImageCache::Statistics& s)
+	{
+		const auto total = s.hits + s.misses;
+
+		os << "hits: " << s.hits << ", misses: " << s.misses
+			<< " (" << (total == 0 ? 0 : s.hits * 100 / total) << "% hit rate)"
+			<< ", evictions: " << s.evictions
+			<< ", entries: " << s.entries
+			<< ", MB: " << s.bytes / (1024 * 1024) << " (peak " << s.peakBytes / (1024 * 1024) << ")";
+
+		return os;
+	}
+}
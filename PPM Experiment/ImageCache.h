@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Frame.h"
+
+namespace Experiment
+{
+	/// Identifies the contents of a file by its canonical path, size and last modification time
+	struct FileIdentity
+	{
+		std::string path;
+		std::uintmax_t size = 0;
+		long long mtime = 0;
+
+		static FileIdentity Of(const std::filesystem::path& file);
+
+		[[nodiscard]] std::string Key() const;
+	};
+
+	/// A thread safe cache of decoded full resolution frames, evicting the least recently used frames above a byte budget
+	class ImageCache
+	{
+	public:
+		using Loader = std::function<Frame(const std::filesystem::path&)>;
+
+		struct Statistics
+		{
+			std::size_t hits = 0;
+			std::size_t misses = 0;
+			std::size_t evictions = 0;
+			std::size_t entries = 0;
+
+			std::size_t bytes = 0;
+			std::size_t peakBytes = 0;
+		};
+
+		explicit ImageCache(std::size_t budgetBytes);
+
+		/// Returns the decoded frame of `file`, calling `load` if it is not cached. Concurrent requests for one file load it once
+		std::shared_ptr<const Frame> Get(const std::filesystem::path& file, const Loader& load);
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+		[[nodiscard]] std::size_t GetBudget() const { return m_budget; }
+
+		/// Evicts least recently used frames until at least `bytes` are dropped or the cache is empty, and returns the bytes dropped.
+		/// A frame still in use elsewhere is only freed once released there
+		std::size_t Trim(std::size_t bytes);
+
+		void Clear();
+
+	private:
+		struct Entry
+		{
+			std::string key;
+			std::shared_ptr<const Frame> frame;
+		};
+
+		void Insert(const std::string& key, const std::shared_ptr<const Frame>& frame);
+
+		mutable std::mutex m_mutex;
+
+		std::size_t m_budget;
+
+		/// Most recently used entries first
+		std::list<Entry> m_entries;
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+		std::unordered_map<std::string, std::shared_future<std::shared_ptr<const Frame>>> m_loading;
+
+		Statistics m_statistics;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const ImageCache::Statistics& s);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "Frame.h"
+
+namespace Experiment
+{
+	/// A non-owning view of `Channels` interleaved samples of type T per pixel, with rows `stride` bytes apart.
+	/// Crops are views into the same memory, so they are passed along without copying
+	template<typename T, int Channels>
+	struct ImageView
+	{
+		using Sample = T;
+		static constexpr int ChannelCount = Channels;
+		static constexpr std::size_t PixelBytes = sizeof(T) * Channels;
+
+		T* data = nullptr;
+		int width = 0;
+		int height = 0;
+
+		/// The number of bytes between the start of two consecutive rows
+		std::size_t stride = 0;
+
+		ImageView() = default;
+		ImageView(T* data, const int width, const int height, const std::size_t stride) : data(data), width(width), height(height), stride(stride) {}
+		ImageView(T* data, const int width, const int height) : ImageView(data, width, height, width * PixelBytes) {}
+
+		/// A view of `frame`, which must have the sample size and channel count of the view
+		explicit ImageView(const Frame& frame) : ImageView(reinterpret_cast<T*>(frame.data), frame.width, frame.height, frame.stride)
+		{
+			if (frame.channels != Channels || frame.bytesPerChannel != static_cast<int>(sizeof(T)))
+			{
+				throw std::invalid_argument("Frame does not match the format of the view");
+			}
+		}
+
+		/// Views are implicitly read only
+		operator ImageView<const T, Channels>() const
+		{
+			return { data, width, height, stride };
+		}
+
+		[[nodiscard]] T* Row(const int y) const
+		{
+			using Byte = std::conditional_t<std::is_const_v<T>, const std::uint8_t, std::uint8_t>;
+			return reinterpret_cast<T*>(reinterpret_cast<Byte*>(data) + stride * y);
+		}
+
+		/// The first sample of pixel (x, y)
+		[[nodiscard]] T* operator()(const int x, const int y) const
+		{
+			return Row(y) + static_cast<std::size_t>(x) * Channels;
+		}
+
+		/// The `width` by `height` region at (x, y), throwing std::out_of_range if it is not within the view
+		[[nodiscard]] ImageView Crop(const int x, const int y, const int w, const int h) const
+		{
+			if (x < 0 || y < 0 || w < 0 || h < 0 || x + w > width || y + h > height)
+			{
+				throw std::out_of_range("Crop region is not within the image");
+			}
+
+			return { (*this)(x, y), w, h, stride };
+		}
+
+		/// Whether the rows follow each other without padding
+		[[nodiscard]] bool IsContiguous() const
+		{
+			return stride == width * PixelBytes;
+		}
+
+		/// The bytes of the pixels, excluding the padding between rows
+		[[nodiscard]] std::size_t Bytes() const
+		{
+			return static_cast<std::size_t>(height) * width * PixelBytes;
+		}
+	};
+
+	using Rgba16View = ImageView<std::uint16_t, 4>;
+	using ConstRgba16View = ImageView<const std::uint16_t, 4>;
+
+	/// Copies `source` into `destination`, which must have the same dimensions
+	template<typename T, int Channels>
+	void CopyPixels(const ImageView<const T, Channels> source, const ImageView<T, Channels> destination)
+	{
+		if (source.width != destination.width || source.height != destination.height)
+		{
+			throw std::invalid_argument("Views do not have the same dimensions");
+		}
+
+		if (source.IsContiguous() && destination.IsContiguous())
+		{
+			std::memcpy(destination.data, source.data, source.Bytes());
+			return;
+		}
+
+		for (auto y = 0; y < source.height; y++)
+		{
+			std::memcpy(destination.Row(y), source.Row(y), source.width * source.PixelBytes);
+		}
+	}
+}
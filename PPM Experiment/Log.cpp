@@ -0,0 +1,476 @@
+#include "Log.h"
+#include "SpscQueue.h"
+#include "Utils.h"
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace Experiment
+{
+	std::atomic<std::uint8_t> Log::s_level{ static_cast<std::uint8_t>(Log::Level::Info) };
+
+	namespace
+	{
+		const auto g_epoch = std::chrono::steady_clock::now();
+
+		// read by every message, so kept out of the registry and its lock
+		std::atomic<std::uint32_t> g_rateLimit{ 20 };
+		std::atomic<std::int64_t> g_ratePeriod{ 1000000000 };
+		std::atomic<std::size_t> g_suppressed{ 0 };
+		std::atomic<std::size_t> g_written{ 0 };
+		std::atomic<std::size_t> g_texts{ 0 };
+
+		/// Appends `value` formatted by the printf conversion `spec`
+		template<typename T>
+		void AppendFormatted(std::string& out, const std::string& spec, const T value)
+		{
+			char buffer[512];
+			const auto size = std::snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+			if (size > 0) out.append(buffer, std::min<std::size_t>(static_cast<std::size_t>(size), sizeof(buffer) - 1));
+		}
+	}
+
+	/// The messages of one thread, which only it pushes and only the logger thread pops
+	struct Log::ThreadQueue
+	{
+		SpscQueue<Message> queue{ QueueMessages };
+
+		/// Only written by the thread, so without read-modify-writes
+		std::atomic<std::size_t> logged{ 0 };
+		std::atomic<std::size_t> dropped{ 0 };
+	};
+
+	struct Log::Registry
+	{
+		std::mutex mutex;
+
+		/// Every queue ever created, kept after its thread exits so that its messages are still written
+		std::vector<std::unique_ptr<ThreadQueue>> queues;
+
+		/// The messages logged as text, with their time
+		std::vector<std::pair<std::int64_t, std::pair<Level, std::string>>> texts;
+
+		/// Only used by the logger thread while it runs
+		Settings settings;
+
+		std::thread thread;
+		bool running = false;
+		bool stopping = false;
+		bool stopAtExit = false;
+
+		std::condition_variable wake;
+		std::condition_variable flushed;
+		std::uint64_t flushRequested = 0;
+		std::uint64_t flushDone = 0;
+	};
+
+	Log::Registry& Log::GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	Log::ThreadQueue& Log::GetQueue()
+	{
+		thread_local ThreadQueue* queue = nullptr;
+
+		if (!queue)
+		{
+			auto& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			registry.queues.push_back(std::make_unique<ThreadQueue>());
+			queue = registry.queues.back().get();
+		}
+
+		return *queue;
+	}
+
+	std::int64_t Log::Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+	}
+
+	const char* Log::ToString(const Level level)
+	{
+		switch (level)
+		{
+		case Level::Debug: return "debug";
+		case Level::Info: return "info";
+		case Level::Warning: return "warning";
+		case Level::Error: return "error";
+		default: return "unknown";
+		}
+	}
+
+	void Log::SetLevel(const Level level)
+	{
+		s_level.store(static_cast<std::uint8_t>(level), std::memory_order_relaxed);
+	}
+
+	void Log::Start(Settings settings)
+	{
+		Stop();
+
+		SetLevel(settings.level);
+		g_rateLimit.store(static_cast<std::uint32_t>(std::min<std::size_t>(settings.rateLimit, UINT32_MAX)), std::memory_order_relaxed);
+		g_ratePeriod.store(std::chrono::duration_cast<std::chrono::nanoseconds>(settings.ratePeriod).count(), std::memory_order_relaxed);
+
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		registry.settings = std::move(settings);
+		registry.running = true;
+		registry.thread = std::thread(Run);
+
+		if (!registry.stopAtExit)
+		{
+			registry.stopAtExit = true;
+
+			std::atexit([]
+				{
+					// nothing may throw out of an exit handler
+					try
+					{
+						Stop();
+					}
+					catch (...)
+					{
+					}
+				});
+		}
+	}
+
+	void Log::Stop()
+	{
+		auto& registry = GetRegistry();
+
+		{
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			if (!registry.running) return;
+
+			registry.stopping = true;
+		}
+
+		registry.wake.notify_all();
+		registry.thread.join();
+
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.running = false;
+		registry.stopping = false;
+		registry.settings.sinks.clear();
+		registry.flushed.notify_all();
+	}
+
+	void Log::Flush()
+	{
+		auto& registry = GetRegistry();
+		std::unique_lock<std::mutex> lock(registry.mutex);
+
+		if (!registry.running) return;
+
+		const auto ticket = ++registry.flushRequested;
+		registry.wake.notify_all();
+		registry.flushed.wait(lock, [&] { return registry.flushDone >= ticket || !registry.running; });
+	}
+
+	bool Log::Begin(Site& site, Message& message)
+	{
+		const auto now = Now();
+
+		// a new period starts with the first message after the last one ended; messages racing with it may count in either
+		auto start = site.periodStart.load(std::memory_order_relaxed);
+		if (now - start >= g_ratePeriod.load(std::memory_order_relaxed) && site.periodStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+		{
+			site.count.store(0, std::memory_order_relaxed);
+		}
+
+		// a site is mostly logged from one thread, and one which races with another may miss a message of its count, so the
+		// count is kept without a read-modify-write, as the queues count theirs
+		const auto count = site.count.load(std::memory_order_relaxed);
+		site.count.store(count + 1, std::memory_order_relaxed);
+
+		if (count >= g_rateLimit.load(std::memory_order_relaxed))
+		{
+			site.suppressed.fetch_add(1, std::memory_order_relaxed);
+			g_suppressed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		message.site = &site;
+		message.time = now;
+		message.suppressed = site.suppressed.load(std::memory_order_relaxed) == 0 ? 0 : site.suppressed.exchange(0, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	void Log::Push(const Message& message)
+	{
+		auto& queue = GetQueue();
+
+		auto& counter = queue.queue.TryPush(message) ? queue.logged : queue.dropped;
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	void Log::Write(const Level level, const std::string& text)
+	{
+		if (!IsEnabled(level)) return;
+
+		const auto now = Now();
+
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.texts.push_back({ now, { level, text } });
+
+		g_texts.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::string Log::Format(const Message& message)
+	{
+		std::string out;
+		std::size_t next = 0;
+
+		for (const auto* f = message.site->format; *f;)
+		{
+			if (*f != '%')
+			{
+				out += *f++;
+				continue;
+			}
+
+			if (f[1] == '%')
+			{
+				out += '%';
+				f += 2;
+				continue;
+			}
+
+			// the flags, width and precision of the conversion are kept, and its length modifier replaced by that of the
+			// captured type, so that an argument of another type than the format says is converted rather than misread
+			std::string spec = "%";
+			for (f++; *f && std::strchr("-+ #0123456789.", *f); f++) spec += *f;
+			while (*f && std::strchr("hljztL", *f)) f++;
+
+			const auto conversion = *f ? *f++ : 's';
+
+			if (next == message.count)
+			{
+				out += "<missing>";
+				continue;
+			}
+
+			const auto type = message.types[next];
+			const auto& value = message.values[next++];
+
+			if (type == Type::String)
+			{
+				AppendFormatted(out, spec + "s", message.text + value.offset);
+				continue;
+			}
+
+			const auto asDouble = type == Type::Double ? value.doubleValue
+				: type == Type::Signed ? static_cast<double>(value.signedValue) : static_cast<double>(value.unsignedValue);
+			const auto asSigned = type == Type::Double ? static_cast<long long>(value.doubleValue)
+				: type == Type::Signed ? static_cast<long long>(value.signedValue) : static_cast<long long>(value.unsignedValue);
+			const auto asUnsigned = static_cast<unsigned long long>(asSigned);
+
+			switch (conversion)
+			{
+			case 'd':
+			case 'i':
+				AppendFormatted(out, spec + "lld", asSigned);
+				break;
+
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+				AppendFormatted(out, spec + "ll" + conversion, type == Type::Unsigned ? static_cast<unsigned long long>(value.unsignedValue) : asUnsigned);
+				break;
+
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				AppendFormatted(out, spec + conversion, asDouble);
+				break;
+
+			case 'c':
+				AppendFormatted(out, spec + "c", static_cast<int>(asSigned));
+				break;
+
+			case 'p':
+				AppendFormatted(out, spec + "p", reinterpret_cast<const void*>(static_cast<std::uintptr_t>(value.unsignedValue)));
+				break;
+
+			default:
+				// a number given to %s is written as it is
+				if (type == Type::Double) AppendFormatted(out, std::string("%g"), asDouble);
+				else if (type == Type::Signed) AppendFormatted(out, std::string("%lld"), asSigned);
+				else AppendFormatted(out, std::string("%llu"), static_cast<unsigned long long>(value.unsignedValue));
+				break;
+			}
+		}
+
+		return out;
+	}
+
+	void Log::Drain(std::vector<Message>& batch)
+	{
+		auto& registry = GetRegistry();
+
+		std::vector<ThreadQueue*> queues;
+		std::vector<std::pair<std::int64_t, std::pair<Level, std::string>>> texts;
+
+		{
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			for (const auto& queue : registry.queues) queues.push_back(queue.get());
+			texts.swap(registry.texts);
+		}
+
+		batch.clear();
+
+		Message message;
+		for (auto* queue : queues)
+		{
+			while (queue->queue.TryPop(message)) batch.push_back(message);
+		}
+
+		if (batch.empty() && texts.empty()) return;
+
+		// the threads' messages, each in order, are merged by time
+		std::stable_sort(batch.begin(), batch.end(), [](const Message& a, const Message& b) { return a.time < b.time; });
+
+		const auto write = [&](const std::int64_t time, const Level level, std::string text)
+		{
+			while (!text.empty() && text.back() == '\n') text.pop_back();
+
+			char prefix[32];
+			std::snprintf(prefix, sizeof(prefix), "%10.3f %-7s ", static_cast<double>(time) / 1e9, ToString(level));
+
+			const auto line = prefix + text + "\n";
+
+			for (const auto& sink : registry.settings.sinks)
+			{
+				// a sink which fails, such as a file on a full disk, loses its line but not those of the other sinks
+				try
+				{
+					sink(level, line);
+				}
+				catch (...)
+				{
+				}
+			}
+
+			g_written.fetch_add(1, std::memory_order_relaxed);
+		};
+
+		auto text = texts.begin();
+
+		for (const auto& m : batch)
+		{
+			for (; text != texts.end() && text->first <= m.time; ++text) write(text->first, text->second.first, std::move(text->second.second));
+
+			auto formatted = Format(m);
+			if (m.suppressed > 0) formatted += " (" + std::to_string(m.suppressed) + " more suppressed by the rate limit)";
+
+			write(m.time, m.site->level, std::move(formatted));
+		}
+
+		for (; text != texts.end(); ++text) write(text->first, text->second.first, std::move(text->second.second));
+	}
+
+	void Log::Run()
+	{
+		auto& registry = GetRegistry();
+
+		std::vector<Message> batch;
+		batch.reserve(QueueMessages);
+
+		std::unique_lock<std::mutex> lock(registry.mutex);
+
+		while (true)
+		{
+			registry.wake.wait_for(lock, registry.settings.interval, [&] { return registry.stopping || registry.flushRequested != registry.flushDone; });
+
+			const auto ticket = registry.flushRequested;
+			const auto stopping = registry.stopping;
+
+			lock.unlock();
+			Drain(batch);
+			lock.lock();
+
+			registry.flushDone = ticket;
+			registry.flushed.notify_all();
+
+			if (stopping) break;
+		}
+	}
+
+	Log::Statistics Log::GetStatistics()
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		Statistics s;
+		s.threads = registry.queues.size();
+
+		for (const auto& queue : registry.queues)
+		{
+			s.logged += queue->logged.load(std::memory_order_relaxed);
+			s.dropped += queue->dropped.load(std::memory_order_relaxed);
+		}
+
+		s.logged += g_texts.load(std::memory_order_relaxed);
+		s.suppressed = g_suppressed.load(std::memory_order_relaxed);
+		s.written = g_written.load(std::memory_order_relaxed);
+
+		return s;
+	}
+
+	Log::Sink Log::FileSink(const std::filesystem::path& path)
+	{
+		std::filesystem::create_directories(path.parent_path());
+
+		auto file = std::make_shared<std::ofstream>(path, std::ios::app);
+		if (!*file)
+		{
+			throw std::runtime_error(path.generic_string() + " cannot be opened");
+		}
+
+		return [file](Level, const std::string& line)
+		{
+			*file << line;
+			file->flush();
+		};
+	}
+
+	Log::Sink Log::ConsoleSink()
+	{
+		return [](Level, const std::string& line) { std::fputs(line.c_str(), stderr); };
+	}
+
+	Log::Sink Log::DebuggerSink()
+	{
+		return [](Level, const std::string& line) { Debug::Console::log(line); };
+	}
+
+	std::ostream& operator<<(std::ostream& os, const Log::Statistics& s)
+	{
+		os << "threads: " << s.threads << ", logged: " << s.logged << ", written: " << s.written
+			<< ", suppressed: " << s.suppressed << ", dropped: " << s.dropped;
+		return os;
+	}
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/// Logs a message of `level` with a printf format, which must be a string literal, and up to eight arguments: integers,
+/// floating point numbers and strings. The arguments are only formatted if the level is enabled, on the logger thread
+#define LOG(level, format, ...) \
+	do \
+	{ \
+		if (::Experiment::Log::IsEnabled(level)) \
+		{ \
+			static ::Experiment::Log::Site log_site_{ level, format }; \
+			::Experiment::Log::Write(log_site_, ##__VA_ARGS__); \
+		} \
+	} while (false)
+
+#define LOG_DEBUG(format, ...) LOG(::Experiment::Log::Level::Debug, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) LOG(::Experiment::Log::Level::Info, format, ##__VA_ARGS__)
+#define LOG_WARNING(format, ...) LOG(::Experiment::Log::Level::Warning, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) LOG(::Experiment::Log::Level::Error, format, ##__VA_ARGS__)
+
+namespace Experiment
+{
+	/// Structured logging which keeps formatting and output off the threads which log, such as the render thread. A message is
+	/// its call site, which holds the format, and a copy of its arguments, pushed without locks into a queue of the calling
+	/// thread; the logger thread drains the queues, formats the messages in the order they were logged, and hands them to the
+	/// sinks (a file, the console, the debugger). Each call site logs at most `rateLimit` messages per `ratePeriod`, and a
+	/// message which finds its queue full is dropped, so that logging never blocks
+	class Log
+	{
+	public:
+		enum class Level : std::uint8_t
+		{
+			Debug, Info, Warning, Error
+		};
+
+		/// Writes a formatted line, ending in a newline, on the logger thread
+		using Sink = std::function<void(Level level, const std::string& line)>;
+
+		struct Settings
+		{
+			Level level = Level::Info;
+
+			/// The messages each call site may log per `ratePeriod`; the rest are counted, and reported with its next message
+			std::size_t rateLimit = 20;
+			std::chrono::steady_clock::duration ratePeriod = std::chrono::seconds(1);
+
+			/// How often the logger thread drains the queues
+			std::chrono::steady_clock::duration interval = std::chrono::milliseconds(10);
+
+			std::vector<Sink> sinks;
+		};
+
+		struct Statistics
+		{
+			std::size_t threads = 0;
+			std::size_t logged = 0;
+
+			/// Messages over the rate limit of their call site, and those which found their queue full
+			std::size_t suppressed = 0;
+			std::size_t dropped = 0;
+
+			std::size_t written = 0;
+		};
+
+		/// A call site of LOG, whose address identifies its format in the queues
+		struct Site
+		{
+			Site(const Level level, const char* format) : level(level), format(format) {}
+
+			const Level level;
+			const char* const format;
+
+			/// The start of the current rate period, and the messages logged and suppressed in it
+			std::atomic<std::int64_t> periodStart{ 0 };
+			std::atomic<std::uint32_t> count{ 0 };
+			std::atomic<std::uint32_t> suppressed{ 0 };
+		};
+
+		static constexpr std::size_t MaxArguments = 8;
+
+		/// The bytes of the strings of a message, beyond which they are truncated
+		static constexpr std::size_t TextBytes = 128;
+
+		/// The messages each thread may have waiting for the logger thread
+		static constexpr std::size_t QueueMessages = 1024;
+
+		/// Starts the logger thread, which writes the messages logged so far and those to come to `settings.sinks`, and stops it
+		/// when the process exits
+		static void Start(Settings settings);
+
+		/// Writes the messages still queued and stops the logger thread
+		static void Stop();
+
+		/// Blocks until the messages logged before have been written, if the logger thread is running
+		static void Flush();
+
+		static void SetLevel(Level level);
+
+		[[nodiscard]] static bool IsEnabled(const Level level)
+		{
+			return static_cast<std::uint8_t>(level) >= s_level.load(std::memory_order_relaxed);
+		}
+
+		template<typename... Args>
+		static void Write(Site& site, const Args&... args)
+		{
+			static_assert(sizeof...(Args) <= MaxArguments, "LOG takes at most 8 arguments");
+
+			Message message;
+			if (!Begin(site, message)) return;
+
+			(Capture(message, args), ...);
+			Push(message);
+		}
+
+		/// Logs `text` as it is, such as a report of several lines, taking a lock and copying it; not for the frame loop
+		static void Write(Level level, const std::string& text);
+
+		[[nodiscard]] static Statistics GetStatistics();
+
+		/// Appends to the file at `path`, creating its directory, and flushes every line so that a crash loses none
+		static Sink FileSink(const std::filesystem::path& path);
+
+		/// Writes to the standard error
+		static Sink ConsoleSink();
+
+		/// Writes to the debugger, with OutputDebugString on Windows and to the standard error elsewhere
+		static Sink DebuggerSink();
+
+		static const char* ToString(Level level);
+
+	private:
+		/// The type of each argument is kept apart from its value, so that a message packs into few cache lines
+		enum class Type : std::uint8_t
+		{
+			Signed, Unsigned, Double, String
+		};
+
+		union Value
+		{
+			std::int64_t signedValue;
+			std::uint64_t unsignedValue;
+			double doubleValue;
+
+			/// Of a string in the text of the message
+			std::uint32_t offset;
+		};
+
+		/// A message as queued, left uninitialized but for its counts so that logging writes each byte once
+		struct Message
+		{
+			const Site* site;
+			std::int64_t time;
+			std::uint32_t suppressed;
+			std::uint8_t count = 0;
+			std::uint8_t textBytes = 0;
+
+			Type types[MaxArguments];
+			Value values[MaxArguments];
+			char text[TextBytes];
+		};
+
+		/// Applies the level and rate limit of `site`, and stamps `message` if it is to be logged
+		static bool Begin(Site& site, Message& message);
+
+		static void Push(const Message& message);
+
+		template<typename T>
+		static std::enable_if_t<std::is_arithmetic_v<T>> Capture(Message& message, const T value)
+		{
+			const auto index = message.count++;
+
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				message.types[index] = Type::Double;
+				message.values[index].doubleValue = value;
+			}
+			else if constexpr (std::is_signed_v<T>)
+			{
+				message.types[index] = Type::Signed;
+				message.values[index].signedValue = value;
+			}
+			else
+			{
+				message.types[index] = Type::Unsigned;
+				message.values[index].unsignedValue = value;
+			}
+		}
+
+		static void Capture(Message& message, const char* value)
+		{
+			Capture(message, value ? std::string_view(value) : std::string_view("(null)"));
+		}
+
+		static void Capture(Message& message, const std::string& value)
+		{
+			Capture(message, std::string_view(value));
+		}
+
+		static void Capture(Message& message, const std::string_view value)
+		{
+			const auto index = message.count++;
+			message.types[index] = Type::String;
+			message.values[index].offset = message.textBytes;
+
+			// what does not fit is cut, keeping room for the terminator
+			const auto size = std::min(value.size(), TextBytes - 1 - message.textBytes);
+			std::memcpy(message.text + message.textBytes, value.data(), size);
+			message.text[message.textBytes + size] = '\0';
+			message.textBytes = static_cast<std::uint8_t>(std::min(TextBytes - 1, message.textBytes + size + 1));
+		}
+
+		/// Formats the arguments of `message` as printf would format them with its format
+		static std::string Format(const Message& message);
+
+		struct ThreadQueue;
+		struct Registry;
+
+		static Registry& GetRegistry();
+
+		/// The queue of the calling thread, created on its first message
+		static ThreadQueue& GetQueue();
+
+		/// Drains the queues and writes their messages; called by the logger thread only
+		static void Drain(std::vector<Message>& batch);
+
+		static void Run();
+
+		/// Nanoseconds since the process started
+		static std::int64_t Now();
+
+		static std::atomic<std::uint8_t> s_level;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const Log::Statistics& s);
+}
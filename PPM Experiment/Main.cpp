@@ -9,9 +9,14 @@
 
 #include "pch.h"
 #include "Game.h"
+#include "Log.h"
+#include "RenderThread.h"
+#include "Trace.h"
+#include "TrialOrder.h"
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
 #include <filesystem>
 
 #pragma comment(lib, "Comdlg32.lib")
@@ -23,9 +28,74 @@ using string_ref = const std::string &;
 std::unique_ptr<Experiment::Game> g_game;
 HWND window;
 
+// the thread which ticks the game once it is initialized, and the UI thread which pumps the messages of its window
+Experiment::RenderThread* g_renderThread = nullptr;
+DWORD g_uiThread = 0;
+
 
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 
+// Handles a window event on the render thread, or on the UI thread before the render thread starts
+void Dispatch(Experiment::Game& game, const Experiment::WindowEvent& event)
+{
+	switch (event.type)
+	{
+	case Experiment::WindowEvent::Type::Escape:
+		game.OnEscapeKeyDown();
+		break;
+
+	case Experiment::WindowEvent::Type::KeyDown:
+		game.OnGamePadButton(event.key);
+		break;
+
+	case Experiment::WindowEvent::Type::Moved:
+		game.OnWindowMoved();
+		break;
+
+	case Experiment::WindowEvent::Type::Resized:
+		game.OnWindowSizeChanged(event.width, event.height);
+		break;
+
+	case Experiment::WindowEvent::Type::Activated:
+		game.OnActivated();
+		break;
+
+	case Experiment::WindowEvent::Type::Deactivated:
+		game.OnDeactivated();
+		break;
+
+	case Experiment::WindowEvent::Type::Suspending:
+		game.OnSuspending();
+		break;
+
+	case Experiment::WindowEvent::Type::Resuming:
+		game.OnResuming();
+		break;
+	}
+}
+
+// Hands an event to the render thread without waiting for it, or handles it directly while the game is being initialized
+void Forward(Experiment::Game* game, Experiment::WindowEvent::Type type, int windowIndex = 0, WPARAM key = 0, int width = 0, int height = 0)
+{
+	if (!game) return;
+
+	Experiment::WindowEvent event;
+	event.type = type;
+	event.window = windowIndex;
+	event.key = key;
+	event.width = width;
+	event.height = height;
+
+	if (g_renderThread)
+	{
+		g_renderThread->Post(event);
+	}
+	else
+	{
+		Dispatch(*game, event);
+	}
+}
+
 // Indicates to hybrid graphics systems to prefer the discrete part by default
 extern "C"
 {
@@ -53,6 +123,48 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
 	auto run = Experiment::Run::CreateRun(lpCmdLine);
 
+	// to the debugger, and to a file of the session which outlives the debugger
+	{
+		Experiment::Log::Settings settings;
+		settings.sinks.push_back(Experiment::Log::DebuggerSink());
+
+		const auto name = "Id" + run.participant.id + "_Session" + std::to_string(run.session) + "_"
+			+ Utils::FormatTime("%Y-%m-%d_%H-%M", std::chrono::system_clock::now()) + ".log";
+
+		try
+		{
+			settings.sinks.push_back(Experiment::Log::FileSink(std::filesystem::home() / Experiment::Configuration::LogDirectory / name));
+		}
+		catch (const std::exception&)
+		{
+			// the session runs regardless, logging to the debugger only
+		}
+
+		Experiment::Log::Start(std::move(settings));
+	}
+
+	if constexpr (Experiment::Configuration::TraceEnabled)
+	{
+		const auto name = "Id" + run.participant.id + "_Session" + std::to_string(run.session) + "_"
+			+ Utils::FormatTime("%Y-%m-%d_%H-%M", std::chrono::system_clock::now()) + ".json";
+
+		Experiment::Trace::Enable();
+		Experiment::Trace::WriteAtExit(std::filesystem::home() / Experiment::Configuration::TraceDirectory / name);
+	}
+
+	if constexpr (Experiment::Configuration::OptimizeTrialOrder)
+	{
+		// plan for as many resident frames as the decoded image cache can hold
+		Experiment::TrialOrder::Constraints constraints = {};
+		constraints.cacheFrames = Experiment::Configuration::ImageCacheBytes / (3840 * 2160 * 4 * sizeof(uint16_t));
+
+		const auto report = Experiment::TrialOrder::Apply(run, constraints);
+
+		std::stringstream ss;
+		ss << "TrialOrder: " << report << "\n";
+		Experiment::Log::Write(Experiment::Log::Level::Info, ss.str());
+	}
+
 	g_game = std::make_unique<Experiment::Game>(run);
 
 	RECT rc;
@@ -116,21 +228,45 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
 	g_game->Initialize(window, rc.right - rc.left, rc.bottom - rc.top);
 
-	// Main message loop
-	while (WM_QUIT != msg.message)
+	// From here the game is only touched by the render thread, so that the message loop may block without stalling a frame
+	g_uiThread = GetCurrentThreadId();
+
+	Experiment::RenderThread renderThread(
+		[](const Experiment::WindowEvent& event) { Dispatch(*g_game, event); },
+		[] { g_game->Tick(); });
+
+	g_renderThread = &renderThread;
+
+	// Main message loop. It keeps pumping while events the render thread has no room for are held back, as the render thread
+	// may be waiting on this thread for a message DXGI sends it
+	for (;;)
 	{
 		if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
 		{
+			if (msg.message == WM_QUIT) break;
+
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
+		else if (renderThread.Flush())
+		{
+			MsgWaitForMultipleObjects(0, nullptr, FALSE, 1, QS_ALLINPUT);
+		}
 		else
 		{
-			g_game->Tick();
+			WaitMessage();
 		}
 	}
 
+	renderThread.Stop();
+	g_renderThread = nullptr;
+
+	std::stringstream ss;
+	ss << "RenderThread: " << renderThread.GetStatistics() << "\n";
+	Experiment::Log::Write(Experiment::Log::Level::Info, ss.str());
+
 	g_game.reset();
+	Experiment::Log::Stop();
 
 	CoUninitialize();
 
@@ -153,40 +289,27 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	switch (message)
 	{
 	case WM_PAINT:
-		if (s_in_sizemove && game)
-		{
-			game->Tick();
-		}
-		else
-		{
-			HDC hdc = BeginPaint(hWnd, &ps);
-			EndPaint(hWnd, &ps);
-		}
-		break;
+	{
+		// the render thread keeps presenting, including while the window is moved or resized
+		HDC hdc = BeginPaint(hWnd, &ps);
+		EndPaint(hWnd, &ps);
+	}
+	break;
 
 	case WM_QUIT:
-		if (game)
-		{
-			game->OnEscapeKeyDown();
-		}
+		Forward(game, Experiment::WindowEvent::Type::Escape);
 		break;
 
 	case WM_KEYDOWN:
-		if (game && wParam == VK_ESCAPE)
+		if (wParam == VK_ESCAPE)
 		{
-			game->OnEscapeKeyDown();
-		}
-		if (game)
-		{
-			game->OnGamePadButton(wParam);
+			Forward(game, Experiment::WindowEvent::Type::Escape);
 		}
+		Forward(game, Experiment::WindowEvent::Type::KeyDown, 0, wParam);
 		break;
 
 	case WM_MOVE:
-		if (game)
-		{
-			game->OnWindowMoved();
-		}
+		Forward(game, Experiment::WindowEvent::Type::Moved);
 		break;
 
 	case WM_SIZE:
@@ -195,21 +318,21 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 			if (!s_minimized)
 			{
 				s_minimized = true;
-				if (!s_in_suspend && game)
-					game->OnSuspending();
+				if (!s_in_suspend)
+					Forward(game, Experiment::WindowEvent::Type::Suspending);
 				s_in_suspend = true;
 			}
 		}
 		else if (s_minimized)
 		{
 			s_minimized = false;
-			if (s_in_suspend && game)
-				game->OnResuming();
+			if (s_in_suspend)
+				Forward(game, Experiment::WindowEvent::Type::Resuming);
 			s_in_suspend = false;
 		}
-		else if (!s_in_sizemove && game)
+		else if (!s_in_sizemove)
 		{
-			game->OnWindowSizeChanged(LOWORD(lParam), HIWORD(lParam));
+			Forward(game, Experiment::WindowEvent::Type::Resized, 0, 0, LOWORD(lParam), HIWORD(lParam));
 		}
 		break;
 
@@ -219,12 +342,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 	case WM_EXITSIZEMOVE:
 		s_in_sizemove = false;
-		if (game)
 		{
 			RECT rc;
 			GetClientRect(hWnd, &rc);
 
-			game->OnWindowSizeChanged(rc.right - rc.left, rc.bottom - rc.top);
+			Forward(game, Experiment::WindowEvent::Type::Resized, 0, 0, rc.right - rc.left, rc.bottom - rc.top);
 		}
 		break;
 
@@ -237,33 +359,23 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	break;
 
 	case WM_ACTIVATEAPP:
-		if (game)
-		{
-			if (wParam)
-			{
-				game->OnActivated();
-			}
-			else
-			{
-				game->OnDeactivated();
-			}
-		}
+		Forward(game, wParam ? Experiment::WindowEvent::Type::Activated : Experiment::WindowEvent::Type::Deactivated);
 		break;
 
 	case WM_POWERBROADCAST:
 		switch (wParam)
 		{
 		case PBT_APMQUERYSUSPEND:
-			if (!s_in_suspend && game)
-				game->OnSuspending();
+			if (!s_in_suspend)
+				Forward(game, Experiment::WindowEvent::Type::Suspending);
 			s_in_suspend = true;
 			return TRUE;
 
 		case PBT_APMRESUMESUSPEND:
 			if (!s_minimized)
 			{
-				if (s_in_suspend && game)
-					game->OnResuming();
+				if (s_in_suspend)
+					Forward(game, Experiment::WindowEvent::Type::Resuming);
 				s_in_suspend = false;
 			}
 			return TRUE;
@@ -286,9 +398,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 
 
-// Exit helper
+// Exit helper, also called from the render thread, which has no message loop of its own
 void ExitGame()
 {
-	PostQuitMessage(0);
+	PostThreadMessage(g_uiThread, WM_QUIT, 0, 0);
 }
 
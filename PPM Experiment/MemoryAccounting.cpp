@@ -0,0 +1,212 @@
+#include "MemoryAccounting.h"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+namespace Experiment
+{
+	const char* ToString(const MemoryTag tag)
+	{
+		switch (tag)
+		{
+		case MemoryTag::DecodedFrames: return "Decoded frames";
+		case MemoryTag::MappedFrames: return "Mapped frames";
+		case MemoryTag::Preload: return "Preload";
+		case MemoryTag::Staging: return "Staging";
+		case MemoryTag::Textures: return "Textures";
+		case MemoryTag::Scratch: return "Scratch";
+		default: return "Unknown";
+		}
+	}
+
+	MemoryAccounting::Charge::Charge(MemoryAccounting& accounting, const MemoryTag tag, const std::size_t bytes) :
+		m_accounting(&accounting),
+		m_tag(tag),
+		m_bytes(bytes)
+	{
+		m_accounting->Allocate(m_tag, m_bytes);
+	}
+
+	MemoryAccounting::Charge::~Charge()
+	{
+		if (m_accounting) m_accounting->Release(m_tag, m_bytes);
+	}
+
+	MemoryAccounting::Charge::Charge(Charge&& other) noexcept :
+		m_accounting(std::exchange(other.m_accounting, nullptr)),
+		m_tag(other.m_tag),
+		m_bytes(std::exchange(other.m_bytes, 0))
+	{
+	}
+
+	MemoryAccounting::Charge& MemoryAccounting::Charge::operator=(Charge&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (m_accounting) m_accounting->Release(m_tag, m_bytes);
+
+			m_accounting = std::exchange(other.m_accounting, nullptr);
+			m_tag = other.m_tag;
+			m_bytes = std::exchange(other.m_bytes, 0);
+		}
+
+		return *this;
+	}
+
+	MemoryAccounting& MemoryAccounting::Global()
+	{
+		static MemoryAccounting accounting;
+		return accounting;
+	}
+
+	std::shared_ptr<void> MemoryAccounting::Track(const MemoryTag tag, const std::size_t bytes, std::shared_ptr<void> owner, MemoryAccounting& accounting)
+	{
+		struct Tracked
+		{
+			std::shared_ptr<void> owner;
+			Charge charge;
+		};
+
+		// the charge is released with the last reference to the buffer
+		return std::make_shared<Tracked>(Tracked{ std::move(owner), Charge(accounting, tag, bytes) });
+	}
+
+	void MemoryAccounting::SetBudget(const MemoryTag tag, const std::size_t bytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_usage[static_cast<std::size_t>(tag)].budget = bytes;
+		}
+
+		Evict(tag);
+	}
+
+	std::size_t MemoryAccounting::AddEvictor(const MemoryTag tag, Evictor evictor)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const auto id = m_nextId++;
+		m_evictors.push_back({ id, tag, std::make_shared<Evictor>(std::move(evictor)) });
+
+		return id;
+	}
+
+	void MemoryAccounting::RemoveEvictor(const std::size_t id)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		// an eviction in progress may still call it
+		m_evicted.wait(lock, [this] { return std::none_of(m_evicting.begin(), m_evicting.end(), [](const bool evicting) { return evicting; }); });
+
+		m_evictors.erase(std::remove_if(m_evictors.begin(), m_evictors.end(), [&](const Registration& r) { return r.id == id; }), m_evictors.end());
+	}
+
+	void MemoryAccounting::Allocate(const MemoryTag tag, const std::size_t bytes)
+	{
+		bool over;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto& usage = m_usage[static_cast<std::size_t>(tag)];
+			usage.current += bytes;
+			usage.peak = std::max(usage.peak, usage.current);
+			usage.allocations++;
+
+			over = usage.current > usage.budget;
+		}
+
+		if (over) Evict(tag);
+	}
+
+	void MemoryAccounting::Release(const MemoryTag tag, const std::size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto& usage = m_usage[static_cast<std::size_t>(tag)];
+		usage.current -= std::min(usage.current, bytes);
+	}
+
+	void MemoryAccounting::Evict(const MemoryTag tag)
+	{
+		const auto index = static_cast<std::size_t>(tag);
+
+		std::vector<std::shared_ptr<Evictor>> evictors;
+		std::size_t excess;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto& usage = m_usage[index];
+			if (usage.current <= usage.budget || m_evicting[index]) return;
+
+			m_evicting[index] = true;
+			excess = usage.current - usage.budget;
+
+			for (const auto& registration : m_evictors)
+			{
+				if (registration.tag == tag) evictors.push_back(registration.evictor);
+			}
+		}
+
+		// evictors free memory through Release, so the lock is not held while they run
+		std::size_t freed = 0;
+		for (const auto& evictor : evictors)
+		{
+			if (freed >= excess) break;
+			freed += (*evictor)(excess - freed);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto& usage = m_usage[index];
+		usage.evicted += freed;
+		if (usage.current > usage.budget) usage.overBudget++;
+
+		m_evicting[index] = false;
+		m_evicted.notify_all();
+	}
+
+	MemoryAccounting::Usage MemoryAccounting::GetUsage(const MemoryTag tag) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_usage[static_cast<std::size_t>(tag)];
+	}
+
+	void MemoryAccounting::Dump(std::ostream& os) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const auto megabytes = [](const std::size_t bytes) { return bytes / (1024 * 1024); };
+
+		std::size_t current = 0, peak = 0;
+
+		for (std::size_t i = 0; i < m_usage.size(); i++)
+		{
+			const auto& usage = m_usage[i];
+
+			os << std::left << std::setw(16) << ToString(static_cast<MemoryTag>(i)) << std::right
+				<< " MB: " << megabytes(usage.current) << " (peak " << megabytes(usage.peak) << ")";
+
+			if (usage.budget != Unlimited)
+			{
+				os << ", budget: " << megabytes(usage.budget) << " MB, evicted: " << megabytes(usage.evicted) << " MB, over budget: " << usage.overBudget;
+			}
+
+			os << ", allocations: " << usage.allocations << "\n";
+
+			current += usage.current;
+			peak += usage.peak;
+		}
+
+		// the peaks of the subsystems need not have coincided, so their sum bounds the peak of the process from above
+		os << "Total MB: " << megabytes(current) << " (at most " << megabytes(peak) << " at peak)\n";
+	}
+
+	std::ostream& operator<<(std::ostream& os, const MemoryAccounting& accounting)
+	{
+		accounting.Dump(os);
+		return os;
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Experiment
+{
+	/// The subsystems memory is accounted to
+	enum class MemoryTag
+	{
+		/// Full resolution frames decoded into the heap, whether held by the image cache or in flight
+		DecodedFrames,
+		/// Frames mapped from the stimulus cache on disk
+		MappedFrames,
+		/// The crops of a preloaded session
+		Preload,
+		/// The staging slots of the upload ring
+		Staging,
+		/// Textures and render targets, on the GPU or of the CPU renderer
+		Textures,
+		/// Decode scratch arenas
+		Scratch,
+
+		Count
+	};
+
+	const char* ToString(MemoryTag tag);
+
+	/// Tracks the current and high-water bytes of each subsystem, and enforces their budgets: when a charge takes a subsystem
+	/// over its budget, its evictors are asked to free the excess, outside of any lock. A budget is not a hard limit; allocations
+	/// evictors could not make room for are counted as over budget. Thread safe
+	class MemoryAccounting
+	{
+	public:
+		static constexpr auto Unlimited = static_cast<std::size_t>(-1);
+
+		struct Usage
+		{
+			std::size_t current = 0;
+			std::size_t peak = 0;
+			std::size_t budget = Unlimited;
+
+			std::size_t allocations = 0;
+
+			/// Bytes evictors reported freeing, and allocations which stayed over budget after them
+			std::size_t evicted = 0;
+			std::size_t overBudget = 0;
+		};
+
+		/// Frees up to `bytes` of a subsystem, such as least recently used cache entries, and returns the bytes freed
+		using Evictor = std::function<std::size_t(std::size_t bytes)>;
+
+		/// Bytes charged to a subsystem for as long as the charge lives
+		class Charge
+		{
+		public:
+			Charge() = default;
+			Charge(MemoryAccounting& accounting, MemoryTag tag, std::size_t bytes);
+			~Charge();
+
+			Charge(Charge&& other) noexcept;
+			Charge& operator=(Charge&& other) noexcept;
+
+			Charge(const Charge&) = delete;
+			Charge& operator=(const Charge&) = delete;
+
+			[[nodiscard]] std::size_t Bytes() const { return m_bytes; }
+
+		private:
+			MemoryAccounting* m_accounting = nullptr;
+			MemoryTag m_tag = MemoryTag::DecodedFrames;
+			std::size_t m_bytes = 0;
+		};
+
+		MemoryAccounting() = default;
+
+		MemoryAccounting(const MemoryAccounting&) = delete;
+		MemoryAccounting& operator=(const MemoryAccounting&) = delete;
+
+		/// The accounting of the process, which the subsystems of the experiment charge
+		static MemoryAccounting& Global();
+
+		/// Wraps `owner` of a buffer of `bytes`, such as the owner of a Frame, so that the buffer is charged to `tag` while it lives
+		static std::shared_ptr<void> Track(MemoryTag tag, std::size_t bytes, std::shared_ptr<void> owner, MemoryAccounting& accounting = Global());
+
+		void SetBudget(MemoryTag tag, std::size_t bytes);
+
+		/// Returns an id for RemoveEvictor, which must be called before the evictor's captures are destroyed
+		std::size_t AddEvictor(MemoryTag tag, Evictor evictor);
+
+		/// Waits for evictions in progress, so must not be called by an evictor
+		void RemoveEvictor(std::size_t id);
+
+		void Allocate(MemoryTag tag, std::size_t bytes);
+		void Release(MemoryTag tag, std::size_t bytes);
+
+		[[nodiscard]] Usage GetUsage(MemoryTag tag) const;
+
+		/// Writes the usage of every subsystem, one per line
+		void Dump(std::ostream& os) const;
+
+	private:
+		struct Registration
+		{
+			std::size_t id;
+			MemoryTag tag;
+			std::shared_ptr<Evictor> evictor;
+		};
+
+		/// Runs the evictors of `tag` until it is within its budget
+		void Evict(MemoryTag tag);
+
+		mutable std::mutex m_mutex;
+
+		std::array<Usage, static_cast<std::size_t>(MemoryTag::Count)> m_usage = {};
+
+		/// Whether a thread is running the evictors of a subsystem, which other threads over its budget leave to it
+		std::array<bool, static_cast<std::size_t>(MemoryTag::Count)> m_evicting = {};
+		std::condition_variable m_evicted;
+
+		std::vector<Registration> m_evictors;
+		std::size_t m_nextId = 1;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const MemoryAccounting& accounting);
+}
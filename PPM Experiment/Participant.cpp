@@ -139,6 +139,20 @@ namespace Experiment
 		return os;
 	}
 
+	std::ostream& operator<<(std::ostream& os, const TrialPerformance& p)
+	{
+		os << std::tuple(
+			p.readMilliseconds,
+			p.decodeMilliseconds,
+			p.uploadMilliseconds,
+			p.transitionMilliseconds,
+			p.flickerFrames,
+			p.missedDeadlines
+		);
+
+		return os;
+	}
+
 	std::ostream& operator<<(std::ostream& os, const Participant& p)
 	{
 		os << "# Age: " << p.age << "\n# Gender: " << (p.gender == Gender::Male ? "Male" : "Female");
@@ -150,12 +164,13 @@ namespace Experiment
 		std::ofstream file(path.generic_string());
 
 		file << participant << std::endl;
-		file << "Codec, BPP, Distortion, Bypass, Image, Side, Position-X, Position-Y, Mode, Response, Duration, Subject" << std::endl;
+		file << "Codec, BPP, Distortion, Bypass, Image, Side, Position-X, Position-Y, Mode, Response, Duration, Subject, "
+			<< "Read (ms), Decode (ms), Upload (ms), Transition (ms), Flicker Frames, Missed Deadlines" << std::endl;
 
 		for (const auto& trial : trials)
 		{
 			if (trial.participantResponse == Option::None) continue;
-			file << std::tuple(trial, participant.id) << "\n";
+			file << std::tuple(trial, participant.id, trial.performance) << "\n";
 		}
 
 		file.close();
@@ -197,7 +212,11 @@ namespace Experiment
 				option,
 				{x, y},
 				mode,
-				GetCompressionConfiguration(decompressedDirectory)
+				GetCompressionConfiguration(decompressedDirectory),
+				// not yet answered or measured
+				Option::None,
+				0.0,
+				{}
 				});
 		}
 
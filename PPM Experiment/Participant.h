@@ -6,7 +6,12 @@
 #include <string>
 #include <vector>
 #include <filesystem>
-#include "DeviceResources.h"
+#include <chrono>
+
+#ifdef _WIN32
+#include "pch.h"
+#endif
+#include "Utils.h"
 
 namespace Experiment {
 	enum class Option
@@ -71,6 +76,26 @@ namespace Experiment {
 		std::filesystem::path leftOriginal, leftCompressed, rightOriginal, rightCompressed;
 	};
 
+	/// How a trial was loaded and shown, so that trials with timing anomalies can be excluded from the analysis
+	struct TrialPerformance
+	{
+		/// Reading and decoding the stimuli of the trial, zero for stimuli already decoded for an earlier trial
+		double readMilliseconds = 0.0;
+		double decodeMilliseconds = 0.0;
+
+		/// Uploading the stimuli to the GPU
+		double uploadMilliseconds = 0.0;
+
+		/// From the first black frame of the transition to the first frame of the stimuli
+		double transitionMilliseconds = 0.0;
+
+		/// Frames of the stimuli presented, and those presented more than half a flicker period after they were due
+		int flickerFrames = 0;
+		int missedDeadlines = 0;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const TrialPerformance& p);
+
 	struct Trial
 	{
 		std::string originalDirectory = "";
@@ -86,6 +111,8 @@ namespace Experiment {
 		Option participantResponse = Option::None;
 		double duration = 0.0;
 
+		TrialPerformance performance;
+
 		[[nodiscard]] Paths imagePaths(const Mode mode) const
 		{
 			Paths paths = {};
@@ -191,6 +218,53 @@ namespace Experiment {
 
 		constexpr auto ImageDistance = 60;
 		constexpr auto ImageDimensions = Vector{ 1200, 1000 };
+
+		/// The memory the decoded image cache may hold, about sixteen 4K RGBA16 frames
+		constexpr auto ImageCacheBytes = std::size_t(1) << 30;
+
+		/// The budget of every decoded frame, cached or in flight: above it, the image cache is trimmed (see MemoryAccounting.h)
+		constexpr auto DecodedFramesBudgetBytes = ImageCacheBytes + (std::size_t(256) << 20);
+
+		/// Keeps decoded frames on disk between sessions, in `StimulusCacheDirectory` of the home directory, evicting the least
+		/// recently used beyond `StimulusCacheBytes`, about 250 frames of 4K (see DiskCache.h)
+		constexpr auto StimulusCacheEnabled = true;
+		constexpr auto StimulusCacheDirectory = "PPM Experiment Cache";
+		constexpr auto StimulusCacheBytes = std::size_t(16) << 30;
+
+		/// Decodes every stimulus of the session before it starts, if it fits in memory with `PreloadHeadroomBytes` to spare
+		constexpr auto PreloadSession = true;
+		constexpr auto PreloadHeadroomBytes = std::size_t(2) << 30;
+
+		/// The scratch memory of each decoding thread, enough to read a 4K 16-bit PPM
+		constexpr auto DecodeScratchBytes = std::size_t(64) << 20;
+
+		/// Staging slots of the stimulus upload ring, for the four stimuli of two trials (see UploadRing.h)
+		constexpr auto UploadSlots = std::size_t(8);
+
+		/// Stimulus uploads are spread over the transition in bands of this many rows, within the time frames leave of `FrameBudget`
+		constexpr auto UploadBandRows = 100;
+		constexpr auto FrameBudget = milliseconds(16);
+
+		/// Reorders the trials of a Run so that trials sharing decoded images are close together (see TrialOrder.h)
+		constexpr auto OptimizeTrialOrder = true;
+
+		/// Records a trace of each session, written on exit to `TraceDirectory` of the home directory (see Trace.h)
+		constexpr auto TraceEnabled = true;
+		constexpr auto TraceDirectory = "PPM Experiment Traces";
+
+		/// Writes the last `WatchdogWindow` of the trace to `WatchdogDirectory` of the home directory whenever a frame is
+		/// presented half a flicker period or more after the one before it (see Watchdog.h)
+		constexpr auto WatchdogEnabled = true;
+		constexpr auto WatchdogWindow = seconds(5);
+		constexpr auto WatchdogDirectory = "PPM Experiment Stalls";
+
+		/// Logs the inputs and clock readings of each session to `SessionLogDirectory` of the home directory, so that it can be
+		/// replayed headless (see SessionLog.h)
+		constexpr auto SessionLogEnabled = true;
+		constexpr auto SessionLogDirectory = "PPM Experiment Sessions";
+
+		/// Writes the log messages of each session to `LogDirectory` of the home directory as well as to the debugger (see Log.h)
+		constexpr auto LogDirectory = "PPM Experiment Logs";
 	}
 
 }
\ No newline at end of file
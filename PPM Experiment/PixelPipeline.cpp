@@ -0,0 +1,50 @@
+#include "PixelPipeline.h"
+
+namespace Experiment::Pixels
+{
+	template<SourceFormat Source, ChannelOrder Order, Scaling Scale>
+	static void ConvertTo(const SourceImage& source, const int x, const int y, const DestinationImage& destination)
+	{
+		switch (destination.format)
+		{
+		case DestinationFormat::Rgba16Unorm: return Convert<Source, Order, Scale, DestinationFormat::Rgba16Unorm>(source, x, y, destination);
+		case DestinationFormat::Rgba16Float: return Convert<Source, Order, Scale, DestinationFormat::Rgba16Float>(source, x, y, destination);
+		case DestinationFormat::R10G10B10A2Unorm: return Convert<Source, Order, Scale, DestinationFormat::R10G10B10A2Unorm>(source, x, y, destination);
+		}
+	}
+
+	template<SourceFormat Source, ChannelOrder Order>
+	static void ConvertScaled(const SourceImage& source, const int x, const int y, const DestinationImage& destination, const Scaling scaling)
+	{
+		if (scaling == Scaling::Keep) ConvertTo<Source, Order, Scaling::Keep>(source, x, y, destination);
+		else ConvertTo<Source, Order, Scaling::Normalize>(source, x, y, destination);
+	}
+
+	template<SourceFormat Source>
+	static void ConvertOrdered(const SourceImage& source, const int x, const int y, const DestinationImage& destination, const Scaling scaling)
+	{
+		if (source.order == ChannelOrder::Rgb) ConvertScaled<Source, ChannelOrder::Rgb>(source, x, y, destination, scaling);
+		else ConvertScaled<Source, ChannelOrder::Bgr>(source, x, y, destination, scaling);
+	}
+
+	void Convert(const SourceImage& source, const int x, const int y, const DestinationImage& destination, const Scaling scaling)
+	{
+		if (x < 0 || y < 0 || destination.width < 0 || destination.height < 0
+			|| x + destination.width > source.width || y + destination.height > source.height)
+		{
+			throw std::out_of_range("Region is not within the source image");
+		}
+
+		if (source.maxval < 1 || source.maxval > 65535)
+		{
+			throw std::invalid_argument("Invalid maxval");
+		}
+
+		switch (source.format)
+		{
+		case SourceFormat::Uint8: return ConvertOrdered<SourceFormat::Uint8>(source, x, y, destination, scaling);
+		case SourceFormat::Uint16: return ConvertOrdered<SourceFormat::Uint16>(source, x, y, destination, scaling);
+		case SourceFormat::Uint16BigEndian: return ConvertOrdered<SourceFormat::Uint16BigEndian>(source, x, y, destination, scaling);
+		}
+	}
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace Experiment::Pixels
+{
+	/// The layout of a source sample
+	enum class SourceFormat
+	{
+		Uint8,
+		/// Native endian, as decoded by OpenCV
+		Uint16,
+		/// Big endian, as stored in 16-bit PPMs
+		Uint16BigEndian
+	};
+
+	enum class ChannelOrder { Rgb, Bgr };
+
+	/// Whether samples keep their value (as cv::imread does) or are scaled from [0, maxval] to the full range of the destination
+	enum class Scaling { Keep, Normalize };
+
+	/// The formats of the stimulus textures
+	enum class DestinationFormat
+	{
+		/// DXGI_FORMAT_R16G16B16A16_UNORM
+		Rgba16Unorm,
+		/// DXGI_FORMAT_R16G16B16A16_FLOAT, holding the normalized value
+		Rgba16Float,
+		/// DXGI_FORMAT_R10G10B10A2_UNORM
+		R10G10B10A2Unorm
+	};
+
+	/// Three interleaved channels per pixel, with rows `stride` bytes apart
+	struct SourceImage
+	{
+		const std::uint8_t* data = nullptr;
+		int width = 0;
+		int height = 0;
+		std::size_t stride = 0;
+
+		SourceFormat format = SourceFormat::Uint16BigEndian;
+		ChannelOrder order = ChannelOrder::Rgb;
+		int maxval = 65535;
+	};
+
+	/// Four channels per pixel, packed as `format`, with rows `stride` bytes apart
+	struct DestinationImage
+	{
+		std::uint8_t* data = nullptr;
+		int width = 0;
+		int height = 0;
+		std::size_t stride = 0;
+
+		DestinationFormat format = DestinationFormat::Rgba16Unorm;
+	};
+
+	constexpr std::size_t SourcePixelBytes(const SourceFormat format)
+	{
+		return format == SourceFormat::Uint8 ? 3 : 6;
+	}
+
+	constexpr std::size_t DestinationPixelBytes(const DestinationFormat format)
+	{
+		return format == DestinationFormat::R10G10B10A2Unorm ? 4 : 8;
+	}
+
+	/// The scaling which brings the samples of `source` to the full range: keeping them for 16-bit samples up to 65535, which
+	/// is the same without the multiply, and normalizing anything else, such as 8-bit images, which would otherwise be 257
+	/// times too dark
+	constexpr Scaling FullRange(const SourceImage& source)
+	{
+		return source.format != SourceFormat::Uint8 && source.maxval == 65535 ? Scaling::Keep : Scaling::Normalize;
+	}
+
+	/// Converts a float to the nearest half, rounding ties to even
+	inline std::uint16_t FloatToHalf(float value)
+	{
+		constexpr std::uint32_t infinity = 255u << 23;
+		constexpr std::uint32_t halfMax = (127u + 16) << 23;
+		constexpr std::uint32_t denormalMagic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const auto sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		std::uint16_t half;
+
+		if (bits >= halfMax)
+		{
+			half = bits > infinity ? 0x7E00 : 0x7C00;
+		}
+		else if (bits < (113u << 23))
+		{
+			// denormal: let the float addition do the rounding
+			float magic;
+			std::memcpy(&magic, &denormalMagic, sizeof(magic));
+			std::memcpy(&value, &bits, sizeof(value));
+			value += magic;
+			std::memcpy(&bits, &value, sizeof(bits));
+			half = static_cast<std::uint16_t>(bits - denormalMagic);
+		}
+		else
+		{
+			const auto odd = (bits >> 13) & 1;
+			bits += ((15u - 127u) << 23) + 0xFFF + odd;
+			half = static_cast<std::uint16_t>(bits >> 13);
+		}
+
+		return static_cast<std::uint16_t>(half | sign >> 16);
+	}
+
+	namespace Detail
+	{
+		/// The half of every normalized 16-bit value, which fits in L2
+		inline const std::uint16_t* HalfTable()
+		{
+			static const auto table = []
+			{
+				auto values = std::make_unique<std::uint16_t[]>(65536);
+				for (std::uint32_t v = 0; v < 65536; v++)
+				{
+					values[v] = FloatToHalf(v / 65535.0f);
+				}
+
+				return values;
+			}();
+
+			return table.get();
+		}
+
+		template<SourceFormat Format>
+		inline std::uint32_t Load(const std::uint8_t* sample)
+		{
+			if constexpr (Format == SourceFormat::Uint8)
+			{
+				return sample[0];
+			}
+			else if constexpr (Format == SourceFormat::Uint16BigEndian)
+			{
+				return static_cast<std::uint32_t>(sample[0]) << 8 | sample[1];
+			}
+			else
+			{
+				std::uint16_t value;
+				std::memcpy(&value, sample, sizeof(value));
+				return value;
+			}
+		}
+
+		/// Writes one pixel of 16-bit channels. `halves` is the HalfTable for float destinations
+		template<DestinationFormat Format>
+		inline void Store(std::uint8_t* pixel, const std::uint32_t r, const std::uint32_t g, const std::uint32_t b, const std::uint16_t* halves)
+		{
+			if constexpr (Format == DestinationFormat::Rgba16Unorm)
+			{
+				const std::uint16_t values[4] = { static_cast<std::uint16_t>(r), static_cast<std::uint16_t>(g), static_cast<std::uint16_t>(b), 0xFFFF };
+				std::memcpy(pixel, values, sizeof(values));
+			}
+			else if constexpr (Format == DestinationFormat::Rgba16Float)
+			{
+				const std::uint16_t values[4] = { halves[r], halves[g], halves[b], 0x3C00 };
+				std::memcpy(pixel, values, sizeof(values));
+			}
+			else
+			{
+				// 16 to 10 bits, rounded
+				const auto pack = [](const std::uint32_t v) { return (v * 1023 + 32767) / 65535; };
+				const std::uint32_t value = pack(r) | pack(g) << 10 | pack(b) << 20 | 3u << 30;
+				std::memcpy(pixel, &value, sizeof(value));
+			}
+		}
+	}
+
+	/// Converts the destination sized region of `source` at (x, y) into `destination` in one pass:
+	/// each source row is read once, swizzled, scaled and packed, and written once.
+	/// Every combination of formats compiles to its own loop, without branches per pixel
+	template<SourceFormat Source, ChannelOrder Order, Scaling Scale, DestinationFormat Destination>
+	void Convert(const SourceImage& source, const int x, const int y, const DestinationImage& destination)
+	{
+		constexpr auto sampleBytes = SourcePixelBytes(Source) / 3;
+		constexpr auto sourcePixel = SourcePixelBytes(Source);
+		constexpr auto destinationPixel = DestinationPixelBytes(Destination);
+
+		constexpr auto red = Order == ChannelOrder::Rgb ? 0 : 2;
+		constexpr auto blue = 2 - red;
+
+		// samples are scaled in 16.16 fixed point, which is exact for maxvals of 255 and 65535. Samples above maxval are clamped
+		const std::uint32_t scale = Scale == Scaling::Normalize ? (65535u << 16) / static_cast<std::uint32_t>(source.maxval) : 1u << 16;
+		const auto widen = [scale](const std::uint32_t v) -> std::uint32_t
+		{
+			if constexpr (Scale == Scaling::Keep) return v;
+			else return std::min<std::uint32_t>(static_cast<std::uint32_t>((static_cast<std::uint64_t>(v) * scale + 0x8000) >> 16), 65535u);
+		};
+
+		const auto* halves = Destination == DestinationFormat::Rgba16Float ? Detail::HalfTable() : nullptr;
+
+		for (auto row = 0; row < destination.height; row++)
+		{
+			const auto* in = source.data + source.stride * (y + row) + sourcePixel * x;
+			auto* out = destination.data + destination.stride * row;
+
+			for (auto column = 0; column < destination.width; column++, in += sourcePixel, out += destinationPixel)
+			{
+				Detail::Store<Destination>(out,
+					widen(Detail::Load<Source>(in + red * sampleBytes)),
+					widen(Detail::Load<Source>(in + 1 * sampleBytes)),
+					widen(Detail::Load<Source>(in + blue * sampleBytes)),
+					halves);
+			}
+		}
+	}
+
+	/// Converts the destination sized region of `source` at (x, y) into `destination`, selecting the specialization of the formats.
+	/// Throws std::out_of_range if the region is not within the source, and std::invalid_argument for an invalid maxval
+	void Convert(const SourceImage& source, int x, int y, const DestinationImage& destination, Scaling scaling);
+}
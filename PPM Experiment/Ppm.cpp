@@ -0,0 +1,213 @@
+#include "Ppm.h"
+#include "MemoryAccounting.h"
+#include "PixelPipeline.h"
+#include "Trace.h"
+#include <cctype>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace Experiment::Ppm
+{
+	Header ReadHeader(const std::uint8_t* data, const std::size_t size)
+	{
+		std::size_t i = 0;
+
+		const auto skipWhitespace = [&]()
+		{
+			while (i < size)
+			{
+				if (data[i] == '#')
+				{
+					while (i < size && data[i] != '\n') i++;
+				}
+				else if (std::isspace(data[i]))
+				{
+					i++;
+				}
+				else
+				{
+					break;
+				}
+			}
+		};
+
+		const auto readInt = [&]()
+		{
+			skipWhitespace();
+
+			if (i >= size || !std::isdigit(data[i]))
+			{
+				throw std::runtime_error("Malformed PPM header");
+			}
+
+			auto value = 0;
+			while (i < size && std::isdigit(data[i]))
+			{
+				value = value * 10 + (data[i++] - '0');
+			}
+
+			return value;
+		};
+
+		if (size < 2 || data[0] != 'P' || data[1] != '6')
+		{
+			throw std::runtime_error("Not a binary PPM image");
+		}
+
+		i = 2;
+
+		Header header = {};
+		header.width = readInt();
+		header.height = readInt();
+		header.maxval = readInt();
+
+		// exactly one whitespace character separates the header from the pixels
+		header.dataOffset = i + 1;
+
+		if (header.maxval < 1 || header.maxval > 65535)
+		{
+			throw std::runtime_error("Invalid PPM maxval");
+		}
+
+		const auto bytes = static_cast<std::size_t>(header.width) * header.height * 3 * header.BytesPerChannel();
+		if (header.dataOffset + bytes > size)
+		{
+			throw std::runtime_error("Truncated PPM image");
+		}
+
+		return header;
+	}
+
+	std::vector<std::uint8_t> ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			throw std::runtime_error(path.generic_string() + " cannot be opened");
+		}
+
+		std::vector<std::uint8_t> data(std::filesystem::file_size(path));
+		file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+		return data;
+	}
+
+	std::uint8_t* ReadFile(const std::filesystem::path& path, Arena& arena, std::size_t& size)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			throw std::runtime_error(path.generic_string() + " cannot be opened");
+		}
+
+		size = static_cast<std::size_t>(std::filesystem::file_size(path));
+
+		auto* data = arena.Allocate<std::uint8_t>(size);
+		file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+
+		return data;
+	}
+
+	void Decode(const std::uint8_t* data, const std::size_t size, const Rgba16View destination, const int x, const int y)
+	{
+		const auto header = ReadHeader(data, size);
+
+		Pixels::SourceImage source = {};
+		source.data = data + header.dataOffset;
+		source.width = header.width;
+		source.height = header.height;
+		source.format = header.BytesPerChannel() == 2 ? Pixels::SourceFormat::Uint16BigEndian : Pixels::SourceFormat::Uint8;
+		source.stride = static_cast<std::size_t>(header.width) * Pixels::SourcePixelBytes(source.format);
+		source.maxval = header.maxval;
+
+		Pixels::DestinationImage target = {};
+		target.data = reinterpret_cast<std::uint8_t*>(destination.data);
+		target.width = destination.width;
+		target.height = destination.height;
+		target.stride = destination.stride;
+
+		Pixels::Convert(source, x, y, target, Pixels::FullRange(source));
+	}
+
+	Frame Read(const std::filesystem::path& path, Arena* scratch, Timings* timings)
+	{
+		TRACE_SCOPE("load", "Read PPM");
+
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::uint8_t> buffer;
+		const std::uint8_t* data = nullptr;
+		std::size_t size = 0;
+
+		std::optional<Arena::Scope> scope;
+
+		if (scratch != nullptr)
+		{
+			scope.emplace(*scratch);
+			data = ReadFile(path, *scratch, size);
+		}
+		else
+		{
+			buffer = ReadFile(path);
+			data = buffer.data();
+			size = buffer.size();
+		}
+
+		const auto read = std::chrono::steady_clock::now();
+
+		const auto header = ReadHeader(data, size);
+		// left uninitialized, since every sample is written by the decode
+		const auto samples = static_cast<std::size_t>(header.width) * header.height * 4;
+		std::shared_ptr<std::uint16_t[]> pixels(new std::uint16_t[samples]);
+
+		Frame frame = {};
+		frame.width = header.width;
+		frame.height = header.height;
+		frame.stride = static_cast<std::size_t>(header.width) * frame.PixelBytes();
+		frame.data = reinterpret_cast<std::uint8_t*>(pixels.get());
+		frame.owner = MemoryAccounting::Track(MemoryTag::DecodedFrames, samples * sizeof(std::uint16_t), pixels);
+
+		Decode(data, size, Rgba16View(frame));
+
+		if (timings != nullptr)
+		{
+			const auto decoded = std::chrono::steady_clock::now();
+			timings->read += read - start;
+			timings->decode += decoded - read;
+		}
+
+		return frame;
+	}
+
+	void Write(const std::filesystem::path& path, const Frame& frame, const int maxval)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			throw std::runtime_error(path.generic_string() + " cannot be written");
+		}
+
+		file << "P6\n" << frame.width << " " << frame.height << "\n" << maxval << "\n";
+
+		const ConstRgba16View view(frame);
+		std::vector<std::uint8_t> row(static_cast<std::size_t>(frame.width) * 6);
+
+		for (auto y = 0; y < frame.height; y++)
+		{
+			const auto* source = view.Row(y);
+
+			for (auto x = 0; x < frame.width; x++, source += 4)
+			{
+				for (auto c = 0; c < 3; c++)
+				{
+					row[x * 6 + c * 2] = static_cast<std::uint8_t>(source[c] >> 8);
+					row[x * 6 + c * 2 + 1] = static_cast<std::uint8_t>(source[c] & 0xFF);
+				}
+			}
+
+			file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+		}
+	}
+}
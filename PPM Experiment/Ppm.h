@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "Arena.h"
+#include "Frame.h"
+#include "ImageView.h"
+
+namespace Experiment::Ppm
+{
+	/// The header of a binary (P6) PPM image
+	struct Header
+	{
+		int width = 0;
+		int height = 0;
+		int maxval = 0;
+
+		/// The offset of the first pixel from the start of the file
+		std::size_t dataOffset = 0;
+
+		[[nodiscard]] int BytesPerChannel() const { return maxval > 255 ? 2 : 1; }
+	};
+
+	/// Parses the header of the P6 image in `data`, throwing std::runtime_error if it is malformed
+	Header ReadHeader(const std::uint8_t* data, std::size_t size);
+
+	/// Reads the whole file at `path`
+	std::vector<std::uint8_t> ReadFile(const std::filesystem::path& path);
+
+	/// Reads the whole file at `path` into memory from `arena`, and sets `size` to its length
+	std::uint8_t* ReadFile(const std::filesystem::path& path, Arena& arena, std::size_t& size);
+
+	/// Decodes the `destination` sized region at (x, y) of the P6 image in `data` into `destination`, in one pass.
+	/// Samples are scaled from [0, maxval] to the full 16-bit range. Throws std::out_of_range if the region is not within the image
+	void Decode(const std::uint8_t* data, std::size_t size, Rgba16View destination, int x = 0, int y = 0);
+
+	/// The time spent reading files and decoding them, added to by every Read given it
+	struct Timings
+	{
+		std::chrono::nanoseconds read{};
+		std::chrono::nanoseconds decode{};
+	};
+
+	/// Decodes the P6 image at `path` into a new RGBA16 frame. The file is read into `scratch` if given, which is rewound afterwards
+	Frame Read(const std::filesystem::path& path, Arena* scratch = nullptr, Timings* timings = nullptr);
+
+	/// Writes the red, green and blue channels of an RGBA16 frame as a 16-bit P6 image
+	void Write(const std::filesystem::path& path, const Frame& frame, int maxval = 65535);
+}
@@ -0,0 +1,159 @@
+#include "Preloader.h"
+#include "Trace.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#endif
+
+namespace Experiment
+{
+	std::size_t Preloader::RequiredBytes(const std::size_t stimuli, const int width, const int height)
+	{
+		return stimuli * static_cast<std::size_t>(width) * height * 4 * sizeof(std::uint16_t);
+	}
+
+	std::size_t Preloader::AvailableMemory()
+	{
+#ifdef _WIN32
+		MEMORYSTATUSEX status = {};
+		status.dwLength = sizeof(status);
+
+		if (!GlobalMemoryStatusEx(&status))
+		{
+			return 0;
+		}
+
+		return static_cast<std::size_t>(status.ullAvailPhys);
+#else
+		// MemAvailable includes reclaimable page cache, unlike the free page count
+		std::ifstream meminfo("/proc/meminfo");
+		std::string key;
+		std::size_t kilobytes = 0;
+
+		while (meminfo >> key >> kilobytes)
+		{
+			if (key == "MemAvailable:")
+			{
+				return kilobytes * 1024;
+			}
+
+			meminfo.ignore(64, '\n');
+		}
+
+		return static_cast<std::size_t>(sysconf(_SC_AVPHYS_PAGES)) * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	bool Preloader::Fits(const std::size_t bytes, const std::size_t headroom)
+	{
+		return bytes + headroom <= AvailableMemory();
+	}
+
+	Preloader::Preloader(const std::size_t stimuli, const int width, const int height, Fill fill, const unsigned threads) :
+		m_stimuli(stimuli),
+		m_fill(std::move(fill)),
+		m_threadCount(threads == 0 ? 1 : threads),
+		m_arena(new std::uint8_t[RequiredBytes(stimuli, width, height)]),
+		m_charge(MemoryAccounting::Global(), MemoryTag::Preload, RequiredBytes(stimuli, width, height)),
+		m_slots(stimuli),
+		m_ready(new std::atomic<bool>[stimuli])
+	{
+		const auto bytes = RequiredBytes(1, width, height);
+
+		for (std::size_t i = 0; i < stimuli; i++)
+		{
+			auto& slot = m_slots[i];
+			slot.width = width;
+			slot.height = height;
+			slot.stride = static_cast<std::size_t>(width) * slot.PixelBytes();
+			slot.data = m_arena.get() + i * bytes;
+
+			m_ready[i] = false;
+		}
+	}
+
+	Preloader::~Preloader()
+	{
+		m_cancel = true;
+
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	void Preloader::Start()
+	{
+		m_start = std::chrono::steady_clock::now();
+
+		for (unsigned i = 0; i < m_threadCount; i++)
+		{
+			m_threads.emplace_back([this]() { Work(); });
+		}
+	}
+
+	void Preloader::Wait()
+	{
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+
+		m_threads.clear();
+	}
+
+	void Preloader::Work()
+	{
+		TRACE_THREAD("Preload");
+
+		for (auto i = m_next++; i < m_stimuli && !m_cancel; i = m_next++)
+		{
+			TRACE_SCOPE("load", "Preload stimulus");
+
+			// a stimulus which fails to load is left to the streaming path, which reports the error
+			try
+			{
+				m_fill(i, m_slots[i]);
+				m_ready[i].store(true, std::memory_order_release);
+			}
+			catch (...)
+			{
+			}
+
+			if (++m_done == m_stimuli)
+			{
+				m_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+			}
+		}
+	}
+
+	float Preloader::Progress() const
+	{
+		return m_stimuli == 0 ? 1.0f : static_cast<float>(m_done.load()) / static_cast<float>(m_stimuli);
+	}
+
+	const Frame* Preloader::Get(const std::size_t index) const
+	{
+		if (index >= m_stimuli || !m_ready[index].load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		return &m_slots[index];
+	}
+
+	Preloader::Statistics Preloader::GetStatistics() const
+	{
+		return { m_stimuli, m_slots.empty() ? 0 : m_slots.size() * m_slots[0].Bytes(), m_milliseconds.load() };
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Frame.h"
+#include "MemoryAccounting.h"
+
+namespace Experiment
+{
+	/// Decodes a whole session of equally sized stimuli up front into one contiguous arena, on several threads
+	class Preloader
+	{
+	public:
+		/// Fills `slot`, an empty frame of the stimulus dimensions, with stimulus `index`
+		using Fill = std::function<void(std::size_t index, Frame& slot)>;
+
+		struct Statistics
+		{
+			std::size_t stimuli = 0;
+			std::size_t bytes = 0;
+			double milliseconds = 0.0;
+		};
+
+		/// The bytes needed to preload `stimuli` RGBA16 stimuli of `width` by `height`
+		[[nodiscard]] static std::size_t RequiredBytes(std::size_t stimuli, int width, int height);
+
+		/// The physical memory currently available to the process
+		[[nodiscard]] static std::size_t AvailableMemory();
+
+		/// Whether `bytes` can be preloaded while leaving `headroom` bytes of physical memory free
+		[[nodiscard]] static bool Fits(std::size_t bytes, std::size_t headroom);
+
+		Preloader(std::size_t stimuli, int width, int height, Fill fill, unsigned threads = std::thread::hardware_concurrency());
+		~Preloader();
+
+		Preloader(const Preloader&) = delete;
+		Preloader& operator=(const Preloader&) = delete;
+
+		/// Starts the worker threads and returns immediately
+		void Start();
+
+		/// Blocks until every stimulus is loaded
+		void Wait();
+
+		/// The fraction of stimuli loaded, from 0 to 1
+		[[nodiscard]] float Progress() const;
+
+		[[nodiscard]] bool IsDone() const { return m_done.load() == m_stimuli; }
+
+		/// The preloaded stimulus `index`, or nullptr if it is not loaded yet
+		[[nodiscard]] const Frame* Get(std::size_t index) const;
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		void Work();
+
+		std::size_t m_stimuli;
+		Fill m_fill;
+		unsigned m_threadCount;
+
+		std::unique_ptr<std::uint8_t[]> m_arena;
+		MemoryAccounting::Charge m_charge;
+		std::vector<Frame> m_slots;
+		std::unique_ptr<std::atomic<bool>[]> m_ready;
+
+		std::atomic<std::size_t> m_next{ 0 };
+		std::atomic<std::size_t> m_done{ 0 };
+		std::atomic<bool> m_cancel{ false };
+
+		std::vector<std::thread> m_threads;
+
+		std::chrono::steady_clock::time_point m_start;
+		std::atomic<double> m_milliseconds{ 0.0 };
+	};
+}
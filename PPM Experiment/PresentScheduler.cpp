@@ -0,0 +1,153 @@
+#include "PresentScheduler.h"
+#include "Trace.h"
+#include <algorithm>
+#include <ostream>
+
+namespace Experiment
+{
+	Barrier::Barrier(const std::size_t count) : m_count(count)
+	{
+	}
+
+	void Barrier::ArriveAndWait()
+	{
+		const auto round = m_round.load(std::memory_order_acquire);
+
+		if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count)
+		{
+			m_arrived.store(0, std::memory_order_relaxed);
+			m_round.store(round + 1, std::memory_order_release);
+			return;
+		}
+
+		// yielding lets the last thread arrive when there are fewer cores than threads
+		while (m_round.load(std::memory_order_acquire) == round)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	PresentScheduler::PresentScheduler(std::vector<IPresentTarget*> targets) :
+		m_targets(std::move(targets)),
+		m_barrier(m_targets.size()),
+		m_issued(m_targets.size()),
+		m_returned(m_targets.size()),
+		m_errors(m_targets.size())
+	{
+		for (std::size_t i = 0; i < m_targets.size(); i++)
+		{
+			m_threads.emplace_back([this, i] { Work(i); });
+		}
+	}
+
+	PresentScheduler::~PresentScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_start.notify_all();
+
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	void PresentScheduler::Present()
+	{
+		TRACE_SCOPE("present", "Present windows");
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_presenting = m_targets.size();
+			m_frame++;
+		}
+
+		m_start.notify_all();
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this] { return m_presenting == 0; });
+		}
+
+		for (auto& error : m_errors)
+		{
+			if (error)
+			{
+				const auto rethrown = error;
+				std::fill(m_errors.begin(), m_errors.end(), nullptr);
+
+				std::rethrow_exception(rethrown);
+			}
+		}
+
+		const auto skew = [](const std::vector<Clock::time_point>& times)
+		{
+			const auto [first, last] = std::minmax_element(times.begin(), times.end());
+			return *last - *first;
+		};
+
+		auto& s = m_statistics;
+		s.frames++;
+
+		s.lastIssueSkew = skew(m_issued);
+		s.maxIssueSkew = std::max(s.maxIssueSkew, s.lastIssueSkew);
+		s.totalIssueSkew += s.lastIssueSkew;
+
+		s.lastReturnSkew = skew(m_returned);
+		s.maxReturnSkew = std::max(s.maxReturnSkew, s.lastReturnSkew);
+		s.totalReturnSkew += s.lastReturnSkew;
+	}
+
+	void PresentScheduler::Work(const std::size_t window)
+	{
+		TRACE_THREAD("Present");
+
+		std::size_t frame = 0;
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_start.wait(lock, [&] { return m_stop || m_frame != frame; });
+
+				if (m_stop) return;
+				frame = m_frame;
+			}
+
+			// the windows leave the barrier together, however late each thread woke up
+			m_barrier.ArriveAndWait();
+
+			m_issued[window] = Clock::now();
+
+			try
+			{
+				TRACE_SCOPE("present", "Present window");
+				m_targets[window]->Present();
+			}
+			catch (...)
+			{
+				m_errors[window] = std::current_exception();
+			}
+
+			m_returned[window] = Clock::now();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_presenting == 0) m_done.notify_one();
+			}
+		}
+	}
+
+	std::ostream& operator<<(std::ostream& os, const PresentScheduler::Statistics& s)
+	{
+		const auto microseconds = [](const PresentScheduler::Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+		const auto frames = static_cast<double>(std::max<std::size_t>(1, s.frames));
+
+		os << "frames: " << s.frames << ", issue skew: " << microseconds(s.totalIssueSkew) / frames << " us mean, " << microseconds(s.maxIssueSkew)
+			<< " us max, return skew: " << microseconds(s.totalReturnSkew) / frames << " us mean, " << microseconds(s.maxReturnSkew) << " us max";
+		return os;
+	}
+}
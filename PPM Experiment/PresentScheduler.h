@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Experiment
+{
+	/// Blocks the threads of a round until all of them have arrived, spinning rather than sleeping so that they leave together.
+	/// Reusable for any number of rounds
+	class Barrier
+	{
+	public:
+		explicit Barrier(std::size_t count);
+
+		void ArriveAndWait();
+
+	private:
+		const std::size_t m_count;
+
+		std::atomic<std::size_t> m_arrived{ 0 };
+		std::atomic<std::size_t> m_round{ 0 };
+	};
+
+	/// A window to present, like a swap chain
+	class IPresentTarget
+	{
+	public:
+		virtual ~IPresentTarget() = default;
+
+		/// Presents the back buffer, blocking as the swap chain does
+		virtual void Present() = 0;
+	};
+
+	/// Presents several windows at once, each from a thread of its own released by a shared barrier, so that the eyes of a stereo
+	/// pair are queued for the same vertical blank rather than one after the other. Records when each present was issued and
+	/// returned, and reports the skew between the windows
+	class PresentScheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Statistics
+		{
+			std::size_t frames = 0;
+
+			/// The spread of the times the presents of a frame were issued, between the first and the last window
+			Clock::duration lastIssueSkew = {};
+			Clock::duration maxIssueSkew = {};
+			Clock::duration totalIssueSkew = {};
+
+			/// The spread of the times they returned, which follows the vertical blanks they were queued for
+			Clock::duration lastReturnSkew = {};
+			Clock::duration maxReturnSkew = {};
+			Clock::duration totalReturnSkew = {};
+		};
+
+		explicit PresentScheduler(std::vector<IPresentTarget*> targets);
+
+		/// Stops the threads, once the frame being presented is
+		~PresentScheduler();
+
+		PresentScheduler(const PresentScheduler&) = delete;
+		PresentScheduler& operator=(const PresentScheduler&) = delete;
+
+		/// Presents every window at once and returns when all of them have, rethrowing the error of a failed present
+		void Present();
+
+		/// When the presents of the last frame were issued and returned, per window
+		[[nodiscard]] const std::vector<Clock::time_point>& GetIssued() const { return m_issued; }
+		[[nodiscard]] const std::vector<Clock::time_point>& GetReturned() const { return m_returned; }
+
+		[[nodiscard]] Statistics GetStatistics() const { return m_statistics; }
+
+	private:
+		void Work(std::size_t window);
+
+		std::vector<IPresentTarget*> m_targets;
+
+		Barrier m_barrier;
+
+		std::mutex m_mutex;
+		std::condition_variable m_start;
+		std::condition_variable m_done;
+		std::size_t m_frame = 0;
+		std::size_t m_presenting = 0;
+		bool m_stop = false;
+
+		std::vector<Clock::time_point> m_issued;
+		std::vector<Clock::time_point> m_returned;
+		std::vector<std::exception_ptr> m_errors;
+
+		Statistics m_statistics;
+
+		std::vector<std::thread> m_threads;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const PresentScheduler::Statistics& s);
+}
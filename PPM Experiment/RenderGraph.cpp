@@ -0,0 +1,208 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <sstream>
+
+namespace Experiment
+{
+	bool RenderGraph::Plan::Runs(const std::size_t pass) const
+	{
+		return StepOf(pass) != nullptr;
+	}
+
+	const RenderGraph::Plan::Step* RenderGraph::Plan::StepOf(const std::size_t pass) const
+	{
+		for (const auto& step : steps)
+		{
+			if (step.pass == pass || std::find(step.folded.begin(), step.folded.end(), pass) != step.folded.end())
+			{
+				return &step;
+			}
+		}
+
+		return nullptr;
+	}
+
+	RenderGraph::Resource RenderGraph::Create(std::string name, const std::size_t bytes)
+	{
+		m_resources.push_back({ std::move(name), bytes, false });
+		return m_resources.size() - 1;
+	}
+
+	RenderGraph::Resource RenderGraph::Import(std::string name)
+	{
+		m_resources.push_back({ std::move(name), 0, true });
+		return m_resources.size() - 1;
+	}
+
+	std::size_t RenderGraph::AddPass(Pass pass)
+	{
+		m_passes.push_back(std::move(pass));
+		return m_passes.size() - 1;
+	}
+
+	RenderGraph::Plan RenderGraph::Compile() const
+	{
+		const auto contains = [](const std::vector<Resource>& resources, const Resource resource)
+		{
+			return std::find(resources.begin(), resources.end(), resource) != resources.end();
+		};
+
+		// backwards from what leaves the graph: a pass runs if it has side effects or writes what a later pass needs
+		std::vector<bool> needed(m_resources.size());
+		std::vector<bool> live(m_passes.size());
+		std::vector<std::vector<Resource>> writes(m_passes.size());
+
+		for (std::size_t r = 0; r < m_resources.size(); r++)
+		{
+			needed[r] = m_resources[r].imported;
+		}
+
+		for (auto i = m_passes.size(); i-- > 0;)
+		{
+			const auto& pass = m_passes[i];
+
+			for (const auto resource : pass.writes)
+			{
+				if (needed[resource]) writes[i].push_back(resource);
+			}
+
+			live[i] = pass.sideEffects || !writes[i].empty();
+
+			if (!live[i])
+			{
+				writes[i].clear();
+				continue;
+			}
+
+			// what an opaque pass overwrites is not needed from the passes before it
+			if (pass.opaque)
+			{
+				for (const auto resource : writes[i]) needed[resource] = false;
+			}
+
+			for (const auto resource : pass.reads) needed[resource] = true;
+		}
+
+		Plan plan;
+
+		for (std::size_t i = 0; i < m_passes.size(); i++)
+		{
+			if (live[i]) plan.steps.push_back({ i, {}, writes[i] });
+		}
+
+		// a per pixel pass reading only what an opaque pass wrote for it alone runs in the shader of that pass
+		for (std::size_t s = 0; s < plan.steps.size();)
+		{
+			const auto& pass = m_passes[plan.steps[s].pass];
+			auto folded = false;
+
+			if (pass.perPixel && pass.reads.size() == 1 && !m_resources[pass.reads[0]].imported)
+			{
+				const auto input = pass.reads[0];
+
+				// the last step writing the input
+				auto producer = s;
+				while (producer-- > 0 && !contains(plan.steps[producer].writes, input)) {}
+
+				const auto readers = std::count_if(plan.steps.begin(), plan.steps.end(), [&](const Plan::Step& step) { return contains(m_passes[step.pass].reads, input); });
+
+				if (producer < s && m_passes[plan.steps[producer].pass].opaque && plan.steps[producer].writes == std::vector<Resource>{ input } && readers == 1)
+				{
+					auto& into = plan.steps[producer];
+
+					into.writes = plan.steps[s].writes;
+					into.folded.push_back(plan.steps[s].pass);
+					into.folded.insert(into.folded.end(), plan.steps[s].folded.begin(), plan.steps[s].folded.end());
+
+					plan.steps.erase(plan.steps.begin() + static_cast<std::ptrdiff_t>(s));
+					folded = true;
+				}
+			}
+
+			if (!folded) s++;
+		}
+
+		plan.allocated.assign(m_resources.size(), false);
+
+		for (const auto& step : plan.steps)
+		{
+			for (const auto resource : step.writes) plan.allocated[resource] = true;
+			for (const auto resource : m_passes[step.pass].reads) plan.allocated[resource] = true;
+		}
+
+		for (std::size_t r = 0; r < m_resources.size(); r++)
+		{
+			if (m_resources[r].imported) continue;
+
+			(plan.allocated[r] ? plan.allocatedBytes : plan.elidedBytes) += m_resources[r].bytes;
+		}
+
+		return plan;
+	}
+
+	std::string RenderGraph::Describe(const Plan& plan) const
+	{
+		std::ostringstream os;
+
+		for (const auto& step : plan.steps)
+		{
+			if (&step != &plan.steps.front()) os << ", ";
+
+			os << m_passes[step.pass].name;
+			for (const auto pass : step.folded) os << " + " << m_passes[pass].name;
+
+			for (const auto resource : step.writes)
+			{
+				os << (resource == step.writes.front() ? " -> " : " & ") << m_resources[resource].name;
+			}
+		}
+
+		std::vector<std::string> elided;
+
+		for (std::size_t r = 0; r < m_resources.size(); r++)
+		{
+			if (!plan.allocated[r]) elided.push_back(m_resources[r].name);
+		}
+
+		for (std::size_t p = 0; p < m_passes.size(); p++)
+		{
+			if (!plan.Runs(p)) elided.push_back(m_passes[p].name + " pass");
+		}
+
+		os << "; elided: ";
+		for (const auto& name : elided) os << name << (&name != &elided.back() ? ", " : "");
+
+		os << " (" << plan.elidedBytes / (1024 * 1024) << " MB)";
+		return os.str();
+	}
+
+	FrameGraph::FrameGraph(const int width, const int height, const bool opaqueSprites)
+	{
+		const auto pixels = static_cast<std::size_t>(width) * height;
+
+		scene = graph.Create("HDR scene", pixels * 8);
+		depth = graph.Create("Depth", pixels * 4);
+		backBuffer = graph.Import("Back buffer");
+
+		// the sprites clear and bind a depth buffer, which nothing tests against
+		RenderGraph::Pass sprites;
+		sprites.name = "Composite";
+		sprites.writes = { scene, depth };
+		sprites.opaque = opaqueSprites;
+		composite = graph.AddPass(std::move(sprites));
+
+		RenderGraph::Pass tone;
+		tone.name = "Tone map";
+		tone.reads = { scene };
+		tone.writes = { backBuffer };
+		tone.opaque = true;
+		tone.perPixel = true;
+		toneMap = graph.AddPass(std::move(tone));
+
+		RenderGraph::Pass swap;
+		swap.name = "Present";
+		swap.reads = { backBuffer };
+		swap.sideEffects = true;
+		present = graph.AddPass(std::move(swap));
+	}
+}
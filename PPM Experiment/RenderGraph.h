@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Experiment
+{
+	/// The passes of a frame and the attachments they read and write, declared up front so that what a frame does not need is
+	/// never allocated, cleared or bound. Compiling the graph drops the passes nothing presented depends on and the attachments
+	/// nothing reads, and folds a per pixel pass into the opaque pass producing its only input, which then writes the output of
+	/// the folded pass directly
+	class RenderGraph
+	{
+	public:
+		using Resource = std::size_t;
+
+		struct Pass
+		{
+			std::string name;
+
+			std::vector<Resource> reads;
+			std::vector<Resource> writes;
+
+			/// Overwrites its attachments without blending or reading them
+			bool opaque = false;
+
+			/// Each pixel written is a function of the same pixel read, so it can run in the shader of the pass before
+			bool perPixel = false;
+
+			/// Has an effect outside the graph, like presenting, so it always runs
+			bool sideEffects = false;
+		};
+
+		/// What a frame runs once compiled
+		struct Plan
+		{
+			struct Step
+			{
+				std::size_t pass = 0;
+
+				/// The passes folded into this one, in order
+				std::vector<std::size_t> folded;
+
+				/// The attachments written, after elision and folding
+				std::vector<Resource> writes;
+			};
+
+			std::vector<Step> steps;
+
+			/// Per resource, whether it must exist
+			std::vector<bool> allocated;
+
+			std::size_t allocatedBytes = 0;
+			std::size_t elidedBytes = 0;
+
+			[[nodiscard]] bool IsAllocated(Resource resource) const { return allocated[resource]; }
+
+			/// Whether `pass` runs, on its own or folded into another
+			[[nodiscard]] bool Runs(std::size_t pass) const;
+
+			/// The step `pass` runs in, or nullptr if it was dropped
+			[[nodiscard]] const Step* StepOf(std::size_t pass) const;
+		};
+
+		/// Declares an attachment of the frame, which is only allocated if the plan needs it
+		Resource Create(std::string name, std::size_t bytes);
+
+		/// Declares an attachment owned outside the graph, like the back buffer, which is what the frame produces
+		Resource Import(std::string name);
+
+		/// Declares the next pass of the frame, and returns its index
+		std::size_t AddPass(Pass pass);
+
+		[[nodiscard]] Plan Compile() const;
+
+		/// The steps of `plan`, with the passes they fold, and the attachments elided
+		[[nodiscard]] std::string Describe(const Plan& plan) const;
+
+		[[nodiscard]] const Pass& GetPass(const std::size_t pass) const { return m_passes[pass]; }
+
+	private:
+		struct Attachment
+		{
+			std::string name;
+			std::size_t bytes = 0;
+			bool imported = false;
+		};
+
+		std::vector<Attachment> m_resources;
+		std::vector<Pass> m_passes;
+	};
+
+	/// The passes of a frame of the experiment: the sprites composited into an RGBA16F scene with a depth buffer, tone mapped to
+	/// ST.2084 on the back buffer, and presented. Sprites are opaque, so the plan writes them straight to the back buffer
+	struct FrameGraph
+	{
+		FrameGraph(int width, int height, bool opaqueSprites = true);
+
+		RenderGraph graph;
+
+		RenderGraph::Resource scene;
+		RenderGraph::Resource depth;
+		RenderGraph::Resource backBuffer;
+
+		std::size_t composite;
+		std::size_t toneMap;
+		std::size_t present;
+	};
+}
@@ -0,0 +1,157 @@
+#include "RenderThread.h"
+#include "Trace.h"
+#include <algorithm>
+#include <ostream>
+#include <utility>
+
+namespace Experiment
+{
+	RenderThread::RenderThread(std::function<void(const WindowEvent&)> dispatch, std::function<void()> tick, const std::size_t capacity) :
+		m_dispatch(std::move(dispatch)),
+		m_tick(std::move(tick)),
+		m_events(capacity)
+	{
+		m_thread = std::thread([this] { Run(); });
+	}
+
+	RenderThread::~RenderThread()
+	{
+		Stop();
+	}
+
+	void RenderThread::Post(const WindowEvent& event)
+	{
+		// events held back go first, so that the render thread sees them in the order they were posted
+		if (!Flush() && m_events.TryPush(event))
+		{
+			const auto queued = m_events.Size();
+			if (queued > m_maxQueued.load(std::memory_order_relaxed))
+			{
+				m_maxQueued.store(queued, std::memory_order_relaxed);
+			}
+			return;
+		}
+
+		m_deferred.fetch_add(1, std::memory_order_relaxed);
+
+		// only the latest position and size of a window matter, so a move or resize replaces the one held since the last key or
+		// other event; those are all kept
+		const auto mergeable = [](const WindowEvent& e) { return e.type == WindowEvent::Type::Moved || e.type == WindowEvent::Type::Resized; };
+		if (mergeable(event))
+		{
+			for (auto held = m_held.rbegin(); held != m_held.rend() && mergeable(*held); ++held)
+			{
+				if (held->type == event.type && held->window == event.window)
+				{
+					*held = event;
+					m_merged.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+			}
+		}
+
+		m_held.push_back(event);
+	}
+
+	bool RenderThread::Flush()
+	{
+		while (!m_held.empty() && m_events.TryPush(m_held.front()))
+		{
+			m_held.pop_front();
+		}
+
+		if (m_events.Size() > m_maxQueued.load(std::memory_order_relaxed))
+		{
+			m_maxQueued.store(m_events.Size(), std::memory_order_relaxed);
+		}
+
+		return !m_held.empty();
+	}
+
+	void RenderThread::Stop()
+	{
+		if (!m_thread.joinable()) return;
+
+		m_running.store(false, std::memory_order_release);
+
+		// the render thread keeps draining until the events held back are queued; it no longer ticks, so nothing it does
+		// waits on this thread
+		while (Flush())
+		{
+			std::this_thread::yield();
+		}
+
+		m_closed.store(true, std::memory_order_release);
+		m_thread.join();
+	}
+
+	RenderThread::Statistics RenderThread::GetStatistics() const
+	{
+		Statistics s;
+		s.ticks = m_ticks.load(std::memory_order_relaxed);
+		s.events = m_dispatched.load(std::memory_order_relaxed);
+		s.deferred = m_deferred.load(std::memory_order_relaxed);
+		s.merged = m_merged.load(std::memory_order_relaxed);
+		s.maxQueued = m_maxQueued.load(std::memory_order_relaxed);
+		s.longestGap = Clock::duration(m_longestGap.load(std::memory_order_relaxed));
+		return s;
+	}
+
+	void RenderThread::Run()
+	{
+		TRACE_THREAD("Render");
+
+		auto last = Clock::now();
+
+		while (m_running.load(std::memory_order_acquire))
+		{
+			Drain();
+
+			const auto now = Clock::now();
+			const auto gap = (now - last).count();
+			last = now;
+
+			if (m_ticks.load(std::memory_order_relaxed) > 0 && gap > m_longestGap.load(std::memory_order_relaxed))
+			{
+				m_longestGap.store(gap, std::memory_order_relaxed);
+			}
+
+			{
+				TRACE_SCOPE("frame", "Tick");
+				m_tick();
+			}
+
+			m_ticks.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// events posted before Stop are still delivered, including those held back until the queue had room
+		while (!m_closed.load(std::memory_order_acquire))
+		{
+			Drain();
+			std::this_thread::yield();
+		}
+
+		Drain();
+	}
+
+	void RenderThread::Drain()
+	{
+		// bounded, so that a UI thread posting as fast as it can does not starve the tick
+		WindowEvent event;
+		for (std::size_t i = 0; i < m_events.Capacity() && m_events.TryPop(event); i++)
+		{
+			TRACE_SCOPE("input", "Dispatch event");
+			m_dispatch(event);
+			m_dispatched.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	std::ostream& operator<<(std::ostream& os, const RenderThread::Statistics& s)
+	{
+		const auto milliseconds = std::chrono::duration<double, std::milli>(s.longestGap).count();
+
+		os << "ticks: " << s.ticks << ", events: " << s.events << ", deferred events: " << s.deferred << ", merged: " << s.merged << ", most queued: " << s.maxQueued
+			<< ", longest gap between ticks: " << milliseconds << " ms";
+		return os;
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <thread>
+#include "SpscQueue.h"
+
+namespace Experiment
+{
+	/// An input or window event, forwarded from the message pump of the UI thread to the render thread
+	struct WindowEvent
+	{
+		enum class Type
+		{
+			KeyDown,
+			Escape,
+			Moved,
+			Resized,
+			Activated,
+			Deactivated,
+			Suspending,
+			Resuming
+		};
+
+		Type type = Type::KeyDown;
+
+		/// The index of the window, for apps with several
+		int window = 0;
+
+		/// The virtual key of KeyDown
+		std::uintptr_t key = 0;
+
+		/// The client size of Resized
+		int width = 0;
+		int height = 0;
+	};
+
+	/// Ticks the game on a thread of its own, so that a message pump blocked in a dialog, a size/move loop or a slow handler
+	/// never stalls the flicker timing. The UI thread only posts events, which the render thread dispatches before each tick;
+	/// the queue between them is lock free, so the render thread never waits on the UI thread
+	class RenderThread
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Statistics
+		{
+			std::size_t ticks = 0;
+			std::size_t events = 0;
+
+			/// Events posted while the queue was full, which the UI thread held back until the render thread made room
+			std::size_t deferred = 0;
+
+			/// Moves and resizes held back that replaced the one held before them
+			std::size_t merged = 0;
+			std::size_t maxQueued = 0;
+
+			/// The longest time between the starts of consecutive ticks
+			Clock::duration longestGap = {};
+		};
+
+		/// Starts the thread. `dispatch` handles an event and `tick` advances and draws a frame, both on the render thread
+		RenderThread(std::function<void(const WindowEvent&)> dispatch, std::function<void()> tick, std::size_t capacity = 256);
+
+		/// Stops the thread, once its tick has returned
+		~RenderThread();
+
+		RenderThread(const RenderThread&) = delete;
+		RenderThread& operator=(const RenderThread&) = delete;
+
+		/// Queues an event from the UI thread, the only producer, without waiting. If the queue is full, the event is held back
+		/// on the UI thread rather than dropped, and a move or resize replaces the one held just before it; the UI thread may be
+		/// the one the render thread waits on, for instance while DXGI sends it a message from Present or a mode change
+		void Post(const WindowEvent& event);
+
+		/// Hands the events held back to the queue, as far as it has room. Returns whether some are still held, in which case the
+		/// message loop calls it again shortly while it keeps pumping messages
+		bool Flush();
+
+		/// Dispatches the events still queued or held back, then stops and joins the thread. Called from the UI thread
+		void Stop();
+
+		/// Safe to call while running; the counters are read one at a time
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		void Run();
+		void Drain();
+
+		std::function<void(const WindowEvent&)> m_dispatch;
+		std::function<void()> m_tick;
+
+		SpscQueue<WindowEvent> m_events;
+		std::atomic<bool> m_running{ true };
+
+		/// Set by Stop once every event held back is in the queue
+		std::atomic<bool> m_closed{ false };
+
+		/// Only touched by the UI thread
+		std::deque<WindowEvent> m_held;
+
+		std::atomic<std::size_t> m_ticks{ 0 };
+		std::atomic<std::size_t> m_dispatched{ 0 };
+		std::atomic<std::size_t> m_deferred{ 0 };
+		std::atomic<std::size_t> m_merged{ 0 };
+		std::atomic<std::size_t> m_maxQueued{ 0 };
+		std::atomic<Clock::rep> m_longestGap{ 0 };
+
+		std::thread m_thread;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const RenderThread::Statistics& s);
+}
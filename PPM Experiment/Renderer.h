@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "ImageView.h"
+
+namespace Experiment
+{
+	/// A texture of a renderer: a view of the pixels for the CPU renderer, a shader resource view for the GPU one.
+	/// A texture array has several slices of the same size
+	class ITexture
+	{
+	public:
+		virtual ~ITexture() = default;
+
+		[[nodiscard]] virtual int Width() const = 0;
+		[[nodiscard]] virtual int Height() const = 0;
+		[[nodiscard]] virtual int Slices() const { return 1; }
+	};
+
+	struct Point
+	{
+		float x = 0, y = 0;
+	};
+
+	struct Rect
+	{
+		int left = 0, top = 0, right = 0, bottom = 0;
+	};
+
+	/// A linear color, 1 being paper white
+	struct Color
+	{
+		float r = 0, g = 0, b = 0, a = 1;
+	};
+
+	namespace Colors
+	{
+		constexpr auto White = Color{ 1, 1, 1, 1 };
+		constexpr auto DimGray = Color{ 0.411764741f, 0.411764741f, 0.411764741f, 1 };
+	}
+
+	/// Draws the frames of the experiment: both windows side by side in one HDR scene, cleared to black,
+	/// tone mapped to ST.2084 and presented. Implemented on D3D11 for the experiment and on the CPU to run it headless
+	class IRenderer
+	{
+	public:
+		virtual ~IRenderer() = default;
+
+		/// Creates a texture of a copy of `pixels`
+		[[nodiscard]] virtual std::shared_ptr<const ITexture> CreateTexture(ConstRgba16View pixels) = 0;
+
+		/// Creates a texture array of copies of `count` images of the same size, one per slice
+		[[nodiscard]] virtual std::shared_ptr<const ITexture> CreateTextureArray(const ConstRgba16View* slices, std::size_t count) = 0;
+
+		/// Starts a frame by clearing the scene
+		virtual void Begin() = 0;
+
+		/// Draws a slice of `texture` unscaled with its top left corner at `position`, mirrored if `flipHorizontally`
+		virtual void Draw(const ITexture& texture, Point position, bool flipHorizontally = false, int slice = 0) = 0;
+
+		virtual void Fill(const Rect& rectangle, Color color) = 0;
+
+		/// Tone maps the scene into the back buffer
+		virtual void End() = 0;
+
+		/// Presents the back buffer, waiting for the vertical blank where there is one
+		virtual void Present() = 0;
+	};
+}
@@ -0,0 +1,135 @@
+#include "Scene.h"
+
+namespace Experiment::Scene
+{
+	Screen ScreenAt(const bool started, const std::chrono::steady_clock::duration elapsed)
+	{
+		if (!started)
+		{
+			return Screen::Start;
+		}
+
+		const auto delta = Configuration::ImageTransitionDuration;
+
+		// a black screen for the duration of the transition between two trials
+		if (elapsed < delta)
+		{
+			return Screen::Transition;
+		}
+
+		// the response screen, once the stimuli have been visible for the whole timeout
+		if (elapsed > Configuration::ImageTimeoutDuration + delta)
+		{
+			return Screen::Response;
+		}
+
+		return Screen::Stimuli;
+	}
+
+	std::array<std::filesystem::path, 4> StimulusPaths(const Trial& trial)
+	{
+		const auto paths = trial.imagePaths(trial.mode);
+
+		return {
+			paths.leftCompressed,
+			paths.leftOriginal,
+			paths.rightCompressed,
+			paths.rightOriginal
+		};
+	}
+
+	std::pair<DuoView, DuoView> ComposeFlickerStereoViews(const Trial& trial, const std::shared_ptr<const ITexture>& stimuli)
+	{
+		if (stimuli->Slices() != 4)
+		{
+			Utils::FatalError("The stimuli of a trial are a texture array of 4 slices, not " + std::to_string(stimuli->Slices()));
+		}
+
+		const auto dims = Point{ 3840 * 2, 2160 };
+
+		const auto halfDist = static_cast<float>(Configuration::ImageDistance) / 2;
+		const auto yPos = dims.y / 2 - static_cast<float>(Configuration::ImageDimensions.y) / 2;
+
+		const auto ll = Point{ dims.x / 4 - halfDist - Configuration::ImageDimensions.x, yPos };
+		const auto lr = Point{ dims.x / 4 + halfDist, yPos };
+		const auto rl = Point{ dims.x * 3 / 4 - halfDist - Configuration::ImageDimensions.x, yPos };
+		const auto rr = Point{ dims.x * 3 / 4 + halfDist, yPos };
+
+		DuoView no_flicker = {
+			{Image{stimuli, ll, 1}, Image{stimuli, lr, 1} },
+			{Image{stimuli, rl, 3}, Image{stimuli, rr, 3} }
+		};
+
+		DuoView flicker = no_flicker;
+		const auto i = static_cast<int>(trial.correctOption) - 1;
+
+		flicker.left[i].slice = 0;
+		flicker.right[i].slice = 2;
+
+		return std::make_pair(no_flicker, flicker);
+	}
+
+	SingleView ComposeStaticStereoView(std::shared_ptr<const ITexture> left, std::shared_ptr<const ITexture> right)
+	{
+		return {
+			Image{ std::move(left), {0, 0} },
+			Image{ std::move(right), {3840, 0} }
+		};
+	}
+
+	void Draw(IRenderer& renderer, const DuoView& view)
+	{
+		for (auto i = 0; i < 2; i++)
+		{
+			for (auto j = 0; j < 2; j++)
+			{
+				renderer.Draw(*view[i][j].image, view[i][j].position, true, view[i][j].slice);
+			}
+		}
+	}
+
+	void Draw(IRenderer& renderer, const SingleView& view)
+	{
+		for (auto i = 0; i < 2; i++)
+		{
+			renderer.Draw(*view[i].image, view[i].position, false, view[i].slice);
+		}
+	}
+
+	void DrawProgressBar(IRenderer& renderer, const float progress)
+	{
+		constexpr int width = 1920, height = 24, bottom = 160;
+
+		for (auto i = 0; i < 2; i++)
+		{
+			const auto left = i * 3840 + (3840 - width) / 2;
+			const auto top = 2160 - bottom - height;
+
+			renderer.Fill({ left, top, left + width, top + height }, Colors::DimGray);
+			renderer.Fill({ left, top, left + static_cast<int>(width * progress), top + height }, Colors::White);
+		}
+	}
+
+	void Draw(IRenderer& renderer, const Screen screen, const StaticScreens& screens, const DuoView& stimuli, const float progress)
+	{
+		switch (screen)
+		{
+		case Screen::Start:
+			Draw(renderer, screens.start);
+			if (progress < 1.0f) DrawProgressBar(renderer, progress);
+			return;
+
+		case Screen::Transition:
+			Draw(renderer, screens.transition);
+			return;
+
+		case Screen::Response:
+			Draw(renderer, screens.response);
+			return;
+
+		case Screen::Stimuli:
+			Draw(renderer, stimuli);
+			return;
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <utility>
+#include "Participant.h"
+#include "Renderer.h"
+
+namespace Experiment
+{
+	struct Image
+	{
+		std::shared_ptr<const ITexture> image;
+		Point position;
+		int slice = 0;
+	};
+
+	using DuoView = Utils::Duo<Utils::Duo<Image>>;
+	using SingleView = Utils::Duo<Image>;
+
+	/// What a session shows, and how it is laid out and drawn, independent of the renderer
+	namespace Scene
+	{
+		enum class Screen
+		{
+			/// Before the session has started, with the preload progress
+			Start,
+			/// The black screen between two trials
+			Transition,
+			Stimuli,
+			/// Once the stimuli have timed out without a response
+			Response
+		};
+
+		/// The screens which are the same for every trial, loaded once before the first frame so that a frame never loads a texture
+		struct StaticScreens
+		{
+			SingleView start;
+			SingleView transition;
+			SingleView response;
+		};
+
+		/// The screen shown `elapsed` after the last response, or after the session started
+		[[nodiscard]] Screen ScreenAt(bool started, std::chrono::steady_clock::duration elapsed);
+
+		/// The compressed and original stimuli of each side of a trial, in that order
+		[[nodiscard]] std::array<std::filesystem::path, 4> StimulusPaths(const Trial& trial);
+
+		/// The flickering and the steady views of the stimuli of `trial`, given as one texture array with a slice per stimulus in
+		/// the order of StimulusPaths, so that all of them are drawn from one texture
+		[[nodiscard]] std::pair<DuoView, DuoView> ComposeFlickerStereoViews(const Trial& trial, const std::shared_ptr<const ITexture>& stimuli);
+
+		/// The views of a static screen, one image per window
+		[[nodiscard]] SingleView ComposeStaticStereoView(std::shared_ptr<const ITexture> left, std::shared_ptr<const ITexture> right);
+
+		/// Draws the stimuli of both windows, mirrored for the stereoscope
+		void Draw(IRenderer& renderer, const DuoView& view);
+		void Draw(IRenderer& renderer, const SingleView& view);
+
+		/// Draws the preload progress of the session at the bottom of both windows
+		void DrawProgressBar(IRenderer& renderer, float progress);
+
+		/// Draws a frame of `screen`: one of `screens`, with the preload `progress` on the start screen until it reaches 1, or `stimuli`.
+		/// Allocates nothing, so that the frames of a session never touch the heap
+		void Draw(IRenderer& renderer, Screen screen, const StaticScreens& screens, const DuoView& stimuli, float progress = 1.0f);
+	}
+}
@@ -0,0 +1,293 @@
+#include "SessionLog.h"
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace Experiment::SessionLog
+{
+	namespace
+	{
+		constexpr char Magic[4] = { 'P', 'P', 'M', 'L' };
+
+		// integers are written as LEB128 varints, signed ones zigzag encoded first, so that most take a byte or two
+
+		void WriteUnsigned(std::ostream& os, std::uint64_t value)
+		{
+			char bytes[10];
+			auto count = 0;
+
+			do
+			{
+				bytes[count] = static_cast<char>(value & 0x7F);
+				value >>= 7;
+				if (value != 0) bytes[count] |= static_cast<char>(0x80);
+				count++;
+			} while (value != 0);
+
+			os.write(bytes, count);
+		}
+
+		void WriteSigned(std::ostream& os, const std::int64_t value)
+		{
+			WriteUnsigned(os, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+		}
+
+		void WriteString(std::ostream& os, const std::string& value)
+		{
+			WriteUnsigned(os, value.size());
+			os.write(value.data(), static_cast<std::streamsize>(value.size()));
+		}
+
+		/// Reads the whole file at `path`, as far as it has been written, which a crash may have left within an entry
+		std::vector<std::uint8_t> ReadAll(const std::filesystem::path& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+			{
+				throw std::runtime_error(path.generic_string() + " cannot be opened");
+			}
+
+			return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+		}
+
+		/// Reads a log, throwing std::out_of_range when it runs out
+		class Reader
+		{
+		public:
+			explicit Reader(const std::vector<std::uint8_t>& data) : m_data(data) {}
+
+			[[nodiscard]] bool AtEnd() const { return m_position == m_data.size(); }
+
+			std::uint8_t Byte()
+			{
+				if (AtEnd()) throw std::out_of_range("the session log ends early");
+				return m_data[m_position++];
+			}
+
+			std::uint64_t Unsigned()
+			{
+				std::uint64_t value = 0;
+
+				for (auto shift = 0; shift < 64; shift += 7)
+				{
+					const auto byte = Byte();
+					value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+					if ((byte & 0x80) == 0) return value;
+				}
+
+				throw std::runtime_error("the session log has a malformed integer");
+			}
+
+			std::int64_t Signed()
+			{
+				const auto value = Unsigned();
+				return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+			}
+
+			int Int()
+			{
+				return static_cast<int>(Signed());
+			}
+
+			std::string String()
+			{
+				const auto size = Unsigned();
+				if (size > m_data.size() - m_position) throw std::out_of_range("the session log ends early");
+
+				std::string value(reinterpret_cast<const char*>(m_data.data() + m_position), size);
+				m_position += size;
+				return value;
+			}
+
+			template<typename E>
+			E Enum()
+			{
+				return static_cast<E>(Byte());
+			}
+
+		private:
+			const std::vector<std::uint8_t>& m_data;
+			std::size_t m_position = 0;
+		};
+
+		const char* ToString(const Entry::Kind kind)
+		{
+			switch (kind)
+			{
+			case Entry::Kind::Start: return "start";
+			case Entry::Kind::Response: return "response";
+			case Entry::Kind::Frame: return "frame";
+			case Entry::Kind::Load: return "load";
+			default: return "unknown";
+			}
+		}
+	}
+
+	std::ostream& operator<<(std::ostream& os, const Entry& e)
+	{
+		os << std::chrono::duration<double, std::milli>(e.time).count() << " ms: " << ToString(e.kind) << " " << e.value;
+		if (e.kind == Entry::Kind::Frame) os << " at " << e.elapsed.count() << " ms";
+		return os;
+	}
+
+	Session Read(const std::filesystem::path& path)
+	{
+		const auto data = ReadAll(path);
+		Reader reader(data);
+
+		Session session;
+
+		try
+		{
+			char magic[sizeof(Magic)];
+			for (auto& c : magic) c = static_cast<char>(reader.Byte());
+
+			if (std::memcmp(magic, Magic, sizeof(Magic)) != 0 || reader.Unsigned() != Version)
+			{
+				throw std::runtime_error(path.generic_string() + " is not a session log of version " + std::to_string(Version));
+			}
+
+			session.preloaded = reader.Byte() != 0;
+
+			auto& run = session.run;
+			run.session = reader.Int();
+			run.participant.groupNumber = reader.Int();
+			run.participant.id = reader.String();
+			run.participant.age = reader.Int();
+			run.participant.gender = reader.Enum<Gender>();
+
+			run.trials.resize(reader.Unsigned());
+
+			for (auto& trial : run.trials)
+			{
+				trial.originalDirectory = reader.String();
+				trial.decompressedDirectory = reader.String();
+				trial.imageName = reader.String();
+				trial.correctOption = reader.Enum<Option>();
+				trial.position.x = reader.Int();
+				trial.position.y = reader.Int();
+				trial.mode = reader.Enum<Mode>();
+				trial.compression.codec = reader.Enum<Codec>();
+				trial.compression.bypass = reader.Enum<Bypass>();
+				trial.compression.distortion = reader.Enum<Distortion>();
+				trial.compression.bpc = reader.Int();
+			}
+		}
+		catch (const std::out_of_range&)
+		{
+			throw std::runtime_error(path.generic_string() + " ends within its header");
+		}
+
+		std::int64_t time = 0;
+
+		while (!reader.AtEnd())
+		{
+			try
+			{
+				Entry entry;
+				entry.kind = reader.Enum<Entry::Kind>();
+
+				if (entry.kind > Entry::Kind::Load)
+				{
+					throw std::runtime_error(path.generic_string() + " has an entry of unknown kind " + std::to_string(static_cast<int>(entry.kind)));
+				}
+
+				time += static_cast<std::int64_t>(reader.Unsigned());
+				entry.time = std::chrono::microseconds(time);
+				entry.value = reader.Int();
+
+				if (entry.kind == Entry::Kind::Frame) entry.elapsed = std::chrono::milliseconds(reader.Signed());
+
+				session.entries.push_back(entry);
+			}
+			catch (const std::out_of_range&)
+			{
+				// the rest of an entry which was being written when the session ended
+				session.truncated = true;
+				break;
+			}
+		}
+
+		return session;
+	}
+
+	Recorder::Recorder(const std::filesystem::path& path, const Run& run, const bool preloaded, Now now) :
+		m_file(path, std::ios::binary),
+		m_now(std::move(now)),
+		m_opened(m_now())
+	{
+		if (!m_file)
+		{
+			throw std::runtime_error(path.generic_string() + " cannot be created");
+		}
+
+		m_file.write(Magic, sizeof(Magic));
+		WriteUnsigned(m_file, Version);
+		m_file.put(preloaded ? 1 : 0);
+
+		WriteSigned(m_file, run.session);
+		WriteSigned(m_file, run.participant.groupNumber);
+		WriteString(m_file, run.participant.id);
+		WriteSigned(m_file, run.participant.age);
+		m_file.put(static_cast<char>(run.participant.gender));
+
+		WriteUnsigned(m_file, run.trials.size());
+
+		for (const auto& trial : run.trials)
+		{
+			WriteString(m_file, trial.originalDirectory);
+			WriteString(m_file, trial.decompressedDirectory);
+			WriteString(m_file, trial.imageName);
+			m_file.put(static_cast<char>(trial.correctOption));
+			WriteSigned(m_file, trial.position.x);
+			WriteSigned(m_file, trial.position.y);
+			m_file.put(static_cast<char>(trial.mode));
+			m_file.put(static_cast<char>(trial.compression.codec));
+			m_file.put(static_cast<char>(trial.compression.bypass));
+			m_file.put(static_cast<char>(trial.compression.distortion));
+			WriteSigned(m_file, trial.compression.bpc);
+		}
+
+		m_file.flush();
+	}
+
+	void Recorder::Started()
+	{
+		Append(Entry::Kind::Start, 0);
+	}
+
+	void Recorder::Answered(const Option response)
+	{
+		Append(Entry::Kind::Response, static_cast<int>(response));
+	}
+
+	void Recorder::Presented(const Scene::Screen screen, const std::chrono::milliseconds elapsed)
+	{
+		Append(Entry::Kind::Frame, static_cast<int>(screen), elapsed);
+	}
+
+	void Recorder::Loaded(const int trial)
+	{
+		Append(Entry::Kind::Load, trial);
+
+		// once per trial, between frames
+		m_file.flush();
+	}
+
+	void Recorder::Append(const Entry::Kind kind, const int value, const std::chrono::milliseconds elapsed)
+	{
+		const auto time = std::chrono::duration_cast<std::chrono::microseconds>(m_now() - m_opened).count();
+
+		m_file.put(static_cast<char>(kind));
+		WriteUnsigned(m_file, static_cast<std::uint64_t>(time - m_last));
+		WriteSigned(m_file, value);
+
+		if (kind == Entry::Kind::Frame) WriteSigned(m_file, elapsed.count());
+
+		m_last = time;
+		m_entries++;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+#include "Participant.h"
+#include "Scene.h"
+
+namespace Experiment::SessionLog
+{
+	/// A session log is a compact binary record of what drives a session: its Run, the inputs of the participant, and the
+	/// stopwatch reading each frame was chosen on, along with what was decided on them: the screen of each frame and the trials
+	/// loaded. Replaying it headless (`benchmark replay`) takes the same decisions, so that a session which was slow in the
+	/// field can be rerun under a profiler, and recorded sessions make a corpus for performance regression runs
+	using Clock = std::chrono::steady_clock;
+
+	/// Logs written by another version are not read
+	constexpr std::uint32_t Version = 1;
+
+	struct Entry
+	{
+		enum class Kind : std::uint8_t
+		{
+			/// The participant started the session
+			Start,
+			/// The participant answered the current trial with `value`, an Option
+			Response,
+			/// A frame of `value`, a Scene::Screen, chosen on the stopwatch reading `elapsed`
+			Frame,
+			/// The stimuli of trial `value` were loaded
+			Load
+		};
+
+		Kind kind = Kind::Frame;
+
+		/// Since the log was opened, to the microsecond
+		Clock::duration time = {};
+
+		int value = 0;
+		std::chrono::milliseconds elapsed = {};
+	};
+
+	std::ostream& operator<<(std::ostream& os, const Entry& e);
+
+	struct Session
+	{
+		Run run;
+
+		/// Whether the stimuli were preloaded, or streamed per trial as they did not fit in memory
+		bool preloaded = false;
+
+		std::vector<Entry> entries;
+
+		/// Whether the log ends within an entry, as that of a session which crashed may
+		bool truncated = false;
+	};
+
+	/// Reads the log at `path`, throwing std::runtime_error if it is not a session log of this Version
+	Session Read(const std::filesystem::path& path);
+
+	/// Writes the log of a session as it goes, on the thread which runs the session. Entries are buffered, so that frames do not
+	/// touch the heap or, mostly, the disk, and written at each load and when the recorder is destroyed: a session which
+	/// crashes loses at most its current trial
+	class Recorder
+	{
+	public:
+		using Now = std::function<Clock::time_point()>;
+
+		/// Writes the header, with `run` as it will be run; throws std::runtime_error if `path` cannot be created. Entries are
+		/// timed by `now`, which a simulated session replaces
+		Recorder(const std::filesystem::path& path, const Run& run, bool preloaded, Now now = Clock::now);
+
+		Recorder(const Recorder&) = delete;
+		Recorder& operator=(const Recorder&) = delete;
+
+		void Started();
+		void Answered(Option response);
+		void Presented(Scene::Screen screen, std::chrono::milliseconds elapsed);
+		void Loaded(int trial);
+
+		[[nodiscard]] std::size_t Entries() const { return m_entries; }
+
+	private:
+		void Append(Entry::Kind kind, int value, std::chrono::milliseconds elapsed = {});
+
+		std::ofstream m_file;
+
+		Now m_now;
+		Clock::time_point m_opened;
+
+		/// The time of the last entry, which the next is written relative to, in microseconds since the log was opened
+		std::int64_t m_last = 0;
+
+		std::size_t m_entries = 0;
+	};
+}
@@ -0,0 +1,82 @@
+#include "SpriteBatcher.h"
+#include <ostream>
+
+namespace Experiment
+{
+	SpriteBatcher::SpriteBatcher(ISpriteDevice& device) : m_device(device)
+	{
+		m_queue.reserve(MaxInstances);
+	}
+
+	void SpriteBatcher::Draw(const void* texture, const ISpriteDevice::Instance& instance)
+	{
+		if (texture != m_queuedTexture || m_queue.size() == MaxInstances)
+		{
+			Flush();
+		}
+
+		m_queuedTexture = texture;
+		m_queue.push_back(instance);
+
+		m_statistics.sprites++;
+	}
+
+	void SpriteBatcher::Draw(const void* texture, const Point position, const int width, const int height, const bool flipHorizontally, const int slice)
+	{
+		ISpriteDevice::Instance instance;
+		instance.rectangle[0] = position.x;
+		instance.rectangle[1] = position.y;
+		instance.rectangle[2] = static_cast<float>(width);
+		instance.rectangle[3] = static_cast<float>(height);
+		instance.slice = static_cast<std::uint32_t>(slice);
+		instance.flip = flipHorizontally ? 1 : 0;
+
+		Draw(texture, instance);
+	}
+
+	void SpriteBatcher::Fill(const void* texture, const Rect& rectangle, const Color color)
+	{
+		ISpriteDevice::Instance instance;
+		instance.rectangle[0] = static_cast<float>(rectangle.left);
+		instance.rectangle[1] = static_cast<float>(rectangle.top);
+		instance.rectangle[2] = static_cast<float>(rectangle.right - rectangle.left);
+		instance.rectangle[3] = static_cast<float>(rectangle.bottom - rectangle.top);
+		instance.color[0] = color.r;
+		instance.color[1] = color.g;
+		instance.color[2] = color.b;
+		instance.color[3] = color.a;
+
+		Draw(texture, instance);
+	}
+
+	void SpriteBatcher::Flush()
+	{
+		if (m_queue.empty())
+		{
+			return;
+		}
+
+		if (m_queuedTexture != m_boundTexture)
+		{
+			m_device.Bind(m_queuedTexture);
+			m_boundTexture = m_queuedTexture;
+			m_statistics.binds++;
+		}
+
+		m_device.Draw(m_queue.data(), m_queue.size());
+		m_statistics.draws++;
+
+		m_queue.clear();
+	}
+
+	void SpriteBatcher::Invalidate()
+	{
+		m_boundTexture = nullptr;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const SpriteBatcher::Statistics& s)
+	{
+		os << "sprites: " << s.sprites << ", draws: " << s.draws << ", binds: " << s.binds;
+		return os;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "Renderer.h"
+
+namespace Experiment
+{
+	/// The GPU operations the sprite batcher is built on, so that its draws and binds can be counted on a mock device without a GPU.
+	/// Textures are texture arrays of the device, passed through opaquely
+	class ISpriteDevice
+	{
+	public:
+		/// A quad of the scene, as the vertex shader reads it per instance
+		struct Instance
+		{
+			/// Left, top, width and height in pixels
+			float rectangle[4] = {};
+
+			/// Multiplies the texels
+			float color[4] = { 1, 1, 1, 1 };
+
+			std::uint32_t slice = 0;
+			std::uint32_t flip = 0;
+			std::uint32_t padding[2] = {};
+		};
+
+		virtual ~ISpriteDevice() = default;
+
+		/// Binds `texture` for the draws that follow
+		virtual void Bind(const void* texture) = 0;
+
+		/// Draws `count` instanced quads textured from the bound texture
+		virtual void Draw(const Instance* instances, std::size_t count) = 0;
+	};
+
+	/// Batches the sprites of a frame into as few instanced draws as their order allows: consecutive sprites of one texture are a
+	/// single draw, and a texture is only bound when it changes. With the stimuli of a trial in one texture array, the stimuli of
+	/// a frame are one bind and one draw. Not thread safe; used by the render thread
+	class SpriteBatcher
+	{
+	public:
+		/// The instances of a draw, as many as the constant buffer of the device holds
+		static constexpr std::size_t MaxInstances = 64;
+
+		struct Statistics
+		{
+			std::size_t sprites = 0;
+			std::size_t draws = 0;
+			std::size_t binds = 0;
+		};
+
+		explicit SpriteBatcher(ISpriteDevice& device);
+
+		/// Queues a sprite of `texture`, drawing the sprites queued so far first if they are of another texture
+		void Draw(const void* texture, const ISpriteDevice::Instance& instance);
+
+		/// Queues a slice of `texture`, `width` by `height`, unscaled with its top left corner at `position`
+		void Draw(const void* texture, Point position, int width, int height, bool flipHorizontally, int slice);
+
+		/// Queues `rectangle` filled with `color` times the texel of a single texel `texture`
+		void Fill(const void* texture, const Rect& rectangle, Color color);
+
+		/// Draws the queued sprites
+		void Flush();
+
+		/// Forgets which texture is bound, once something else may have bound another
+		void Invalidate();
+
+		[[nodiscard]] Statistics GetStatistics() const { return m_statistics; }
+
+	private:
+		ISpriteDevice& m_device;
+
+		const void* m_queuedTexture = nullptr;
+		const void* m_boundTexture = nullptr;
+
+		std::vector<ISpriteDevice::Instance> m_queue;
+
+		Statistics m_statistics;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const SpriteBatcher::Statistics& s);
+}
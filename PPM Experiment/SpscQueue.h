@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Experiment
+{
+	/// A bounded lock-free queue between one producer thread and one consumer thread. Neither side ever waits on the other:
+	/// TryPush fails when the queue is full and TryPop when it is empty. The capacity is rounded up to a power of two
+	template <typename T>
+	class SpscQueue
+	{
+	public:
+		explicit SpscQueue(const std::size_t capacity) : m_slots(RoundUp(capacity)), m_mask(m_slots.size() - 1)
+		{
+		}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		/// Called by the producer only
+		bool TryPush(const T& value)
+		{
+			const auto tail = m_tail.load(std::memory_order_relaxed);
+
+			// the consumer's position is only reloaded when the cached one says the queue is full
+			if (tail - m_cachedHead == m_slots.size())
+			{
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				if (tail - m_cachedHead == m_slots.size()) return false;
+			}
+
+			m_slots[tail & m_mask] = value;
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/// Called by the consumer only
+		bool TryPop(T& value)
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+
+			if (head == m_cachedTail)
+			{
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				if (head == m_cachedTail) return false;
+			}
+
+			value = m_slots[head & m_mask];
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/// The number of queued values, exact only on the consumer while the producer is idle
+		[[nodiscard]] std::size_t Size() const
+		{
+			// the head is read first, so that the tail read after it is never behind it
+			const auto head = m_head.load(std::memory_order_acquire);
+			return m_tail.load(std::memory_order_acquire) - head;
+		}
+
+		[[nodiscard]] std::size_t Capacity() const { return m_slots.size(); }
+
+	private:
+		static std::size_t RoundUp(const std::size_t capacity)
+		{
+			std::size_t size = 1;
+			while (size < capacity) size <<= 1;
+			return size;
+		}
+
+		std::vector<T> m_slots;
+		const std::size_t m_mask;
+
+		// the positions grow without wrapping, and each side keeps its own cache line
+		alignas(64) std::atomic<std::size_t> m_head{ 0 };
+		std::size_t m_cachedTail = 0;
+
+		alignas(64) std::atomic<std::size_t> m_tail{ 0 };
+		std::size_t m_cachedHead = 0;
+	};
+}
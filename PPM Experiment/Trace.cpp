@@ -0,0 +1,378 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Experiment
+{
+	std::atomic<bool> Trace::s_enabled{ false };
+
+	namespace
+	{
+		struct Event
+		{
+			Trace::Phase phase;
+			const char* category;
+			const char* name;
+			std::int64_t start;
+			std::int64_t duration;
+		};
+
+		/// An event in a ring, whose fields are atomic because the writer of the trace may read a slot while it is overwritten
+		struct Slot
+		{
+			std::atomic<Trace::Phase> phase;
+			std::atomic<const char*> category;
+			std::atomic<const char*> name;
+			std::atomic<std::int64_t> start;
+			std::atomic<std::int64_t> duration;
+		};
+
+		/// The events of one thread, in a ring which only the thread writes. Like a sequence lock, `reserved` announces the
+		/// event being written before its slot is overwritten, and `count` publishes it once written, so that the writer of the
+		/// trace can tell the slots it read intact from those overwritten meanwhile
+		struct ThreadBuffer
+		{
+			ThreadBuffer(const std::size_t capacity, const std::size_t id) : slots(new Slot[capacity]), capacity(capacity), id(id) {}
+
+			std::unique_ptr<Slot[]> slots;
+			const std::size_t capacity;
+			const std::size_t id;
+
+			/// The slot of the next event, only touched by the thread
+			std::size_t next = 0;
+
+			std::atomic<std::size_t> reserved{ 0 };
+			std::atomic<std::size_t> count{ 0 };
+			std::atomic<std::size_t> dropped{ 0 };
+
+			std::atomic<const char*> openCategory{ nullptr };
+			std::atomic<const char*> openName{ nullptr };
+
+			/// Guarded by the registry
+			std::string name;
+
+			/// The events of the last `capacity` which were not overwritten while being read, oldest first
+			std::vector<Event> Read() const
+			{
+				const auto end = count.load(std::memory_order_acquire);
+				const auto begin = end > capacity ? end - capacity : 0;
+
+				std::vector<Event> events;
+				events.reserve(end - begin);
+
+				for (auto i = begin; i < end; i++)
+				{
+					const auto& slot = slots[i % capacity];
+					events.push_back({
+						slot.phase.load(std::memory_order_relaxed),
+						slot.category.load(std::memory_order_relaxed),
+						slot.name.load(std::memory_order_relaxed),
+						slot.start.load(std::memory_order_relaxed),
+						slot.duration.load(std::memory_order_relaxed) });
+				}
+
+				// event i was intact if event i + capacity, which overwrites it, had not been reserved once it was read
+				std::atomic_thread_fence(std::memory_order_acquire);
+				const auto overwritten = reserved.load(std::memory_order_relaxed);
+				if (overwritten > begin + capacity)
+				{
+					events.erase(events.begin(), events.begin() + std::min(events.size(), overwritten - capacity - begin));
+				}
+
+				return events;
+			}
+		};
+
+		/// Every buffer ever created, kept after its thread exits so that its events are still written
+		struct Registry
+		{
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+			std::size_t capacity = 0;
+		};
+
+		Registry& GetRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		thread_local ThreadBuffer* t_buffer = nullptr;
+
+		const auto g_epoch = std::chrono::steady_clock::now();
+
+		std::filesystem::path g_exitPath;
+
+		/// The buffer of the calling thread, created on its first event
+		ThreadBuffer& GetBuffer()
+		{
+			if (!t_buffer)
+			{
+				auto& registry = GetRegistry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+
+				registry.buffers.push_back(std::make_unique<ThreadBuffer>(registry.capacity, registry.buffers.size() + 1));
+				t_buffer = registry.buffers.back().get();
+			}
+
+			return *t_buffer;
+		}
+
+		void WriteString(std::ostream& os, const char* s)
+		{
+			os << '"';
+			for (; *s; s++)
+			{
+				if (*s == '"' || *s == '\\') os << '\\';
+				os << *s;
+			}
+			os << '"';
+		}
+	}
+
+	void Trace::Enable(const std::size_t eventsPerThread)
+	{
+		{
+			auto& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.capacity = eventsPerThread;
+		}
+
+		s_enabled.store(true, std::memory_order_release);
+	}
+
+	void Trace::Disable()
+	{
+		s_enabled.store(false, std::memory_order_release);
+	}
+
+	std::int64_t Trace::Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+	}
+
+	void Trace::Record(const Phase phase, const char* category, const char* name, const std::int64_t start, const std::int64_t duration)
+	{
+		auto& buffer = GetBuffer();
+
+		// a thread which recorded before tracing was first enabled has no room
+		if (buffer.capacity == 0)
+		{
+			buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		const auto index = buffer.count.load(std::memory_order_relaxed);
+		if (index >= buffer.capacity)
+		{
+			buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		buffer.reserved.store(index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		auto& slot = buffer.slots[buffer.next];
+		slot.phase.store(phase, std::memory_order_relaxed);
+		slot.category.store(category, std::memory_order_relaxed);
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.duration.store(duration, std::memory_order_relaxed);
+
+		buffer.next = buffer.next + 1 == buffer.capacity ? 0 : buffer.next + 1;
+		buffer.count.store(index + 1, std::memory_order_release);
+	}
+
+	std::int64_t Trace::Open(const char* category, const char* name, OpenScope& outer)
+	{
+		auto& buffer = GetBuffer();
+
+		outer = { buffer.openCategory.load(std::memory_order_relaxed), buffer.openName.load(std::memory_order_relaxed) };
+		buffer.openCategory.store(category, std::memory_order_relaxed);
+		buffer.openName.store(name, std::memory_order_relaxed);
+
+		return Now();
+	}
+
+	void Trace::Close(const char* category, const char* name, const std::int64_t start, const OpenScope& outer)
+	{
+		Record(Phase::Complete, category, name, start, Now() - start);
+
+		auto& buffer = GetBuffer();
+		buffer.openCategory.store(outer.category, std::memory_order_relaxed);
+		buffer.openName.store(outer.name, std::memory_order_relaxed);
+	}
+
+	void Trace::SetThreadName(const char* name)
+	{
+		if (!IsEnabled()) return;
+
+		auto& buffer = GetBuffer();
+
+		std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+		buffer.name = name;
+	}
+
+	void Trace::Begin(const char* category, const char* name)
+	{
+		if (IsEnabled()) Record(Phase::Begin, category, name, Now());
+	}
+
+	void Trace::End()
+	{
+		// an end without its begin, because tracing was enabled in between, is ignored by the viewers
+		if (IsEnabled()) Record(Phase::End, "", "", Now());
+	}
+
+	void Trace::Instant(const char* category, const char* name)
+	{
+		if (IsEnabled()) Record(Phase::Instant, category, name, Now());
+	}
+
+	void Trace::Write(std::ostream& os)
+	{
+		Write(os, std::chrono::nanoseconds::max());
+	}
+
+	void Trace::Write(std::ostream& os, const std::chrono::nanoseconds window, const std::vector<std::pair<std::string, std::string>>& metadata)
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		const auto since = Now() - window.count();
+
+		// timestamps are in microseconds, with nanoseconds as fractions
+		const auto microseconds = [&](const std::int64_t ns) { os << ns / 1000 << '.' << static_cast<char>('0' + ns / 100 % 10) << static_cast<char>('0' + ns / 10 % 10) << static_cast<char>('0' + ns % 10); };
+
+		os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		auto first = true;
+		const auto separate = [&] { os << (first ? "" : ",\n"); first = false; };
+
+		for (const auto& buffer : registry.buffers)
+		{
+			if (!buffer->name.empty())
+			{
+				separate();
+				os << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+				WriteString(os, buffer->name.c_str());
+				os << "}}";
+			}
+
+			for (const auto& event : buffer->Read())
+			{
+				if (event.start + event.duration < since) continue;
+
+				static constexpr const char* phases[] = { "X", "B", "E", "i\",\"s\":\"t" };
+
+				separate();
+				os << "{\"ph\":\"" << phases[static_cast<int>(event.phase)] << "\",\"pid\":1,\"tid\":" << buffer->id << ",\"cat\":";
+				WriteString(os, event.category);
+				os << ",\"name\":";
+				WriteString(os, event.name);
+				os << ",\"ts\":";
+				microseconds(event.start);
+
+				if (event.phase == Phase::Complete)
+				{
+					os << ",\"dur\":";
+					microseconds(event.duration);
+				}
+
+				os << "}";
+			}
+		}
+
+		os << "\n]";
+
+		if (!metadata.empty())
+		{
+			os << ",\"otherData\":{";
+			for (std::size_t i = 0; i < metadata.size(); i++)
+			{
+				os << (i ? "," : "");
+				WriteString(os, metadata[i].first.c_str());
+				os << ":";
+				WriteString(os, metadata[i].second.c_str());
+			}
+			os << "}";
+		}
+
+		os << "}\n";
+	}
+
+	void Trace::Write(const std::filesystem::path& path)
+	{
+		std::filesystem::create_directories(path.parent_path());
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file) throw std::runtime_error("Trace: cannot write " + path.generic_string());
+
+		Write(file);
+	}
+
+	void Trace::WriteAtExit(const std::filesystem::path& path)
+	{
+		if (g_exitPath.empty())
+		{
+			std::atexit([]
+				{
+					// nothing may throw out of an exit handler, and a lost trace must not fail the session
+					try
+					{
+						Write(g_exitPath);
+					}
+					catch (...)
+					{
+					}
+				});
+		}
+
+		g_exitPath = path;
+	}
+
+	Trace::Statistics Trace::GetStatistics()
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		Statistics s;
+		s.threads = registry.buffers.size();
+
+		for (const auto& buffer : registry.buffers)
+		{
+			s.events += std::min(buffer->count.load(std::memory_order_acquire), buffer->capacity);
+			s.dropped += buffer->dropped.load(std::memory_order_relaxed);
+		}
+
+		return s;
+	}
+
+	std::size_t Trace::CurrentThread()
+	{
+		return GetBuffer().id;
+	}
+
+	Trace::OpenScope Trace::GetOpenScope(const std::size_t thread)
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		if (thread == 0 || thread > registry.buffers.size()) return {};
+
+		const auto& buffer = *registry.buffers[thread - 1];
+		return { buffer.openCategory.load(std::memory_order_relaxed), buffer.openName.load(std::memory_order_relaxed) };
+	}
+
+	std::ostream& operator<<(std::ostream& os, const Trace::Statistics& s)
+	{
+		os << "threads: " << s.threads << ", events: " << s.events << ", dropped: " << s.dropped;
+		return os;
+	}
+}
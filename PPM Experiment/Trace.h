@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Traces are compiled in unless EXPERIMENT_TRACE is defined to 0, and then recorded only once Trace::Enable is called
+#ifndef EXPERIMENT_TRACE
+#define EXPERIMENT_TRACE 1
+#endif
+
+#define TRACE_CONCATENATE_(a, b) a##b
+#define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_(a, b)
+
+#if EXPERIMENT_TRACE
+/// Records the time from here to the end of the enclosing scope. `category` and `name` must be string literals
+#define TRACE_SCOPE(category, name) const ::Experiment::Trace::Scope TRACE_CONCATENATE(trace_scope_, __LINE__)(category, name)
+/// Records a region which begins and ends in different scopes of one thread, like the PIX events of a frame
+#define TRACE_BEGIN(category, name) ::Experiment::Trace::Begin(category, name)
+#define TRACE_END() ::Experiment::Trace::End()
+/// Records a point in time, like an input event
+#define TRACE_INSTANT(category, name) ::Experiment::Trace::Instant(category, name)
+/// Names the calling thread in the trace
+#define TRACE_THREAD(name) ::Experiment::Trace::SetThreadName(name)
+#else
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_BEGIN(category, name) ((void)0)
+#define TRACE_END() ((void)0)
+#define TRACE_INSTANT(category, name) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#endif
+
+namespace Experiment
+{
+	/// CPU timelines of the experiment, written as a Chrome trace (JSON) which chrome://tracing and the Perfetto UI open.
+	/// Each thread records into a fixed ring of its own, allocated on its first event, without locks, and the rings are only
+	/// read when the trace is written; once a ring is full, each event overwrites the oldest, which is counted as dropped, so
+	/// that a trace always holds the latest events. While disabled, a scope costs a relaxed load
+	class Trace
+	{
+	public:
+		/// The phases of the Chrome trace format
+		enum class Phase : std::uint8_t
+		{
+			Complete, Begin, End, Instant
+		};
+
+		struct Statistics
+		{
+			std::size_t threads = 0;
+			std::size_t events = 0;
+			std::size_t dropped = 0;
+		};
+
+		/// The innermost scope open on a thread, such as the stage a stalled thread is stuck in
+		struct OpenScope
+		{
+			const char* category = nullptr;
+			const char* name = nullptr;
+		};
+
+		/// Starts recording, with room for `eventsPerThread` events in each thread's buffer
+		static void Enable(std::size_t eventsPerThread = std::size_t(1) << 16);
+		static void Disable();
+
+		[[nodiscard]] static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+		static void SetThreadName(const char* name);
+		static void Begin(const char* category, const char* name);
+		static void End();
+		static void Instant(const char* category, const char* name);
+
+		/// Writes the events recorded so far, while threads may still be recording
+		static void Write(std::ostream& os);
+
+		/// Writes the events which ended in the last `window` only, with `metadata` as the string members of the otherData object
+		static void Write(std::ostream& os, std::chrono::nanoseconds window, const std::vector<std::pair<std::string, std::string>>& metadata = {});
+		static void Write(const std::filesystem::path& path);
+
+		/// Writes the trace to `path` when the process exits, which the apps do through exit() from any thread
+		static void WriteAtExit(const std::filesystem::path& path);
+
+		[[nodiscard]] static Statistics GetStatistics();
+
+		/// Identifies the calling thread, for GetOpenScope on other threads
+		[[nodiscard]] static std::size_t CurrentThread();
+
+		/// Read while `thread` runs, so the category and name may be of consecutive scopes, unless the thread is stuck in one
+		[[nodiscard]] static OpenScope GetOpenScope(std::size_t thread);
+
+		class Scope
+		{
+		public:
+			Scope(const char* category, const char* name) : m_category(category), m_name(name), m_start(IsEnabled() ? Open(category, name, m_outer) : -1)
+			{
+			}
+
+			~Scope()
+			{
+				if (m_start >= 0) Close(m_category, m_name, m_start, m_outer);
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			const char* m_category;
+			const char* m_name;
+			OpenScope m_outer;
+			std::int64_t m_start;
+		};
+
+	private:
+		/// Nanoseconds since the process started
+		static std::int64_t Now();
+
+		/// Makes a scope the open scope of the calling thread, keeping the scope it is nested in, and returns its start
+		static std::int64_t Open(const char* category, const char* name, OpenScope& outer);
+		static void Close(const char* category, const char* name, std::int64_t start, const OpenScope& outer);
+
+		static void Record(Phase phase, const char* category, const char* name, std::int64_t start, std::int64_t duration = 0);
+
+		static std::atomic<bool> s_enabled;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const Trace::Statistics& s);
+}
@@ -0,0 +1,51 @@
+#include "TrialMonitor.h"
+
+namespace Experiment
+{
+	TrialMonitor::TrialMonitor(const Clock::duration period, const Clock::duration transition) :
+		m_period(period),
+		m_transition(transition)
+	{
+	}
+
+	void TrialMonitor::Presented(const Scene::Screen screen, const Clock::time_point now)
+	{
+		if (screen == Scene::Screen::Transition && m_last != Scene::Screen::Transition)
+		{
+			m_transitionStart = now;
+
+			m_transitionLength = {};
+			m_flickerFrames = 0;
+			m_missedDeadlines = 0;
+		}
+
+		if (screen == Scene::Screen::Stimuli)
+		{
+			if (m_last == Scene::Screen::Transition)
+			{
+				m_transitionLength = now - m_transitionStart;
+			}
+
+			if (m_flickerFrames == 0)
+			{
+				m_flickerStart = now;
+			}
+
+			// frame n is due n periods after the first, however late the frames before it were, so that a timer which waits a
+			// period from the end of each frame, and so drifts by the time each frame takes, is not measured against itself
+			const auto due = m_flickerStart + m_period * m_flickerFrames;
+
+			m_flickerFrames++;
+			m_missedDeadlines += now > due + m_period / 2 ? 1 : 0;
+		}
+
+		m_last = screen;
+	}
+
+	void TrialMonitor::Record(TrialPerformance& performance) const
+	{
+		performance.transitionMilliseconds = std::chrono::duration<double, std::milli>(m_transitionLength).count();
+		performance.flickerFrames = m_flickerFrames;
+		performance.missedDeadlines = m_missedDeadlines;
+	}
+}
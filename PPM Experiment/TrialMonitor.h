@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include "Participant.h"
+#include "Scene.h"
+
+namespace Experiment
+{
+	/// Measures the frames of the trial being shown from when they are presented: how long its black transition lasted, how many
+	/// flicker frames were shown, and how many of them came more than half a period after they were due. The flicker is due on
+	/// a fixed schedule from its first frame, so a timer which drifts counts as missing once it is half a period behind.
+	/// A trial starts with its first transition frame. Costs a few comparisons per frame
+	class TrialMonitor
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		/// `period` is the time between flicker frames, and `transition` the time the black screen is meant to last
+		TrialMonitor(Clock::duration period, Clock::duration transition);
+
+		/// Counts a frame of `screen` presented at `now`
+		void Presented(Scene::Screen screen, Clock::time_point now);
+
+		/// Writes the transition, flicker frames and missed deadlines of the current trial to `performance`
+		void Record(TrialPerformance& performance) const;
+
+	private:
+		Clock::duration m_period;
+		Clock::duration m_transition;
+
+		Scene::Screen m_last = Scene::Screen::Start;
+
+		Clock::time_point m_transitionStart;
+
+		/// When the first flicker frame of the trial was presented, from which every other one is due a period after the last
+		Clock::time_point m_flickerStart;
+
+		Clock::duration m_transitionLength = {};
+		int m_flickerFrames = 0;
+		int m_missedDeadlines = 0;
+	};
+}
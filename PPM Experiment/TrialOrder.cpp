@@ -0,0 +1,286 @@
+#include "TrialOrder.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+
+namespace Experiment::TrialOrder
+{
+	/// A 4K, 16-bit RGB PPM as stored on disk
+	constexpr std::uintmax_t FrameBytes = 3840ull * 2160ull * 3ull * 2ull;
+
+	/// The most recently used decoded frames, most recent last
+	class LruSimulation
+	{
+	public:
+		explicit LruSimulation(const std::size_t capacity) : capacity_(capacity)
+		{
+		}
+
+		[[nodiscard]] bool Contains(const std::string& key) const
+		{
+			return std::find(frames_.begin(), frames_.end(), key) != frames_.end();
+		}
+
+		/// Marks `key` as used and returns true if it had to be decoded
+		bool Touch(const std::string& key)
+		{
+			const auto it = std::find(frames_.begin(), frames_.end(), key);
+			const auto miss = it == frames_.end();
+
+			if (!miss)
+			{
+				frames_.erase(it);
+			}
+			else if (capacity_ > 0 && frames_.size() >= capacity_)
+			{
+				frames_.erase(frames_.begin());
+			}
+
+			if (capacity_ > 0)
+			{
+				frames_.push_back(key);
+			}
+
+			return miss;
+		}
+
+	private:
+		std::size_t capacity_;
+		std::vector<std::string> frames_;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const Report& r)
+	{
+		os << "Trials: " << r.trials
+			<< ", decodes: " << r.decodesBefore << " -> " << r.decodesInOrder << " (cached) -> " << r.decodesAfter << " (reordered)"
+			<< ", MB read: " << r.bytesBefore / (1024 * 1024) << " -> " << r.bytesAfter / (1024 * 1024)
+			<< ", saved: " << static_cast<int>(r.Savings() * 100.0 + 0.5) << "%"
+			<< ", over the same side limit: " << r.sideRunViolations;
+
+		return os;
+	}
+
+	/// 32-bit FNV-1a, which unlike std::hash gives every standard library the same seed for a participant
+	static std::uint32_t Hash(const std::string& s)
+	{
+		std::uint32_t hash = 2166136261u;
+		for (const auto c : s)
+		{
+			hash ^= static_cast<std::uint8_t>(c);
+			hash *= 16777619u;
+		}
+
+		return hash;
+	}
+
+	/// Fisher-Yates over the raw output of `random`, which the standard fixes, rather than std::shuffle and the distributions,
+	/// which it does not, so that a seed yields the same order whichever compiler built the experiment
+	template<typename T>
+	static void Shuffle(std::vector<T>& values, std::mt19937& random)
+	{
+		for (auto i = values.size(); i > 1; i--)
+		{
+			// draws beyond the largest multiple of `i` are rejected, so that every position is equally likely
+			const auto range = static_cast<std::uint64_t>(std::mt19937::max()) + 1;
+			const auto limit = range - range % i;
+
+			std::uint64_t draw;
+			do
+			{
+				draw = random();
+			} while (draw >= limit);
+
+			std::swap(values[i - 1], values[static_cast<std::size_t>(draw % i)]);
+		}
+	}
+
+	std::vector<std::string> FileKeys(const Trial& trial)
+	{
+		const auto original = trial.originalDirectory + "|" + trial.imageName;
+		const auto compressed = trial.decompressedDirectory + "|" + trial.imageName;
+
+		switch (trial.mode)
+		{
+		case Mode::Mono_Left: return { original + "_L", compressed + "_L" };
+		case Mode::Mono_Right: return { original + "_R", compressed + "_R" };
+		default: return { original + "_L", original + "_R", compressed + "_L", compressed + "_R" };
+		}
+	}
+
+	std::vector<std::size_t> Optimize(const std::vector<Trial>& trials, const Constraints& constraints)
+	{
+		std::mt19937 random(constraints.seed);
+
+		// group trials by original image, then by decompressed image, so that trials sharing
+		// an original and trials cropping different positions of one frame end up together
+		std::map<std::string, std::map<std::string, std::vector<std::size_t>>> groups;
+		for (std::size_t i = 0; i < trials.size(); i++)
+		{
+			const auto& trial = trials[i];
+			groups[trial.originalDirectory + "|" + trial.imageName][trial.decompressedDirectory].push_back(i);
+		}
+
+		// randomize the order of the groups, the subgroups and the positions within each subgroup
+		std::vector<std::vector<std::vector<std::size_t>>> shuffled;
+		for (auto& [original, subgroups] : groups)
+		{
+			std::vector<std::vector<std::size_t>> group;
+			for (auto& [decompressed, members] : subgroups)
+			{
+				Shuffle(members, random);
+				group.push_back(members);
+			}
+
+			Shuffle(group, random);
+			shuffled.push_back(group);
+		}
+
+		Shuffle(shuffled, random);
+
+		std::vector<std::size_t> remaining;
+		remaining.reserve(trials.size());
+		for (const auto& group : shuffled)
+		{
+			for (const auto& subgroup : group)
+			{
+				remaining.insert(remaining.end(), subgroup.begin(), subgroup.end());
+			}
+		}
+
+		// greedily pick the candidate with the most resident frames that does not break counterbalancing
+		LruSimulation cache(constraints.cacheFrames);
+		std::vector<std::size_t> order;
+		order.reserve(trials.size());
+
+		auto lastSide = Option::None;
+		auto sideRun = 0;
+
+		const auto violates = [&](const std::size_t candidate)
+		{
+			return trials[candidate].correctOption == lastSide && sideRun >= constraints.maxSameSideRun;
+		};
+
+		while (!remaining.empty())
+		{
+			const auto window = std::min(remaining.size(), std::max<std::size_t>(constraints.lookahead, 1));
+
+			auto best = remaining.size();
+			auto bestHits = -1;
+
+			for (std::size_t j = 0; j < window; j++)
+			{
+				if (violates(remaining[j])) continue;
+
+				auto hits = 0;
+				for (const auto& key : FileKeys(trials[remaining[j]]))
+				{
+					if (cache.Contains(key)) hits++;
+				}
+
+				if (hits > bestHits)
+				{
+					best = j;
+					bestHits = hits;
+				}
+			}
+
+			// nothing in the window satisfies the constraint; fall back to the first candidate which does, if any, or else break
+			// it, which the report counts
+			if (best == remaining.size())
+			{
+				const auto valid = std::find_if_not(remaining.begin(), remaining.end(), violates);
+				best = valid == remaining.end() ? 0 : static_cast<std::size_t>(valid - remaining.begin());
+			}
+
+			const auto chosen = remaining[best];
+			remaining.erase(remaining.begin() + best);
+			order.push_back(chosen);
+
+			for (const auto& key : FileKeys(trials[chosen]))
+			{
+				cache.Touch(key);
+			}
+
+			const auto side = trials[chosen].correctOption;
+			sideRun = (side == lastSide) ? sideRun + 1 : 1;
+			lastSide = side;
+		}
+
+		return order;
+	}
+
+	std::size_t CountDecodes(const std::vector<Trial>& trials, const std::vector<std::size_t>& order, const std::size_t cacheFrames)
+	{
+		LruSimulation cache(cacheFrames);
+		std::size_t decodes = 0;
+
+		for (const auto i : order)
+		{
+			// a trial decodes each distinct file once even without a cache
+			auto keys = FileKeys(trials[i]);
+			std::sort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+			for (const auto& key : keys)
+			{
+				if (cache.Touch(key)) decodes++;
+			}
+		}
+
+		return decodes;
+	}
+
+	std::size_t CountSideRunViolations(const std::vector<Trial>& trials, const std::vector<std::size_t>& order, const int maxSameSideRun)
+	{
+		std::size_t violations = 0;
+
+		auto lastSide = Option::None;
+		auto sideRun = 0;
+
+		for (const auto i : order)
+		{
+			const auto side = trials[i].correctOption;
+			sideRun = (side == lastSide) ? sideRun + 1 : 1;
+			lastSide = side;
+
+			if (sideRun > maxSameSideRun) violations++;
+		}
+
+		return violations;
+	}
+
+	Report Apply(Run& run, Constraints constraints)
+	{
+		if (constraints.seed == 0)
+		{
+			constraints.seed = static_cast<std::uint32_t>(Hash(run.participant.id) ^ (run.session * 2654435761u));
+		}
+
+		std::vector<std::size_t> identity(run.trials.size());
+		for (std::size_t i = 0; i < identity.size(); i++) identity[i] = i;
+
+		const auto order = Optimize(run.trials, constraints);
+
+		Report report = {};
+		report.trials = run.trials.size();
+
+		// without a cache, every trial decodes its four stimuli, mono trials included
+		report.decodesBefore = 4 * run.trials.size();
+		report.decodesInOrder = CountDecodes(run.trials, identity, constraints.cacheFrames);
+		report.decodesAfter = CountDecodes(run.trials, order, constraints.cacheFrames);
+		report.bytesBefore = report.decodesBefore * FrameBytes;
+		report.bytesAfter = report.decodesAfter * FrameBytes;
+		report.sideRunViolations = CountSideRunViolations(run.trials, order, constraints.maxSameSideRun);
+
+		std::vector<Trial> reordered;
+		reordered.reserve(run.trials.size());
+		for (const auto i : order)
+		{
+			reordered.push_back(run.trials[i]);
+		}
+
+		run.trials = std::move(reordered);
+		return report;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Participant.h"
+
+namespace Experiment::TrialOrder
+{
+	/// Limits the optimizer must respect while reordering a Run
+	struct Constraints
+	{
+		/// Seed of the randomization; the same seed always yields the same order
+		std::uint32_t seed = 0;
+
+		/// Counterbalancing: never schedule more than this many consecutive trials with the same correct side
+		int maxSameSideRun = 3;
+
+		/// Number of decoded full frames that stay resident between trials
+		std::size_t cacheFrames = 8;
+
+		/// How many of the upcoming candidates are considered when picking the next trial
+		std::size_t lookahead = 64;
+	};
+
+	/// The expected amount of image I/O of a Run before and after reordering
+	struct Report
+	{
+		std::size_t trials = 0;
+
+		/// Decodes of the current load path, which reads all four stimuli of every trial
+		std::size_t decodesBefore = 0;
+
+		/// Decodes with a cache of `cacheFrames` frames, in the order of the session file
+		std::size_t decodesInOrder = 0;
+
+		/// Decodes with a cache of `cacheFrames` frames, in the optimized order
+		std::size_t decodesAfter = 0;
+
+		std::uintmax_t bytesBefore = 0;
+		std::uintmax_t bytesAfter = 0;
+
+		/// Trials of the optimized order which extend a run of one correct side beyond `maxSameSideRun`, as the greedy order
+		/// must when the trials left are all of that side
+		std::size_t sideRunViolations = 0;
+
+		[[nodiscard]] double Savings() const
+		{
+			return bytesBefore == 0 ? 0.0 : 1.0 - static_cast<double>(bytesAfter) / static_cast<double>(bytesBefore);
+		}
+	};
+
+	std::ostream& operator<<(std::ostream& os, const Report& r);
+
+	/// Returns the files a trial decodes, without touching the file system. Mono trials decode one file per side.
+	[[nodiscard]] std::vector<std::string> FileKeys(const Trial& trial);
+
+	/// Computes a permutation of `trials` which groups trials sharing originals and full frames
+	[[nodiscard]] std::vector<std::size_t> Optimize(const std::vector<Trial>& trials, const Constraints& constraints);
+
+	/// Simulates an LRU cache of `cacheFrames` decoded frames over `trials` visited in `order`, and returns the number of decodes
+	[[nodiscard]] std::size_t CountDecodes(const std::vector<Trial>& trials, const std::vector<std::size_t>& order, std::size_t cacheFrames);
+
+	/// Counts the trials of `trials` visited in `order` which extend a run of one correct side beyond `maxSameSideRun`
+	[[nodiscard]] std::size_t CountSideRunViolations(const std::vector<Trial>& trials, const std::vector<std::size_t>& order, int maxSameSideRun);
+
+	/// Reorders the trials of `run` in place, seeded by the participant and session, and reports the expected savings
+	Report Apply(Run& run, Constraints constraints = {});
+}
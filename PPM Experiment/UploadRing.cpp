@@ -0,0 +1,103 @@
+#include "UploadRing.h"
+#include "Trace.h"
+#include <algorithm>
+#include <ostream>
+
+namespace Experiment
+{
+	UploadRing::UploadRing(IUploadDevice& device, const std::size_t slots, const int width, const int height) :
+		m_device(device),
+		m_width(width),
+		m_height(height),
+		m_inFlight(slots, false),
+		m_charge(MemoryAccounting::Global(), MemoryTag::Staging, slots * width * height * sizeof(std::uint16_t) * 4)
+	{
+		m_device.CreateSlots(slots, width, height);
+
+		// a trial queues four stimuli; more are rare, and only grow the queue once
+		m_queue.reserve(std::max<std::size_t>(slots, 4));
+	}
+
+	void UploadRing::Enqueue(const ConstRgba16View source, void* target, std::shared_ptr<const void> owner, const int targetRow)
+	{
+		m_queue.push_back({ source, target, std::move(owner), targetRow });
+	}
+
+	std::ptrdiff_t UploadRing::FreeSlot() const
+	{
+		for (std::size_t i = 0; i < m_inFlight.size(); i++)
+		{
+			const auto slot = (m_next + i) % m_inFlight.size();
+			if (!m_inFlight[slot]) return static_cast<std::ptrdiff_t>(slot);
+		}
+
+		return -1;
+	}
+
+	void UploadRing::Reclaim()
+	{
+		for (std::size_t slot = 0; slot < m_inFlight.size(); slot++)
+		{
+			if (m_inFlight[slot] && m_device.IsComplete(slot))
+			{
+				m_inFlight[slot] = false;
+			}
+		}
+	}
+
+	void UploadRing::Flush()
+	{
+		TRACE_SCOPE("upload", "Flush uploads");
+
+		Reclaim();
+
+		for (const auto& request : m_queue)
+		{
+			const auto fits = request.source.width == m_width && request.source.height <= m_height;
+			const auto slot = fits ? FreeSlot() : -1;
+			const auto mapping = slot >= 0 ? m_device.Map(static_cast<std::size_t>(slot)) : IUploadDevice::Mapping{};
+
+			if (mapping.data == nullptr)
+			{
+				m_device.Update(request.target, request.source, request.targetRow);
+				m_statistics.direct++;
+				continue;
+			}
+
+			CopyPixels(request.source, Rgba16View(reinterpret_cast<std::uint16_t*>(mapping.data), request.source.width, request.source.height, mapping.rowPitch));
+
+			m_device.Unmap(static_cast<std::size_t>(slot));
+			m_device.CopyToTarget(static_cast<std::size_t>(slot), request.target, request.targetRow, request.source.height);
+
+			m_inFlight[static_cast<std::size_t>(slot)] = true;
+			m_next = static_cast<std::size_t>(slot) + 1;
+			m_statistics.staged++;
+		}
+
+		m_statistics.uploads += m_queue.size();
+		m_statistics.largestBatch = std::max(m_statistics.largestBatch, m_queue.size());
+		m_statistics.flushes++;
+
+		// keeps its capacity, so steady state flushes do not allocate
+		m_queue.clear();
+	}
+
+	std::size_t UploadRing::InFlight() const
+	{
+		return static_cast<std::size_t>(std::count(m_inFlight.begin(), m_inFlight.end(), true));
+	}
+
+	std::size_t UploadRing::FreeSlots()
+	{
+		Reclaim();
+
+		const auto free = m_inFlight.size() - InFlight();
+		return free > m_queue.size() ? free - m_queue.size() : 0;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const UploadRing::Statistics& s)
+	{
+		os << "uploads: " << s.uploads << " (staged: " << s.staged << ", direct: " << s.direct << "), flushes: " << s.flushes << ", largest batch: " << s.largestBatch;
+		return os;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+#include "ImageView.h"
+#include "MemoryAccounting.h"
+
+namespace Experiment
+{
+	/// The GPU operations the upload ring is built on, so that its scheduling can be driven by a mock device without a GPU.
+	/// Targets are textures of the device, passed through opaquely
+	class IUploadDevice
+	{
+	public:
+		/// A staging slot mapped for writing; `data` is null if mapping it would have waited on the GPU
+		struct Mapping
+		{
+			std::uint8_t* data = nullptr;
+			std::size_t rowPitch = 0;
+		};
+
+		virtual ~IUploadDevice() = default;
+
+		/// Creates `count` persistent staging slots of `width` by `height` RGBA16 pixels
+		virtual void CreateSlots(std::size_t count, int width, int height) = 0;
+
+		virtual Mapping Map(std::size_t slot) = 0;
+		virtual void Unmap(std::size_t slot) = 0;
+
+		/// Queues a copy of the first `rows` rows of `slot` into `target` at row `targetRow` on the GPU, followed by a fence
+		virtual void CopyToTarget(std::size_t slot, void* target, int targetRow, int rows) = 0;
+
+		/// Whether the fence after the last copy from `slot` has passed, without waiting for it
+		virtual bool IsComplete(std::size_t slot) = 0;
+
+		/// Uploads `source` into `target` at row `targetRow` through the driver, for when no staging slot is free
+		virtual void Update(void* target, ConstRgba16View source, int targetRow) = 0;
+	};
+
+	/// Uploads stimuli through a ring of persistent staging slots. Uploads are queued and submitted once per frame by Flush,
+	/// and a slot is only reused once its fence has passed, so the CPU never waits on the GPU. Not thread safe; used by the render thread
+	class UploadRing
+	{
+	public:
+		struct Statistics
+		{
+			std::size_t uploads = 0;
+
+			/// Uploads through a staging slot, and through the driver because every slot was busy or the size did not match
+			std::size_t staged = 0;
+			std::size_t direct = 0;
+
+			std::size_t flushes = 0;
+			std::size_t largestBatch = 0;
+		};
+
+		UploadRing(IUploadDevice& device, std::size_t slots, int width, int height);
+
+		/// Queues an upload of `source` into `target` at row `targetRow` for the next Flush. `owner`, if any, keeps the pixels alive until then.
+		/// Sources as wide as the slots and at most as high are staged; anything else is uploaded through the driver
+		void Enqueue(ConstRgba16View source, void* target, std::shared_ptr<const void> owner = nullptr, int targetRow = 0);
+
+		/// Submits every queued upload, reclaiming the slots whose copies have completed. Never waits on the GPU
+		void Flush();
+
+		/// Makes room for `uploads` queued at once, so that queueing them later does not allocate
+		void Reserve(std::size_t uploads) { m_queue.reserve(uploads); }
+
+		[[nodiscard]] std::size_t Pending() const { return m_queue.size(); }
+
+		/// The slots whose copies may still be running
+		[[nodiscard]] std::size_t InFlight() const;
+
+		/// The slots free for the uploads queued from now on, after reclaiming those whose copies have completed
+		[[nodiscard]] std::size_t FreeSlots();
+
+		[[nodiscard]] Statistics GetStatistics() const { return m_statistics; }
+
+	private:
+		struct Request
+		{
+			ConstRgba16View source;
+			void* target = nullptr;
+			std::shared_ptr<const void> owner;
+			int targetRow = 0;
+		};
+
+		void Reclaim();
+
+		/// A free slot after the last one used, or -1 if every slot is in flight
+		[[nodiscard]] std::ptrdiff_t FreeSlot() const;
+
+		IUploadDevice& m_device;
+		int m_width;
+		int m_height;
+
+		std::vector<bool> m_inFlight;
+		MemoryAccounting::Charge m_charge;
+		std::size_t m_next = 0;
+
+		std::vector<Request> m_queue;
+
+		Statistics m_statistics;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const UploadRing::Statistics& s);
+}
@@ -0,0 +1,160 @@
+#include "UploadScheduler.h"
+#include "Trace.h"
+#include <algorithm>
+#include <ostream>
+
+namespace Experiment
+{
+	UploadScheduler::UploadScheduler(UploadRing& ring, const Settings settings, Now now) :
+		m_ring(ring),
+		m_settings(settings),
+		m_now(std::move(now)),
+		m_bytesPerSecond(settings.bytesPerSecond)
+	{
+		// the stimuli of two trials
+		m_jobs.reserve(8);
+	}
+
+	void UploadScheduler::Schedule(const ConstRgba16View source, void* target, const Clock::time_point deadline, std::shared_ptr<const void> owner)
+	{
+		// a newer upload into the same texture supersedes what is left of the older one
+		m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(), [target](const Job& job) { return job.target == target; }), m_jobs.end());
+
+		const auto position = std::upper_bound(m_jobs.begin(), m_jobs.end(), deadline, [](const Clock::time_point d, const Job& job) { return d < job.deadline; });
+		m_jobs.insert(position, { source, target, deadline, std::move(owner), 0 });
+
+		// a frame which falls behind, or Finish, queues every band left at once; the ring makes room for them now, on the trial
+		// switch, rather than growing its queue during a frame
+		std::size_t bands = 0;
+		for (const auto& job : m_jobs)
+		{
+			bands += static_cast<std::size_t>((job.source.height - job.nextRow + m_settings.bandRows - 1) / m_settings.bandRows);
+		}
+
+		m_ring.Reserve(bands);
+
+		m_statistics.jobs++;
+	}
+
+	std::size_t UploadScheduler::QueueBand(Job& job)
+	{
+		const auto rows = std::min(m_settings.bandRows, job.source.height - job.nextRow);
+
+		m_ring.Enqueue(job.source.Crop(0, job.nextRow, job.source.width, rows), job.target, job.owner, job.nextRow);
+		job.nextRow += rows;
+
+		m_statistics.bands++;
+
+		return static_cast<std::size_t>(rows) * job.source.width * ConstRgba16View::PixelBytes;
+	}
+
+	void UploadScheduler::Run(const Clock::duration slack)
+	{
+		TRACE_SCOPE("upload", "Schedule uploads");
+
+		const auto start = m_now();
+
+		const auto budget = std::max(0.0, std::chrono::duration<double>(slack).count()) * m_bytesPerSecond;
+		auto freeSlots = m_ring.FreeSlots();
+
+		std::size_t spent = 0;
+		auto exhausted = false;
+		auto urgent = false;
+
+		for (auto& job : m_jobs)
+		{
+			// the rows which keep the job on schedule, if the remaining frames before its deadline each upload as many
+			const auto framesLeft = std::max<long long>(1, (job.deadline - start) / m_settings.framePeriod);
+			const auto remaining = job.source.height - job.nextRow;
+			const auto required = static_cast<int>((remaining + framesLeft - 1) / framesLeft);
+
+			for (auto rows = 0; job.nextRow < job.source.height; )
+			{
+				const auto mustUpload = rows < required;
+				const auto bandBytes = static_cast<std::size_t>(std::min(m_settings.bandRows, job.source.height - job.nextRow)) * job.source.width * ConstRgba16View::PixelBytes;
+
+				if (!mustUpload && (exhausted || freeSlots == 0 || static_cast<double>(spent + bandBytes) > budget))
+				{
+					exhausted = true;
+					break;
+				}
+
+				const auto before = job.nextRow;
+				spent += QueueBand(job);
+				rows += job.nextRow - before;
+
+				freeSlots -= freeSlots > 0 ? 1 : 0;
+				urgent |= static_cast<double>(spent) > budget;
+			}
+		}
+
+		Submit(spent, start, urgent);
+	}
+
+	void UploadScheduler::Finish()
+	{
+		TRACE_SCOPE("upload", "Finish uploads");
+
+		const auto start = m_now();
+
+		std::size_t bytes = 0;
+		for (auto& job : m_jobs)
+		{
+			while (job.nextRow < job.source.height)
+			{
+				bytes += QueueBand(job);
+			}
+		}
+
+		Submit(bytes, start, bytes > 0);
+	}
+
+	void UploadScheduler::Submit(const std::size_t bytes, const Clock::time_point start, const bool urgent)
+	{
+		m_ring.Flush();
+
+		const auto end = m_now();
+		const auto seconds = std::chrono::duration<double>(end - start).count();
+
+		if (bytes > 0)
+		{
+			// a moving average, so that one slow frame does not starve the next ones
+			if (seconds > 0.0)
+			{
+				m_bytesPerSecond = 0.8 * m_bytesPerSecond + 0.2 * (static_cast<double>(bytes) / seconds);
+			}
+
+			m_statistics.frames++;
+			m_statistics.urgentFrames += urgent ? 1 : 0;
+			m_statistics.longestFrame = std::max(m_statistics.longestFrame, end - start);
+			m_statistics.totalTime += end - start;
+		}
+
+		const auto finished = std::remove_if(m_jobs.begin(), m_jobs.end(), [&](const Job& job)
+			{
+				if (job.nextRow < job.source.height) return false;
+
+				m_statistics.missedDeadlines += end > job.deadline ? 1 : 0;
+				return true;
+			});
+
+		m_jobs.erase(finished, m_jobs.end());
+	}
+
+	UploadScheduler::Statistics UploadScheduler::GetStatistics() const
+	{
+		auto statistics = m_statistics;
+		statistics.bytesPerSecond = m_bytesPerSecond;
+
+		return statistics;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const UploadScheduler::Statistics& s)
+	{
+		os << "jobs: " << s.jobs << ", bands: " << s.bands << ", missed deadlines: " << s.missedDeadlines
+			<< ", frames: " << s.frames << " (urgent: " << s.urgentFrames << "), longest frame: "
+			<< std::chrono::duration<double, std::milli>(s.longestFrame).count() << " ms, "
+			<< static_cast<long long>(s.bytesPerSecond / (1024 * 1024)) << " MB/s";
+		return os;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+#include "UploadRing.h"
+
+namespace Experiment
+{
+	/// Spreads uploads over frames in bands of rows, so that they only spend the slack each frame leaves, earliest deadline first.
+	/// A job gets more than the slack only when it would otherwise miss its deadline. The clock is injected, so that the
+	/// budgeting runs against a simulated clock. Not thread safe; used by the render thread
+	class UploadScheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+		using Now = std::function<Clock::time_point()>;
+
+		struct Settings
+		{
+			/// The rows of each band; about 1 MB of a stimulus
+			int bandRows = 100;
+
+			/// The time between the frames which run the scheduler, over which jobs are spread until their deadlines
+			Clock::duration framePeriod = std::chrono::milliseconds(100);
+
+			/// The upload throughput assumed until it has been measured
+			double bytesPerSecond = 2e9;
+		};
+
+		struct Statistics
+		{
+			std::size_t jobs = 0;
+			std::size_t bands = 0;
+			std::size_t missedDeadlines = 0;
+
+			/// Frames which uploaded anything, and those of them which spent more than their slack to meet a deadline
+			std::size_t frames = 0;
+			std::size_t urgentFrames = 0;
+
+			Clock::duration longestFrame = {};
+
+			/// The time spent uploading, over every frame
+			Clock::duration totalTime = {};
+			double bytesPerSecond = 0.0;
+		};
+
+		UploadScheduler(UploadRing& ring, Settings settings, Now now = Clock::now);
+
+		/// Schedules an upload of `source` into `target`, to be complete by `deadline`. `owner`, if any, keeps the pixels alive until then
+		void Schedule(ConstRgba16View source, void* target, Clock::time_point deadline, std::shared_ptr<const void> owner = nullptr);
+
+		/// Uploads bands within `slack`, or more if a deadline requires it, and flushes the ring
+		void Run(Clock::duration slack);
+
+		/// Uploads everything still scheduled now, for when it is about to be drawn
+		void Finish();
+
+		[[nodiscard]] bool IsIdle() const { return m_jobs.empty(); }
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		struct Job
+		{
+			ConstRgba16View source;
+			void* target = nullptr;
+			Clock::time_point deadline;
+			std::shared_ptr<const void> owner;
+
+			/// The first row not uploaded yet
+			int nextRow = 0;
+		};
+
+		/// Queues the next band of `job` and returns its bytes
+		std::size_t QueueBand(Job& job);
+
+		/// Flushes the ring, learns the throughput from how long it took, and retires the finished jobs
+		void Submit(std::size_t bytes, Clock::time_point start, bool urgent);
+
+		UploadRing& m_ring;
+		Settings m_settings;
+		Now m_now;
+
+		/// In order of deadline
+		std::vector<Job> m_jobs;
+
+		double m_bytesPerSecond;
+
+		Statistics m_statistics;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const UploadScheduler::Statistics& s);
+}
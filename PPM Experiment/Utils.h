@@ -2,11 +2,19 @@
 #include <string>
 #include <filesystem>
 #include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <vector>
 
 namespace std::filesystem
 {
 	static path home()
 	{
+#ifdef _WIN32
 		char* buf = nullptr;
 		size_t sz = 0;
 
@@ -18,6 +26,10 @@ namespace std::filesystem
 		}
 
 		return "C:/";
+#else
+		const auto* home = std::getenv("HOME");
+		return home != nullptr ? home : "/";
+#endif
 	}
 	
 	static path parent_directory(const path& child, const int levels = 1)
@@ -34,6 +46,7 @@ namespace std::filesystem
 
 	static path cwd()
 	{
+#ifdef _WIN32
 		wchar_t buffer[MAX_PATH];
 		GetModuleFileName(nullptr, buffer, MAX_PATH);
 		
@@ -41,6 +54,9 @@ namespace std::filesystem
 		const path exePath(ws.begin(), ws.end());
 
 		return parent_directory(exePath, 3) / "PPM Experiment";
+#else
+		return current_path();
+#endif
 	}
 }
 
@@ -51,7 +67,11 @@ namespace Utils
 	static std::string FormatTime(const std::string& format, time_t time)
 	{
 		struct tm buffer{};
+#ifdef _WIN32
 		localtime_s(&buffer, &time);
+#else
+		localtime_r(&time, &buffer);
+#endif
 
 		char formatted[64];
 		strftime(formatted, sizeof(formatted), format.c_str(), &buffer);
@@ -67,6 +87,7 @@ namespace Utils
 
 	static void FatalError(const std::string& message)
 	{
+#ifdef _WIN32
 		const auto result = MessageBoxA(
 			nullptr,
 			message.c_str(),
@@ -78,6 +99,10 @@ namespace Utils
 		{
 			exit(1);
 		}
+#else
+		std::cerr << "Fatal Error: " << message << std::endl;
+		exit(1);
+#endif
 	}
 
 	/// A pair of one type of element representing data associated with sidedness
@@ -159,33 +184,14 @@ namespace Debug
 {
 	class Console {
 	public:
+		/// Writes `s` to the debugger as it is; messages are logged through Log, which ends here (see Log.h)
 		static void log(const std::string& s)
 		{
+#ifdef _WIN32
 			OutputDebugStringA(s.c_str());
-		}
-
-		static void log(const char* format, ...)
-		{
-			char buf[1024];
-			va_list args;
-			va_start(args, format);
-
-			vsprintf_s(buf, format, args);
-
-			va_end(args);
-			OutputDebugStringA(buf);
-		}
-
-		static void log(const wchar_t* format, ...)
-		{
-			wchar_t buf[2048];
-			va_list args;
-			va_start(args, format);
-
-			vswprintf(buf, sizeof(buf), format, args);
-
-			va_end(args);
-			OutputDebugStringW(buf);
+#else
+			std::fputs(s.c_str(), stderr);
+#endif
 		}
 	};
 }
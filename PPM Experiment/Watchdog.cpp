@@ -0,0 +1,154 @@
+#include "Watchdog.h"
+#include "Trace.h"
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <utility>
+
+namespace Experiment
+{
+	Watchdog::Watchdog(Settings settings, std::function<void(const Stall&)> onStall) :
+		m_settings(std::move(settings)),
+		m_onStall(std::move(onStall))
+	{
+		m_thread = std::thread([this] { Run(); });
+	}
+
+	Watchdog::~Watchdog()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running = false;
+		}
+
+		m_wake.notify_all();
+		m_thread.join();
+	}
+
+	void Watchdog::Beat()
+	{
+		const auto now = Clock::now().time_since_epoch().count();
+
+		if (m_beats.load(std::memory_order_relaxed) == 0)
+		{
+			m_watched.store(Trace::CurrentThread(), std::memory_order_relaxed);
+		}
+		else
+		{
+			const auto gap = now - m_lastBeat.load(std::memory_order_relaxed);
+			if (gap > m_longestGap.load(std::memory_order_relaxed)) m_longestGap.store(gap, std::memory_order_relaxed);
+		}
+
+		m_lastBeat.store(now, std::memory_order_relaxed);
+		m_beats.fetch_add(1, std::memory_order_release);
+	}
+
+	Watchdog::Statistics Watchdog::GetStatistics() const
+	{
+		Statistics s;
+		s.beats = m_beats.load(std::memory_order_relaxed);
+		s.stalls = m_stalls.load(std::memory_order_relaxed);
+		s.snapshots = m_snapshots.load(std::memory_order_relaxed);
+		s.longestGap = Clock::duration(m_longestGap.load(std::memory_order_relaxed));
+		return s;
+	}
+
+	void Watchdog::Run()
+	{
+		TRACE_THREAD("Watchdog");
+
+		// the heartbeats of the last stall reported
+		std::size_t reported = 0;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (m_running)
+		{
+			const auto beats = m_beats.load(std::memory_order_acquire);
+			if (beats == 0)
+			{
+				m_wake.wait_for(lock, m_settings.deadline);
+				continue;
+			}
+
+			const auto last = Clock::time_point(Clock::duration(m_lastBeat.load(std::memory_order_relaxed)));
+			const auto now = Clock::now();
+
+			if (now < last + m_settings.deadline)
+			{
+				// a heartbeat meanwhile moves the deadline, which the next pass sees
+				m_wake.wait_until(lock, last + m_settings.deadline);
+				continue;
+			}
+
+			if (beats == reported)
+			{
+				// still stalled, and already reported
+				m_wake.wait_for(lock, m_settings.deadline);
+				continue;
+			}
+
+			reported = beats;
+
+			lock.unlock();
+			const auto stall = Snapshot(beats, now - last);
+			if (m_onStall) m_onStall(stall);
+			lock.lock();
+		}
+	}
+
+	Watchdog::Stall Watchdog::Snapshot(const std::size_t frame, const Clock::duration late)
+	{
+		TRACE_INSTANT("watchdog", "Stall");
+
+		Stall stall;
+		stall.frame = frame;
+		stall.late = late;
+
+		const auto open = Trace::GetOpenScope(m_watched.load(std::memory_order_relaxed));
+		if (open.category) stall.stage = open.category;
+		if (open.name) stall.scope = open.name;
+
+		const auto index = m_stalls.fetch_add(1, std::memory_order_relaxed) + 1;
+		if (m_settings.directory.empty() || index > m_settings.maxSnapshots) return stall;
+
+		std::ostringstream milliseconds;
+		milliseconds << std::chrono::duration<double, std::milli>(late).count();
+
+		// frozen in memory first, so that the render thread, once it resumes, does not overwrite the events of the stall
+		std::ostringstream trace;
+		Trace::Write(trace, m_settings.window, {
+			{ "stage", stall.stage },
+			{ "scope", stall.scope },
+			{ "frame", std::to_string(frame) },
+			{ "lateMilliseconds", milliseconds.str() } });
+
+		// a snapshot lost to a full disk must not take down the session it was meant to explain
+		try
+		{
+			std::filesystem::create_directories(m_settings.directory);
+
+			const auto path = m_settings.directory / ("Stall" + std::to_string(index) + ".json");
+			std::ofstream file(path, std::ios::binary);
+			if (file << trace.str())
+			{
+				stall.snapshot = path;
+				m_snapshots.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		catch (const std::filesystem::filesystem_error&)
+		{
+		}
+
+		return stall;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const Watchdog::Statistics& s)
+	{
+		const auto milliseconds = std::chrono::duration<double, std::milli>(s.longestGap).count();
+
+		os << "frames: " << s.beats << ", stalls: " << s.stalls << ", snapshots: " << s.snapshots
+			<< ", longest gap between frames: " << milliseconds << " ms";
+		return os;
+	}
+}
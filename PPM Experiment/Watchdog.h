@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Experiment
+{
+	/// Watches the heartbeats of the render thread, one per presented frame, from a thread of its own. When a frame is later
+	/// than `deadline`, it freezes the last `window` of the trace, with the scope the render thread is in (its stage: load,
+	/// upload, present, input...), and writes it to `directory` as a Chrome trace, so that a stutter a participant reports
+	/// can be explained afterwards. Each late frame is reported once, however long it stalls
+	class Watchdog
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Settings
+		{
+			/// The longest time allowed between heartbeats
+			Clock::duration deadline = std::chrono::milliseconds(150);
+
+			/// The trace history each snapshot keeps
+			Clock::duration window = std::chrono::seconds(5);
+
+			/// Where snapshots are written; none are if empty
+			std::filesystem::path directory;
+
+			/// Later stalls are only counted, so that a session which keeps stalling does not fill the disk
+			std::size_t maxSnapshots = 20;
+		};
+
+		struct Stall
+		{
+			/// The heartbeats before the stall
+			std::size_t frame = 0;
+
+			/// The time since the last heartbeat when the stall was detected
+			Clock::duration late = {};
+
+			/// The innermost scope the render thread was in, empty if it was in none or tracing is disabled
+			std::string stage;
+			std::string scope;
+
+			/// Empty if no snapshot was written
+			std::filesystem::path snapshot;
+		};
+
+		struct Statistics
+		{
+			std::size_t beats = 0;
+			std::size_t stalls = 0;
+			std::size_t snapshots = 0;
+
+			/// The longest time between consecutive heartbeats
+			Clock::duration longestGap = {};
+		};
+
+		/// Starts the thread, which only checks once the first heartbeat arrived. `onStall` is called on the watchdog thread
+		explicit Watchdog(Settings settings, std::function<void(const Stall&)> onStall = {});
+
+		/// Stops the thread
+		~Watchdog();
+
+		Watchdog(const Watchdog&) = delete;
+		Watchdog& operator=(const Watchdog&) = delete;
+
+		/// Called by the watched thread, and only by it, once per frame
+		void Beat();
+
+		/// Safe to call while running; the counters are read one at a time
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		void Run();
+
+		/// Freezes the trace and writes it with the stage of the watched thread
+		Stall Snapshot(std::size_t frame, Clock::duration late);
+
+		const Settings m_settings;
+		std::function<void(const Stall&)> m_onStall;
+
+		std::atomic<Clock::rep> m_lastBeat{ 0 };
+		std::atomic<std::size_t> m_beats{ 0 };
+		std::atomic<Clock::rep> m_longestGap{ 0 };
+
+		/// The trace thread of the watched thread, set by its first heartbeat
+		std::atomic<std::size_t> m_watched{ 0 };
+
+		std::atomic<std::size_t> m_stalls{ 0 };
+		std::atomic<std::size_t> m_snapshots{ 0 };
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		bool m_running = true;
+
+		std::thread m_thread;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const Watchdog::Statistics& s);
+}
@@ -66,7 +66,6 @@ processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
 #include <PostProcess.h>
 #include <SimpleMath.h>
 #include <opencv2/opencv.hpp>
-#include <opencv2/core/directx.hpp>
 #include <Audio.h>
 #include <commctrl.h>
 
@@ -4,6 +4,7 @@
 
 #include "pch.h"
 #include "Game.h"
+#include "../PPM Experiment/Trace.h"
 #include <filesystem>
 #include <utility>
 #include "Controller.h"
@@ -111,6 +112,7 @@ namespace Experiment
 		Clear();
 
 		m_deviceResources->PIXBeginEvent(L"Render");
+		TRACE_BEGIN("render", "Render");
 
 		m_spriteBatch->Begin();
 
@@ -141,6 +143,7 @@ namespace Experiment
 
 		m_spriteBatch->End();
 
+		TRACE_END();
 		m_deviceResources->PIXEndEvent();
 
 		auto renderTarget = m_deviceResources->GetRenderTargetView();
@@ -151,7 +154,10 @@ namespace Experiment
 		ID3D11ShaderResourceView* nullsrv[] = { nullptr };
 		context->PSSetShaderResources(0, 1, nullsrv);
 
-		m_deviceResources->ThreadPresent();
+		{
+			TRACE_SCOPE("present", "Present");
+			m_deviceResources->ThreadPresent();
+		}
 
 		m_deviceResources->DiscardView();
 	}
@@ -161,6 +167,7 @@ namespace Experiment
 	void Game::Clear()
 	{
 		m_deviceResources->PIXBeginEvent(L"Clear");
+		TRACE_SCOPE("render", "Clear");
 
 		// Clear the views.
 		auto context = m_deviceResources->GetD3DDeviceContext();